@@ -0,0 +1,79 @@
+/*
+ Copyright (C) 2010-2012 Kristian Duske
+ 
+ This file is part of TrenchBroom.
+ 
+ TrenchBroom is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+ 
+ TrenchBroom is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ 
+ You should have received a copy of the GNU General Public License
+ along with TrenchBroom.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef TrenchBroom_BrushTask_h
+#define TrenchBroom_BrushTask_h
+
+#include "Model/Brush.h"
+#include "Model/BrushGeometry.h"
+#include "Model/BrushTypes.h"
+#include "Model/Entity.h"
+#include "Model/EntityTypes.h"
+#include "Utility/SpinLock.h"
+#include "Utility/WorkerPool.h"
+
+namespace TrenchBroom {
+    namespace Controller {
+        /*
+         * Base class for commands that change many brushes independently of each other. The brushes are distributed
+         * over the worker pool, and each worker builds its geometry in a private arena. Notifications and other changes
+         * to shared state must happen on the main thread before or after run() is called. The entities of the changed
+         * brushes are collected by the workers and invalidated by run() once all workers have finished.
+         */
+        class BrushTask : public Utility::ParallelTask {
+        protected:
+            // changing a brush takes a few microseconds, so small selections are not worth starting threads for
+            static const size_t MinBrushesPerThread = 64;
+            
+            const Model::BrushList& m_brushes;
+        private:
+            Utility::SpinLock m_entitiesLock;
+            Model::EntitySet m_entities;
+        public:
+            BrushTask(const Model::BrushList& brushes) :
+            m_brushes(brushes) {}
+            
+            void beginThread() {
+                Model::BrushGeometry::beginArena();
+                Model::Brush::deferEntityInvalidation(new Model::EntitySet());
+            }
+            
+            void endThread() {
+                Model::EntitySet* entities = Model::Brush::deferEntityInvalidation(NULL);
+                {
+                    Utility::SpinLock::Guard guard(m_entitiesLock);
+                    m_entities.insert(entities->begin(), entities->end());
+                }
+                delete entities;
+                Model::BrushGeometry::endArena();
+            }
+            
+            inline void run() {
+                Utility::WorkerPool::run(*this, m_brushes.size(), MinBrushesPerThread);
+                
+                Model::EntitySet::const_iterator it, end;
+                for (it = m_entities.begin(), end = m_entities.end(); it != end; ++it)
+                    (*it)->invalidateGeometry();
+                m_entities.clear();
+            }
+        };
+    }
+}
+
+#endif
@@ -23,12 +23,13 @@
 #include "Model/BrushTypes.h"
 #include "Model/EntityTypes.h"
 #include "Model/MapDocument.h"
+#include "Utility/CommandProcessor.h"
 
 #include <wx/cmdproc.h>
 
 namespace TrenchBroom {
     namespace Controller {
-        class Command : public wxCommand {
+        class Command : public wxCommand, public SizedCommand {
         public:
             typedef enum {
                 LoadMap,
@@ -99,6 +100,11 @@ namespace TrenchBroom {
                 return m_state;
             }
             
+            // only commands that keep a lot of undo information count towards the memory limit of the undo history
+            virtual size_t memorySize() const {
+                return 0;
+            }
+            
             bool Do() {
                 State previous = m_state;
                 m_state = Doing;
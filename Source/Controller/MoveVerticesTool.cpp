@@ -304,8 +304,8 @@ namespace TrenchBroom {
             Preferences::PreferenceManager& prefs = Preferences::PreferenceManager::preferences();
             const Color& textColor = prefs.getColor(Preferences::InfoOverlayTextColor);
             const Color& backgroundColor = prefs.getColor(Preferences::InfoOverlayBackgroundColor);
-            Renderer::ShaderProgram& textShader = renderContext.shaderManager().shaderProgram(Renderer::Shaders::TextShader);
-            Renderer::ShaderProgram& backgroundShader = renderContext.shaderManager().shaderProgram(Renderer::Shaders::TextBackgroundShader);
+            Renderer::ShaderProgram& textShader = renderContext.shaderManager().shaderProgram(Renderer::Shaders::TextLabelShader);
+            Renderer::ShaderProgram& backgroundShader = renderContext.shaderManager().shaderProgram(Renderer::Shaders::TextLabelBackgroundShader);
             
             glDisable(GL_DEPTH_TEST);
             m_textRenderer->render(renderContext, m_textFilter, textShader, textColor, backgroundShader, backgroundColor);
@@ -19,21 +19,29 @@
 
 #include "RebuildBrushGeometryCommand.h"
 
+#include "Controller/BrushTask.h"
 #include "Model/Brush.h"
 
 #include <cassert>
 
 namespace TrenchBroom {
     namespace Controller {
+        class RebuildBrushGeometryTask : public BrushTask {
+        public:
+            RebuildBrushGeometryTask(const Model::BrushList& brushes) :
+            BrushTask(brushes) {}
+            
+            void operator()(size_t index) {
+                m_brushes[index]->rebuildGeometry();
+            }
+        };
+        
         bool RebuildBrushGeometryCommand::performDo() {
             makeSnapshots(m_brushes);
             document().brushesWillChange(m_brushes);
             
-            Model::BrushList::const_iterator it, end;
-            for (it = m_brushes.begin(), end = m_brushes.end(); it != end; ++it) {
-                Model::Brush& brush = **it;
-                brush.rebuildGeometry();
-            }
+            RebuildBrushGeometryTask task(m_brushes);
+            task.run();
             document().brushesDidChange(m_brushes);
             return true;
         }
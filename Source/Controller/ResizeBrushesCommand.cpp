@@ -19,27 +19,74 @@
 
 #include "ResizeBrushesCommand.h"
 
+#include "Controller/BrushTask.h"
 #include "Model/Brush.h"
 #include "Model/Face.h"
 
+#include <algorithm>
+#include <cassert>
+#include <map>
+
 namespace TrenchBroom {
     namespace Controller {
-        bool ResizeBrushesCommand::performDo() {
-            Model::FaceList::const_iterator faceIt, faceEnd;
-            for (faceIt = m_faces.begin(), faceEnd = m_faces.end(); faceIt != faceEnd; ++faceIt) {
-                Model::Face& face = **faceIt;
-                Model::Brush& brush = *face.brush();
-                if (!brush.canMoveBoundary(face, m_delta))
-                    return false;
+        class CanResizeBrushesTask : public BrushTask {
+        private:
+            const std::vector<Model::FaceList>& m_brushFaces;
+            const Vec3f& m_delta;
+            std::vector<char>& m_canResize; // not std::vector<bool> because the workers must write to separate bytes
+        public:
+            CanResizeBrushesTask(const Model::BrushList& brushes, const std::vector<Model::FaceList>& brushFaces, const Vec3f& delta, std::vector<char>& canResize) :
+            BrushTask(brushes),
+            m_brushFaces(brushFaces),
+            m_delta(delta),
+            m_canResize(canResize) {}
+            
+            void operator()(size_t index) {
+                const Model::Brush& brush = *m_brushes[index];
+                const Model::FaceList& faces = m_brushFaces[index];
+                
+                m_canResize[index] = 1;
+                for (size_t i = 0; i < faces.size(); i++) {
+                    if (!brush.canMoveBoundary(*faces[i], m_delta)) {
+                        m_canResize[index] = 0;
+                        return;
+                    }
+                }
             }
+        };
+        
+        class ResizeBrushesTask : public BrushTask {
+        private:
+            const std::vector<Model::FaceList>& m_brushFaces;
+            const Vec3f m_delta;
+            bool m_lockTextures;
+        public:
+            ResizeBrushesTask(const Model::BrushList& brushes, const std::vector<Model::FaceList>& brushFaces, const Vec3f& delta, bool lockTextures) :
+            BrushTask(brushes),
+            m_brushFaces(brushFaces),
+            m_delta(delta),
+            m_lockTextures(lockTextures) {}
+            
+            void operator()(size_t index) {
+                Model::Brush& brush = *m_brushes[index];
+                const Model::FaceList& faces = m_brushFaces[index];
+                for (size_t i = 0; i < faces.size(); i++)
+                    brush.moveBoundary(*faces[i], m_delta, m_lockTextures);
+            }
+        };
+        
+        bool ResizeBrushesCommand::performDo() {
+            std::vector<char> canResize(m_brushes.size(), 0);
+            CanResizeBrushesTask canResizeTask(m_brushes, m_brushFaces, m_delta, canResize);
+            canResizeTask.run();
+            
+            if (std::find(canResize.begin(), canResize.end(), 0) != canResize.end())
+                return false;
             
             document().brushesWillChange(m_brushes);
             
-            for (faceIt = m_faces.begin(), faceEnd = m_faces.end(); faceIt != faceEnd; ++faceIt) {
-                Model::Face& face = **faceIt;
-                Model::Brush& brush = *face.brush();
-                brush.moveBoundary(face, m_delta, m_lockTextures);
-            }
+            ResizeBrushesTask task(m_brushes, m_brushFaces, m_delta, m_lockTextures);
+            task.run();
             
             document().brushesDidChange(m_brushes);
             return true;
@@ -47,42 +94,43 @@ namespace TrenchBroom {
         
         bool ResizeBrushesCommand::performUndo() {
             document().brushesWillChange(m_brushes);
-            Model::FaceList::const_iterator faceIt, faceEnd;
-
-            for (faceIt = m_faces.begin(), faceEnd = m_faces.end(); faceIt != faceEnd; ++faceIt) {
-                Model::Face& face = **faceIt;
-                Model::Brush& brush = *face.brush();
-                
-                assert(brush.canMoveBoundary(face, -m_delta));
-                brush.moveBoundary(face, -m_delta, m_lockTextures);
-            }
+            
+            ResizeBrushesTask task(m_brushes, m_brushFaces, -m_delta, m_lockTextures);
+            task.run();
             
             document().brushesDidChange(m_brushes);
             return true;
         }
 
-        ResizeBrushesCommand::ResizeBrushesCommand(Model::MapDocument& document, const wxString& name, const Model::FaceList& faces, const Model::BrushList& brushes, const Vec3f& delta, bool lockTextures) :
+        ResizeBrushesCommand::ResizeBrushesCommand(Model::MapDocument& document, const wxString& name, const Model::BrushList& brushes, const std::vector<Model::FaceList>& brushFaces, const Vec3f& delta, bool lockTextures) :
         DocumentCommand(Command::ResizeBrushes, document, true, name, true),
-        m_faces(faces),
         m_brushes(brushes),
+        m_brushFaces(brushFaces),
         m_delta(delta),
         m_lockTextures(lockTextures) {}
 
         ResizeBrushesCommand* ResizeBrushesCommand::resizeBrushes(Model::MapDocument& document, const Model::FaceList& faces, const Vec3f& delta, bool lockTextures) {
-            Model::BrushSet brushSet;
+            typedef std::map<Model::Brush*, size_t> BrushIndexMap;
+            
+            BrushIndexMap brushIndices;
             Model::BrushList brushList;
+            std::vector<Model::FaceList> brushFaces;
             Model::FaceList::const_iterator faceIt, faceEnd;
             for (faceIt = faces.begin(), faceEnd = faces.end(); faceIt != faceEnd; ++faceIt) {
                 Model::Face* face = *faceIt;
                 Model::Brush* brush = face->brush();
-                if (brushSet.insert(brush).second)
+                std::pair<BrushIndexMap::iterator, bool> insertResult = brushIndices.insert(BrushIndexMap::value_type(brush, brushList.size()));
+                if (insertResult.second) {
                     brushList.push_back(brush);
+                    brushFaces.push_back(Model::FaceList());
+                }
+                brushFaces[insertResult.first->second].push_back(face);
             }
             
-            assert(brushSet.size() == brushList.size());
+            assert(brushIndices.size() == brushList.size());
             
             wxString name = brushList.size() == 1 ? wxT("Resize Brush") : wxT("Resize Brushes");
-            return new ResizeBrushesCommand(document, name, faces, brushList, delta, lockTextures);
+            return new ResizeBrushesCommand(document, name, brushList, brushFaces, delta, lockTextures);
         }
     }
 }
@@ -25,21 +25,23 @@
 #include "Model/FaceTypes.h"
 #include "Utility/VecMath.h"
 
+#include <vector>
+
 using namespace TrenchBroom::VecMath;
 
 namespace TrenchBroom {
     namespace Controller {
         class ResizeBrushesCommand : public DocumentCommand {
         protected:
-            const Model::FaceList m_faces;
             const Model::BrushList m_brushes;
+            const std::vector<Model::FaceList> m_brushFaces; // the faces to move for each brush
             const Vec3f m_delta;
             const bool m_lockTextures;
             
             bool performDo();
             bool performUndo();
 
-            ResizeBrushesCommand(Model::MapDocument& document, const wxString& name, const Model::FaceList& faces, const Model::BrushList& brushes, const Vec3f& delta, bool lockTextures);
+            ResizeBrushesCommand(Model::MapDocument& document, const wxString& name, const Model::BrushList& brushes, const std::vector<Model::FaceList>& brushFaces, const Vec3f& delta, bool lockTextures);
         public:
             static ResizeBrushesCommand* resizeBrushes(Model::MapDocument& document, const Model::FaceList& faces, const Vec3f& delta, bool lockTextures);
         };
@@ -19,24 +19,36 @@
 
 #include "SnapVerticesCommand.h"
 
+#include "Controller/BrushTask.h"
 #include "Model/Brush.h"
 #include "Utility/Grid.h"
 
 namespace TrenchBroom {
     namespace Controller {
-        bool SnapVerticesCommand::performDo() {
+        class SnapVerticesTask : public BrushTask {
+        private:
+            unsigned int m_snapTo;
+        public:
+            SnapVerticesTask(const Model::BrushList& brushes, unsigned int snapTo) :
+            BrushTask(brushes),
+            m_snapTo(snapTo) {}
             
-            makeSnapshots(m_brushes);
-            document().brushesWillChange(m_brushes);
-            
-            Model::BrushList::const_iterator it, end;
-            for (it = m_brushes.begin(), end = m_brushes.end(); it != end; ++it) {
-                Model::Brush& brush = **it;
+            void operator()(size_t index) {
+                Model::Brush& brush = *m_brushes[index];
                 if (m_snapTo == 0)
                     brush.correct(0.01f);
                 else
                     brush.snap(m_snapTo);
             }
+        };
+        
+        bool SnapVerticesCommand::performDo() {
+            
+            makeSnapshots(m_brushes);
+            document().brushesWillChange(m_brushes);
+            
+            SnapVerticesTask task(m_brushes, m_snapTo);
+            task.run();
             
             document().brushesDidChange(m_brushes);
             return true;
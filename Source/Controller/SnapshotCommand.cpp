@@ -19,16 +19,60 @@
 
 #include "SnapshotCommand.h"
 
+#include "Controller/BrushTask.h"
 #include "Model/Brush.h"
 #include "Model/Entity.h"
 #include "Model/EntityDefinitionManager.h"
 #include "Model/Face.h"
+#include "Model/TextureManager.h"
 #include "Utility/Map.h"
+#include "Utility/SpinLock.h"
+#include "Utility/String.h"
 
+#include <algorithm>
 #include <cassert>
 
 namespace TrenchBroom {
     namespace Controller {
+        /*
+         * Maps texture names to small IDs so that face snapshots do not need to keep a copy of the name. Snapshots are
+         * made on worker threads, so access is guarded by a lock. Names are never removed.
+         */
+        class TextureNames {
+        private:
+            typedef std::map<String, unsigned int> IdMap;
+            
+            static Utility::SpinLock& lock() {
+                static Utility::SpinLock lock;
+                return lock;
+            }
+            
+            static IdMap& ids() {
+                static IdMap ids;
+                return ids;
+            }
+            
+            static StringList& names() {
+                static StringList names;
+                return names;
+            }
+        public:
+            static unsigned int id(const String& name) {
+                Utility::SpinLock::Guard guard(lock());
+                IdMap::iterator it = ids().lower_bound(name);
+                if (it == ids().end() || it->first != name) {
+                    it = ids().insert(it, IdMap::value_type(name, static_cast<unsigned int>(names().size())));
+                    names().push_back(name);
+                }
+                return it->second;
+            }
+            
+            static String name(unsigned int id) {
+                Utility::SpinLock::Guard guard(lock());
+                assert(id < names().size());
+                return names()[id];
+            }
+        };
         
         EntitySnapshot::EntitySnapshot(const Model::Entity& entity) {
             m_uniqueId = entity.uniqueId();
@@ -39,76 +83,149 @@ namespace TrenchBroom {
             return m_uniqueId;
         }
         
-        void EntitySnapshot::restore(Model::Entity& entity) {
-            entity.setProperties(m_properties, true);
+        size_t EntitySnapshot::memorySize() const {
+            size_t size = sizeof(EntitySnapshot) + m_properties.capacity() * sizeof(Model::Property);
+            for (size_t i = 0; i < m_properties.size(); i++)
+                size += m_properties[i].key().capacity() + m_properties[i].value().capacity();
+            return size;
         }
         
-        BrushSnapshot::BrushSnapshot(const Model::Brush& brush) {
-            m_uniqueId = brush.uniqueId();
-            const Model::FaceList& brushFaces = brush.faces();
-            for (unsigned int i = 0; i < brushFaces.size(); i++) {
-                Model::Face* snapshot = new Model::Face(*brushFaces[i]);
-                m_faces.push_back(snapshot);
-            }
-        }
-        
-        BrushSnapshot::~BrushSnapshot() {
-            // must not delete the face snapshots because they are now in use by the original brush!
-        }
-        
-        unsigned int BrushSnapshot::uniqueId() {
-            return m_uniqueId;
-        }
-        
-        void BrushSnapshot::restore(Model::Brush& brush) {
-            brush.restore(m_faces);
+        void EntitySnapshot::restore(Model::Entity& entity) {
+            entity.setProperties(m_properties, true);
         }
         
-        FaceSnapshot::FaceSnapshot(const Model::Face& face) {
-            m_faceId = face.faceId();
-            m_xOffset = face.xOffset();
-            m_yOffset = face.yOffset();
-            m_xScale = face.xScale();
-            m_yScale = face.yScale();
-            m_rotation = face.rotation();
-            m_texture = face.texture();
-            m_textureName = face.textureName();
+        FaceSnapshot::FaceSnapshot(const Model::Face& face) :
+        m_faceId(face.faceId()),
+        m_textureId(TextureNames::id(face.textureName())),
+        m_xOffset(face.xOffset()),
+        m_yOffset(face.yOffset()),
+        m_xScale(face.xScale()),
+        m_yScale(face.yScale()),
+        m_rotation(face.rotation()) {
+            face.getPoints(m_points[0], m_points[1], m_points[2]);
         }
         
-        unsigned int FaceSnapshot::faceId() {
-            return m_faceId;
+        Model::Face* FaceSnapshot::restore(const Model::Brush& brush, Model::TextureManager& textureManager) const {
+            // the face recomputes its boundary from the points in the same way as the original face did
+            Model::Face* face = new Model::Face(brush.worldBounds(), brush.forceIntegerFacePoints(), m_faceId, m_points[0], m_points[1], m_points[2], TextureNames::name(m_textureId));
+            restore(*face, textureManager);
+            return face;
         }
         
-        void FaceSnapshot::restore(Model::Face& face) {
+        void FaceSnapshot::restore(Model::Face& face, Model::TextureManager& textureManager) const {
             face.setXOffset(m_xOffset);
             face.setYOffset(m_yOffset);
             face.setRotation(m_rotation);
             face.setXScale(m_xScale);
             face.setYScale(m_yScale);
-            face.setTexture(m_texture);
-            if (m_texture == NULL)
-                face.setTextureName(m_textureName);
+            
+            const String textureName = TextureNames::name(m_textureId);
+            Model::Texture* texture = textureManager.texture(textureName);
+            face.setTexture(texture);
+            if (texture == NULL)
+                face.setTextureName(textureName);
         }
         
+        class CompareFaceSnapshotsById {
+        public:
+            inline bool operator()(const FaceSnapshot& left, const FaceSnapshot& right) const {
+                return left.faceId() < right.faceId();
+            }
+            
+            inline bool operator()(const FaceSnapshot& left, unsigned int right) const {
+                return left.faceId() < right;
+            }
+            
+            inline bool operator()(unsigned int left, const FaceSnapshot& right) const {
+                return left < right.faceId();
+            }
+        };
+        
+        class MakeBrushSnapshotsTask : public BrushTask {
+        private:
+            const std::vector<BrushSnapshot>& m_snapshots;
+            std::vector<FaceSnapshot>& m_faces;
+        public:
+            MakeBrushSnapshotsTask(const Model::BrushList& brushes, const std::vector<BrushSnapshot>& snapshots, std::vector<FaceSnapshot>& faces) :
+            BrushTask(brushes),
+            m_snapshots(snapshots),
+            m_faces(faces) {}
+            
+            void operator()(size_t index) {
+                const Model::FaceList& brushFaces = m_brushes[index]->faces();
+                const size_t firstFace = m_snapshots[index].firstFace();
+                for (size_t i = 0; i < brushFaces.size(); i++)
+                    m_faces[firstFace + i] = FaceSnapshot(*brushFaces[i]);
+            }
+        };
+        
+        class RestoreBrushSnapshotsTask : public BrushTask {
+        private:
+            const std::vector<BrushSnapshot>& m_snapshots;
+            const std::vector<FaceSnapshot>& m_faces;
+            Model::TextureManager& m_textureManager;
+        public:
+            RestoreBrushSnapshotsTask(const Model::BrushList& brushes, const std::vector<BrushSnapshot>& snapshots, const std::vector<FaceSnapshot>& faces, Model::TextureManager& textureManager) :
+            BrushTask(brushes),
+            m_snapshots(snapshots),
+            m_faces(faces),
+            m_textureManager(textureManager) {}
+            
+            void operator()(size_t index) {
+                Model::Brush& brush = *m_brushes[index];
+                const BrushSnapshot key(brush.uniqueId(), 0, 0);
+                std::vector<BrushSnapshot>::const_iterator it = std::lower_bound(m_snapshots.begin(), m_snapshots.end(), key);
+                assert(it != m_snapshots.end() && it->uniqueId() == brush.uniqueId());
+                
+                Model::FaceList faces;
+                faces.reserve(it->faceCount());
+                for (size_t i = 0; i < it->faceCount(); i++)
+                    faces.push_back(m_faces[it->firstFace() + i].restore(brush, m_textureManager));
+                brush.restore(faces);
+            }
+        };
+        
         void SnapshotCommand::makeSnapshots(const Model::EntityList& entities) {
             for (unsigned int i = 0; i < entities.size(); i++) {
                 Model::Entity& entity = *entities[i];
-                m_entities[entity.uniqueId()] = new EntitySnapshot(entity);
+                EntitySnapshot* snapshot = new EntitySnapshot(entity);
+                
+                EntitySnapshot*& entry = m_entities[entity.uniqueId()];
+                if (entry != NULL) {
+                    m_entitySnapshotSize -= entry->memorySize();
+                    delete entry;
+                }
+                entry = snapshot;
+                m_entitySnapshotSize += snapshot->memorySize();
             }
         }
         
         void SnapshotCommand::makeSnapshots(const Model::BrushList& brushes) {
-            for (unsigned int i = 0; i < brushes.size(); i++) {
+            BrushSnapshotList snapshots;
+            snapshots.reserve(brushes.size());
+            size_t faceCount = 0;
+            for (size_t i = 0; i < brushes.size(); i++) {
                 Model::Brush& brush = *brushes[i];
-                m_brushes[brush.uniqueId()] = new BrushSnapshot(brush);
+                snapshots.push_back(BrushSnapshot(brush.uniqueId(), faceCount, brush.faces().size()));
+                faceCount += brush.faces().size();
             }
+            
+            FaceSnapshotList faces(faceCount);
+            MakeBrushSnapshotsTask task(brushes, snapshots, faces);
+            task.run();
+            
+            std::sort(snapshots.begin(), snapshots.end());
+            m_brushes.swap(snapshots);
+            m_brushFaces.swap(faces);
         }
         
         void SnapshotCommand::makeSnapshots(const Model::FaceList& faces) {
-            for (unsigned int i = 0; i < faces.size(); i++) {
-                Model::Face& face = *faces[i];
-                m_faces[face.faceId()] = new FaceSnapshot(face);
-            }
+            FaceSnapshotList snapshots;
+            snapshots.reserve(faces.size());
+            for (size_t i = 0; i < faces.size(); i++)
+                snapshots.push_back(FaceSnapshot(*faces[i]));
+            std::sort(snapshots.begin(), snapshots.end(), CompareFaceSnapshotsById());
+            m_faces.swap(snapshots);
         }
         
         void SnapshotCommand::restoreSnapshots(const Model::EntityList& entities) {
@@ -133,11 +250,12 @@ namespace TrenchBroom {
         void SnapshotCommand::restoreSnapshots(const Model::BrushList& brushes) {
             assert(m_brushes.size() == brushes.size());
             
-            for (unsigned int i = 0; i < brushes.size(); i++) {
-                Model::Brush& brush = *brushes[i];
-                BrushSnapshot& snapshot = *m_brushes[brush.uniqueId()];
-                snapshot.restore(brush);
-            }
+            RestoreBrushSnapshotsTask task(brushes, m_brushes, m_brushFaces, document().textureManager());
+            task.run();
+            
+            // a redo makes new snapshots
+            BrushSnapshotList().swap(m_brushes);
+            FaceSnapshotList().swap(m_brushFaces);
         }
         
         void SnapshotCommand::restoreSnapshots(const Model::FaceList& faces) {
@@ -146,24 +264,38 @@ namespace TrenchBroom {
             if (faces.empty())
                 return;
             
+            Model::TextureManager& textureManager = document().textureManager();
             for (unsigned int i = 0; i < faces.size(); i++) {
                 Model::Face& face = *faces[i];
-                FaceSnapshot& snapshot = *m_faces[face.faceId()];
-                snapshot.restore(face);
+                FaceSnapshotList::const_iterator it = std::lower_bound(m_faces.begin(), m_faces.end(), face.faceId(), CompareFaceSnapshotsById());
+                assert(it != m_faces.end() && it->faceId() == face.faceId());
+                it->restore(face, textureManager);
             }
         }
 
         void SnapshotCommand::clear() {
             Utility::deleteAll(m_entities);
-            Utility::deleteAll(m_brushes);
-            Utility::deleteAll(m_faces);
+            m_entitySnapshotSize = 0;
+            BrushSnapshotList().swap(m_brushes);
+            FaceSnapshotList().swap(m_brushFaces);
+            FaceSnapshotList().swap(m_faces);
         }
         
         SnapshotCommand::SnapshotCommand(Command::Type type, Model::MapDocument& document, const wxString& name) :
-        DocumentCommand(type, document, true, name, true) {}
+        DocumentCommand(type, document, true, name, true),
+        m_entitySnapshotSize(0) {}
         
         SnapshotCommand::~SnapshotCommand() {
             clear();
         }
+        
+        size_t SnapshotCommand::memorySize() const {
+            // a map node has three pointers and a color in addition to its value
+            const size_t entityNodeSize = sizeof(EntitySnapshotMap::value_type) + 4 * sizeof(void*);
+            return (sizeof(SnapshotCommand) +
+                    m_entities.size() * entityNodeSize + m_entitySnapshotSize +
+                    m_brushes.capacity() * sizeof(BrushSnapshot) +
+                    (m_brushFaces.capacity() + m_faces.capacity()) * sizeof(FaceSnapshot));
+        }
     }
 }
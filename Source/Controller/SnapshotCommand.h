@@ -26,7 +26,12 @@
 #include "Model/EntityProperty.h"
 #include "Model/EntityTypes.h"
 #include "Model/FaceTypes.h"
-#include "Utility/String.h"
+#include "Utility/VecMath.h"
+
+#include <map>
+#include <vector>
+
+using namespace TrenchBroom::VecMath;
 
 
 namespace TrenchBroom {
@@ -34,7 +39,7 @@ namespace TrenchBroom {
         class Brush;
         class Entity;
         class Face;
-        class Texture;
+        class TextureManager;
     }
     
     namespace Controller {
@@ -45,45 +50,81 @@ namespace TrenchBroom {
         public:
             EntitySnapshot(const Model::Entity& entity);
             unsigned int uniqueId();
+            size_t memorySize() const;
             void restore(Model::Entity& entity);
         };
         
-        class BrushSnapshot {
-        private:
-            unsigned int m_uniqueId;
-            Model::FaceList m_faces;
-        public:
-            BrushSnapshot(const Model::Brush& brush);
-            ~BrushSnapshot();
-            unsigned int uniqueId();
-            void restore(Model::Brush& brush);
-        };
-        
+        /*
+         * Stores only what is needed to recreate a face: its ID, its plane points, its texture attributes and the ID of
+         * its interned texture name.
+         */
         class FaceSnapshot {
         private:
             unsigned int m_faceId;
+            unsigned int m_textureId;
+            Vec3f m_points[3];
             float m_xOffset;
             float m_yOffset;
             float m_xScale;
             float m_yScale;
             float m_rotation;
-            Model::Texture* m_texture;
-            String m_textureName;
         public:
+            FaceSnapshot() {}
             FaceSnapshot(const Model::Face& face);
-            unsigned int faceId();
-            void restore(Model::Face& face);
+            
+            inline unsigned int faceId() const {
+                return m_faceId;
+            }
+            
+            // recreates the face with all its attributes
+            Model::Face* restore(const Model::Brush& brush, Model::TextureManager& textureManager) const;
+            // restores only the texture attributes
+            void restore(Model::Face& face, Model::TextureManager& textureManager) const;
+        };
+        
+        class BrushSnapshot {
+        private:
+            unsigned int m_uniqueId;
+            unsigned int m_firstFace;
+            unsigned int m_faceCount;
+        public:
+            BrushSnapshot(unsigned int uniqueId, size_t firstFace, size_t faceCount) :
+            m_uniqueId(uniqueId),
+            m_firstFace(static_cast<unsigned int>(firstFace)),
+            m_faceCount(static_cast<unsigned int>(faceCount)) {}
+            
+            inline unsigned int uniqueId() const {
+                return m_uniqueId;
+            }
+            
+            inline size_t firstFace() const {
+                return m_firstFace;
+            }
+            
+            inline size_t faceCount() const {
+                return m_faceCount;
+            }
+            
+            inline bool operator<(const BrushSnapshot& other) const {
+                return m_uniqueId < other.m_uniqueId;
+            }
         };
         
         class SnapshotCommand : public DocumentCommand {
         private:
             typedef std::map<unsigned int, EntitySnapshot*> EntitySnapshotMap;
-            typedef std::map<unsigned int, BrushSnapshot*> BrushSnapshotMap;
-            typedef std::map<unsigned int, FaceSnapshot*> FaceSnapshotMap;
+            typedef std::vector<BrushSnapshot> BrushSnapshotList;
+            typedef std::vector<FaceSnapshot> FaceSnapshotList;
 
             EntitySnapshotMap m_entities;
-            BrushSnapshotMap m_brushes;
-            FaceSnapshotMap m_faces;
+            size_t m_entitySnapshotSize;
+            
+            // sorted by brush ID, the faces of each brush are stored consecutively in m_brushFaces
+            BrushSnapshotList m_brushes;
+            FaceSnapshotList m_brushFaces;
+            
+            // sorted by face ID
+            FaceSnapshotList m_faces;
         protected:
             void makeSnapshots(const Model::EntityList& entities);
             void makeSnapshots(const Model::BrushList& brushes);
@@ -95,6 +136,8 @@ namespace TrenchBroom {
         public:
             SnapshotCommand(Command::Type type, Model::MapDocument& document, const wxString& name);
             virtual ~SnapshotCommand();
+            
+            size_t memorySize() const;
         };
     }
 }
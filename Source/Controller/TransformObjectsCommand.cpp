@@ -19,15 +19,63 @@
 
 #include "TransformObjectsCommand.h"
 
+#include "Controller/BrushTask.h"
 #include "Model/Brush.h"
 #include "Model/Entity.h"
 #include "Model/MapDocument.h"
 #include "Utility/Console.h"
 
 #include <cassert>
+#include <cmath>
 
 namespace TrenchBroom {
     namespace Controller {
+        /*
+         Returns true if the given transformation maps the integer grid onto itself, i.e. if it is a translation by whole
+         units combined with rotations by multiples of 90 degrees and mirrorings. Such a transformation cannot change the
+         topology of a brush, not even if its face points are forced to integer coordinates, so the brush geometry can
+         be transformed instead of being rebuilt.
+         */
+        static bool preservesIntegerGrid(const Mat4f& transformation) {
+            for (size_t col = 0; col < 4; col++) {
+                for (size_t row = 0; row < 4; row++) {
+                    const float value = transformation[col][row];
+                    if (row == 3) {
+                        if (!Math<float>::eq(value, col == 3 ? 1.0f : 0.0f))
+                            return false;
+                    } else if (col == 3) {
+                        if (!Math<float>::eq(value, Math<float>::round(value)))
+                            return false;
+                    } else if (!Math<float>::zero(value) && !Math<float>::eq(std::abs(value), 1.0f)) {
+                        return false;
+                    }
+                }
+            }
+            return true;
+        }
+        
+        class TransformBrushesTask : public BrushTask {
+        private:
+            const Mat4f& m_pointTransform;
+            const Mat4f& m_vectorTransform;
+            bool m_lockTextures;
+            bool m_invertOrientation;
+            bool m_transformGeometry;
+        public:
+            TransformBrushesTask(const Model::BrushList& brushes, const Mat4f& pointTransform, const Mat4f& vectorTransform, bool lockTextures, bool invertOrientation, bool transformGeometry) :
+            BrushTask(brushes),
+            m_pointTransform(pointTransform),
+            m_vectorTransform(vectorTransform),
+            m_lockTextures(lockTextures),
+            m_invertOrientation(invertOrientation),
+            m_transformGeometry(transformGeometry) {}
+            
+            void operator()(size_t index) {
+                Model::Brush& brush = *m_brushes[index];
+                brush.transform(m_pointTransform, m_vectorTransform, m_lockTextures, m_invertOrientation, m_transformGeometry);
+            }
+        };
+        
         bool TransformObjectsCommand::performDo() {
             if (!m_entities.empty()) {
                 makeSnapshots(m_entities);
@@ -45,11 +93,8 @@ namespace TrenchBroom {
                 makeSnapshots(m_brushes);
                 document().brushesWillChange(m_brushes);
                 
-                Model::BrushList::const_iterator brushIt, brushEnd;
-                for (brushIt = m_brushes.begin(), brushEnd = m_brushes.end(); brushIt != brushEnd; ++brushIt) {
-                    Model::Brush& brush = **brushIt;
-                    brush.transform(m_pointTransform, m_vectorTransform, m_lockTextures, m_invertOrientation);
-                }
+                TransformBrushesTask task(m_brushes, m_pointTransform, m_vectorTransform, m_lockTextures, m_invertOrientation, m_preservesIntegerGrid);
+                task.run();
                 document().brushesDidChange(m_brushes);
             }
             
@@ -80,7 +125,8 @@ namespace TrenchBroom {
         m_pointTransform(pointTransform),
         m_vectorTransform(vectorTransform),
         m_lockTextures(document.textureLock()),
-        m_invertOrientation(invertOrientation) {}
+        m_invertOrientation(invertOrientation),
+        m_preservesIntegerGrid(preservesIntegerGrid(pointTransform)) {}
 
         TransformObjectsCommand* TransformObjectsCommand::translateObjects(Model::MapDocument& document, const Model::EntityList& entities, const Model::BrushList& brushes, const Vec3f& delta) {
             const wxString commandName = Command::makeObjectActionName(wxT("Move"), entities, brushes);
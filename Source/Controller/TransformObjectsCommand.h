@@ -40,6 +40,7 @@ namespace TrenchBroom {
             const Mat4f m_vectorTransform;
             bool m_lockTextures;
             bool m_invertOrientation;
+            bool m_preservesIntegerGrid;
             
             bool performDo();
             bool performUndo();
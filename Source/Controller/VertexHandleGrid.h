@@ -0,0 +1,125 @@
+/*
+ Copyright (C) 2010-2012 Kristian Duske
+ 
+ This file is part of TrenchBroom.
+ 
+ TrenchBroom is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+ 
+ TrenchBroom is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ 
+ You should have received a copy of the GNU General Public License
+ along with TrenchBroom.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef TrenchBroom_VertexHandleGrid_h
+#define TrenchBroom_VertexHandleGrid_h
+
+#include "Utility/VecMath.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <map>
+
+using namespace TrenchBroom::VecMath;
+
+namespace TrenchBroom {
+    namespace Controller {
+        class VertexHandleGrid {
+        private:
+            typedef std::map<Vec3f, Vec3f::List, Vec3f::LexicographicOrder> Grid;
+            
+            float m_cellSize;
+            Grid m_grid;
+            
+            inline const Vec3f cell(const Vec3f& position) const {
+                Vec3f cell;
+                for (size_t i = 0; i < 3; i++)
+                    cell[i] = std::floor(position[i] / m_cellSize);
+                return cell;
+            }
+        public:
+            VertexHandleGrid(float cellSize = 64.0f) :
+            m_cellSize(cellSize) {
+                assert(m_cellSize > 0.0f);
+            }
+            
+            inline void add(const Vec3f& position) {
+                m_grid[cell(position)].push_back(position);
+            }
+            
+            inline void remove(const Vec3f& position) {
+                Grid::iterator cellIt = m_grid.find(cell(position));
+                if (cellIt == m_grid.end())
+                    return;
+                
+                Vec3f::List& positions = cellIt->second;
+                Vec3f::List::iterator it = std::find(positions.begin(), positions.end(), position);
+                if (it == positions.end())
+                    return;
+                
+                *it = positions.back();
+                positions.pop_back();
+                if (positions.empty())
+                    m_grid.erase(cellIt);
+            }
+            
+            inline void clear() {
+                m_grid.clear();
+            }
+            
+            /*
+             Collects the positions of all handles that lie within the given radius of the ray segment between the ray's
+             origin and the given maximum distance. The segment is covered piecewise so that long rays don't visit the
+             cells of one big bounding box.
+             */
+            void findCandidates(const Rayf& ray, float maxDistance, float radius, Vec3f::List& result) const {
+                if (m_grid.empty())
+                    return;
+                
+                const Vec3f inflation(radius, radius, radius);
+                Vec3f::Set visited;
+                
+                float start = 0.0f;
+                do {
+                    const float end = std::min(start + m_cellSize, maxDistance);
+                    const Vec3f first = ray.pointAtDistance(start);
+                    const Vec3f last = ray.pointAtDistance(end);
+                    
+                    Vec3f min, max;
+                    for (size_t i = 0; i < 3; i++) {
+                        min[i] = std::min(first[i], last[i]);
+                        max[i] = std::max(first[i], last[i]);
+                    }
+                    
+                    const Vec3f minCell = cell(min - inflation);
+                    const Vec3f maxCell = cell(max + inflation);
+                    
+                    Vec3f current;
+                    for (current[0] = minCell.x(); current[0] <= maxCell.x(); current[0] += 1.0f) {
+                        for (current[1] = minCell.y(); current[1] <= maxCell.y(); current[1] += 1.0f) {
+                            for (current[2] = minCell.z(); current[2] <= maxCell.z(); current[2] += 1.0f) {
+                                Grid::const_iterator cellIt = m_grid.find(current);
+                                if (cellIt == m_grid.end() || !visited.insert(current).second)
+                                    continue;
+                                
+                                const Vec3f::List& positions = cellIt->second;
+                                result.insert(result.end(), positions.begin(), positions.end());
+                            }
+                        }
+                    }
+                    
+                    start = end;
+                } while (start < maxDistance);
+            }
+        };
+    }
+}
+
+#endif
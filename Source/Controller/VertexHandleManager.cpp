@@ -127,7 +127,7 @@ namespace TrenchBroom {
                     mapIt->second.push_back(&brush);
                     m_selectedVertexCount++;
                 } else {
-                    m_unselectedVertexHandles[vertex.position].push_back(&brush);
+                    addHandle(vertex.position, brush, m_unselectedVertexHandles, m_vertexHandleGrid);
                 }
             }
             m_totalVertexCount += brushVertices.size();
@@ -142,7 +142,7 @@ namespace TrenchBroom {
                     mapIt->second.push_back(&edge);
                     m_selectedEdgeCount++;
                 } else {
-                    m_unselectedEdgeHandles[position].push_back(&edge);
+                    addHandle(position, edge, m_unselectedEdgeHandles, m_edgeHandleGrid);
                 }
             }
             m_totalEdgeCount+= brushEdges.size();
@@ -157,7 +157,7 @@ namespace TrenchBroom {
                     mapIt->second.push_back(&face);
                     m_selectedFaceCount++;
                 } else {
-                    m_unselectedFaceHandles[position].push_back(&face);
+                    addHandle(position, face, m_unselectedFaceHandles, m_faceHandleGrid);
                 }
             }
             m_totalFaceCount += brushFaces.size();
@@ -176,11 +176,11 @@ namespace TrenchBroom {
             Model::VertexList::const_iterator vIt, vEnd;
             for (vIt = brushVertices.begin(), vEnd = brushVertices.end(); vIt != vEnd; ++vIt) {
                 const Model::Vertex& vertex = **vIt;
-                if (removeHandle(vertex.position, brush, m_selectedVertexHandles)) {
+                if (removeHandle(vertex.position, brush, m_selectedVertexHandles, m_vertexHandleGrid)) {
                     assert(m_selectedVertexCount > 0);
                     m_selectedVertexCount--;
                 } else {
-                    removeHandle(vertex.position, brush, m_unselectedVertexHandles);
+                    removeHandle(vertex.position, brush, m_unselectedVertexHandles, m_vertexHandleGrid);
                 }
             }
             assert(m_totalVertexCount >= brushVertices.size());
@@ -191,11 +191,11 @@ namespace TrenchBroom {
             for (eIt = brushEdges.begin(), eEnd = brushEdges.end(); eIt != eEnd; ++eIt) {
                 Model::Edge& edge = **eIt;
                 Vec3f position = edge.center();
-                if (removeHandle(position, edge, m_selectedEdgeHandles)) {
+                if (removeHandle(position, edge, m_selectedEdgeHandles, m_edgeHandleGrid)) {
                     assert(m_selectedEdgeCount > 0);
                     m_selectedEdgeCount--;
                 } else {
-                    removeHandle(position, edge, m_unselectedEdgeHandles);
+                    removeHandle(position, edge, m_unselectedEdgeHandles, m_edgeHandleGrid);
                 }
             }
             assert(m_totalEdgeCount >= brushEdges.size());
@@ -206,11 +206,11 @@ namespace TrenchBroom {
             for (fIt = brushFaces.begin(), fEnd = brushFaces.end(); fIt != fEnd; ++fIt) {
                 Model::Face& face = **fIt;
                 Vec3f position = face.center();
-                if (removeHandle(position, face, m_selectedFaceHandles)) {
+                if (removeHandle(position, face, m_selectedFaceHandles, m_faceHandleGrid)) {
                     assert(m_selectedFaceCount > 0);
                     m_selectedFaceCount--;
                 } else {
-                    removeHandle(position, face, m_unselectedFaceHandles);
+                    removeHandle(position, face, m_unselectedFaceHandles, m_faceHandleGrid);
                 }
             }
             assert(m_totalFaceCount >= brushFaces.size());
@@ -228,14 +228,17 @@ namespace TrenchBroom {
         void VertexHandleManager::clear() {
             m_unselectedVertexHandles.clear();
             m_selectedVertexHandles.clear();
+            m_vertexHandleGrid.clear();
             m_totalVertexCount = 0;
             m_selectedVertexCount = 0;
             m_unselectedEdgeHandles.clear();
             m_selectedEdgeHandles.clear();
+            m_edgeHandleGrid.clear();
             m_totalEdgeCount = 0;
             m_selectedEdgeCount = 0;
             m_unselectedFaceHandles.clear();
             m_selectedFaceHandles.clear();
+            m_faceHandleGrid.clear();
             m_totalFaceCount = 0;
             m_selectedFaceCount = 0;
             m_renderStateValid = false;
@@ -360,57 +363,13 @@ namespace TrenchBroom {
         }
 
         void VertexHandleManager::pick(const Rayf& ray, Model::PickResult& pickResult, bool splitMode) const {
-            Model::VertexToBrushesMap::const_iterator vIt, vEnd;
-            Model::VertexToEdgesMap::const_iterator eIt, eEnd;
-            Model::VertexToFacesMap::const_iterator fIt, fEnd;
-
-            if ((m_selectedEdgeHandles.empty() && m_selectedFaceHandles.empty()) || splitMode) {
-                for (vIt = m_unselectedVertexHandles.begin(), vEnd = m_unselectedVertexHandles.end(); vIt != vEnd; ++vIt) {
-                    const Vec3f& position = vIt->first;
-                    Model::VertexHandleHit* hit = pickHandle(ray, position, Model::HitType::VertexHandleHit);
-                    if (hit != NULL)
-                        pickResult.add(hit);
-                }
-            }
-
-            for (vIt = m_selectedVertexHandles.begin(), vEnd = m_selectedVertexHandles.end(); vIt != vEnd; ++vIt) {
-                const Vec3f& position = vIt->first;
-                Model::VertexHandleHit* hit = pickHandle(ray, position, Model::HitType::VertexHandleHit);
-                if (hit != NULL)
-                    pickResult.add(hit);
-            }
-
-            if (m_selectedVertexHandles.empty() && m_selectedFaceHandles.empty() && !splitMode) {
-                for (eIt = m_unselectedEdgeHandles.begin(), eEnd = m_unselectedEdgeHandles.end(); eIt != eEnd; ++eIt) {
-                    const Vec3f& position = eIt->first;
-                    Model::VertexHandleHit* hit = pickHandle(ray, position, Model::HitType::EdgeHandleHit);
-                    if (hit != NULL)
-                        pickResult.add(hit);
-                }
-            }
-
-            for (eIt = m_selectedEdgeHandles.begin(), eEnd = m_selectedEdgeHandles.end(); eIt != eEnd; ++eIt) {
-                const Vec3f& position = eIt->first;
-                Model::VertexHandleHit* hit = pickHandle(ray, position, Model::HitType::EdgeHandleHit);
-                if (hit != NULL)
-                    pickResult.add(hit);
-            }
-
-            if (m_selectedVertexHandles.empty() && m_selectedEdgeHandles.empty() && !splitMode) {
-                for (fIt = m_unselectedFaceHandles.begin(), fEnd = m_unselectedFaceHandles.end(); fIt != fEnd; ++fIt) {
-                    const Vec3f& position = fIt->first;
-                    Model::VertexHandleHit* hit = pickHandle(ray, position, Model::HitType::FaceHandleHit);
-                    if (hit != NULL)
-                        pickResult.add(hit);
-                }
-            }
-
-            for (fIt = m_selectedFaceHandles.begin(), fEnd = m_selectedFaceHandles.end(); fIt != fEnd; ++fIt) {
-                const Vec3f& position = fIt->first;
-                Model::VertexHandleHit* hit = pickHandle(ray, position, Model::HitType::FaceHandleHit);
-                if (hit != NULL)
-                    pickResult.add(hit);
-            }
+            const bool pickUnselectedVertices = (m_selectedEdgeHandles.empty() && m_selectedFaceHandles.empty()) || splitMode;
+            const bool pickUnselectedEdges = m_selectedVertexHandles.empty() && m_selectedFaceHandles.empty() && !splitMode;
+            const bool pickUnselectedFaces = m_selectedVertexHandles.empty() && m_selectedEdgeHandles.empty() && !splitMode;
+            
+            pickHandles(ray, m_vertexHandleGrid, m_selectedVertexHandles, pickUnselectedVertices, Model::HitType::VertexHandleHit, pickResult);
+            pickHandles(ray, m_edgeHandleGrid, m_selectedEdgeHandles, pickUnselectedEdges, Model::HitType::EdgeHandleHit, pickResult);
+            pickHandles(ray, m_faceHandleGrid, m_selectedFaceHandles, pickUnselectedFaces, Model::HitType::FaceHandleHit, pickResult);
         }
 
         void VertexHandleManager::render(Renderer::Vbo& vbo, Renderer::RenderContext& renderContext, bool splitMode) {
@@ -20,6 +20,7 @@
 #ifndef __TrenchBroom__HandleManager__
 #define __TrenchBroom__HandleManager__
 
+#include "Controller/VertexHandleGrid.h"
 #include "Model/Brush.h"
 #include "Model/BrushGeometryTypes.h"
 #include "Model/Picker.h"
@@ -67,6 +68,9 @@ namespace TrenchBroom {
             Model::VertexToEdgesMap m_selectedEdgeHandles;
             Model::VertexToFacesMap m_unselectedFaceHandles;
             Model::VertexToFacesMap m_selectedFaceHandles;
+            VertexHandleGrid m_vertexHandleGrid;
+            VertexHandleGrid m_edgeHandleGrid;
+            VertexHandleGrid m_faceHandleGrid;
             
             size_t m_totalVertexCount;
             size_t m_selectedVertexCount;
@@ -84,7 +88,7 @@ namespace TrenchBroom {
             bool m_recreateRenderers;
             
             template <typename Element>
-            inline bool removeHandle(const Vec3f& position, Element& element, std::map<Vec3f, std::vector<Element*>, Vec3f::LexicographicOrder >& map) {
+            inline bool removeHandle(const Vec3f& position, Element& element, std::map<Vec3f, std::vector<Element*>, Vec3f::LexicographicOrder >& map, VertexHandleGrid& grid) {
                 typedef std::vector<Element*> List;
                 typedef std::map<Vec3f, List, Vec3f::LexicographicOrder> Map;
                 
@@ -98,8 +102,10 @@ namespace TrenchBroom {
                     return false;
                 
                 elements.erase(listIt);
-                if (elements.empty())
+                if (elements.empty()) {
                     map.erase(mapIt);
+                    grid.remove(position);
+                }
                 return true;
             }
             
@@ -121,6 +127,38 @@ namespace TrenchBroom {
                 return elementCount;
             }
             
+            template <typename Element>
+            inline void addHandle(const Vec3f& position, Element& element, std::map<Vec3f, std::vector<Element*>, Vec3f::LexicographicOrder >& map, VertexHandleGrid& grid) {
+                std::vector<Element*>& elements = map[position];
+                if (elements.empty())
+                    grid.add(position);
+                elements.push_back(&element);
+            }
+            
+            template <typename Element>
+            inline void pickHandles(const Rayf& ray, const VertexHandleGrid& grid, const std::map<Vec3f, std::vector<Element*>, Vec3f::LexicographicOrder >& selectedHandles, bool pickUnselected, Model::HitType::Type type, Model::PickResult& pickResult) const {
+                if (!pickUnselected && selectedHandles.empty())
+                    return;
+                
+                Preferences::PreferenceManager& prefs = Preferences::PreferenceManager::preferences();
+                float handleRadius = prefs.getFloat(Preferences::HandleRadius);
+                float scalingFactor = prefs.getFloat(Preferences::HandleScalingFactor);
+                float maxDistance = prefs.getFloat(Preferences::MaximumHandleDistance);
+                
+                Vec3f::List candidates;
+                grid.findCandidates(ray, maxDistance, 2.0f * handleRadius * scalingFactor * maxDistance, candidates);
+                
+                Vec3f::List::const_iterator it, end;
+                for (it = candidates.begin(), end = candidates.end(); it != end; ++it) {
+                    const Vec3f& position = *it;
+                    if (!pickUnselected && selectedHandles.find(position) == selectedHandles.end())
+                        continue;
+                    Model::VertexHandleHit* hit = pickHandle(ray, position, type);
+                    if (hit != NULL)
+                        pickResult.add(hit);
+                }
+            }
+            
             inline Model::VertexHandleHit* pickHandle(const Rayf& ray, const Vec3f& position, Model::HitType::Type type) const {
                 Preferences::PreferenceManager& prefs = Preferences::PreferenceManager::preferences();
                 float handleRadius = prefs.getFloat(Preferences::HandleRadius);
@@ -20,6 +20,7 @@
 #include "MapParser.h"
 
 #include "Model/Brush.h"
+#include "Model/BrushGeometry.h"
 #include "Model/Entity.h"
 #include "Model/Face.h"
 #include "Model/Map.h"
@@ -27,9 +28,90 @@
 #include "Utility/Console.h"
 #include "Utility/List.h"
 #include "Utility/ProgressIndicator.h"
+#include "Utility/WorkerPool.h"
 
 namespace TrenchBroom {
     namespace IO {
+        class BuildBrushGeometryTask : public Utility::ParallelTask {
+        private:
+            const Model::BrushList& m_brushes;
+            std::vector<char>& m_valid; // not std::vector<bool> because the workers must write to separate bytes
+        public:
+            BuildBrushGeometryTask(const Model::BrushList& brushes, std::vector<char>& valid) :
+            m_brushes(brushes),
+            m_valid(valid) {}
+            
+            void operator()(size_t index) {
+                try {
+                    m_brushes[index]->rebuildGeometry();
+                    m_valid[index] = 1;
+                } catch (Model::GeometryException&) {
+                    m_valid[index] = 0;
+                }
+            }
+            
+            void beginThread() {
+                Model::BrushGeometry::beginArena();
+            }
+            
+            void endThread() {
+                Model::BrushGeometry::endArena();
+            }
+        };
+        
+        class ParseBrushesTask : public Utility::ParallelTask {
+        private:
+            typedef MapParser::BrushRangeList BrushRangeList;
+            typedef MapParser::EntityBrushList EntityBrushList;
+            
+            const BrushRangeList& m_ranges;
+            const BBoxf& m_worldBounds;
+            bool m_forceIntegerFacePoints;
+            MapParser::MapFormat m_format;
+            EntityBrushList& m_brushes;
+            std::vector<char>& m_valid;
+            std::vector<Utility::Console>& m_consoles;
+        public:
+            ParseBrushesTask(const BrushRangeList& ranges, const BBoxf& worldBounds, bool forceIntegerFacePoints, MapParser::MapFormat format, EntityBrushList& brushes, std::vector<char>& valid, std::vector<Utility::Console>& consoles) :
+            m_ranges(ranges),
+            m_worldBounds(worldBounds),
+            m_forceIntegerFacePoints(forceIntegerFacePoints),
+            m_format(format),
+            m_brushes(brushes),
+            m_valid(valid),
+            m_consoles(consoles) {}
+            
+            void operator()(size_t index) {
+                Model::Brush* brush = m_brushes[index].second;
+                if (brush == NULL) {
+                    try {
+                        MapParser::MapFormat format = m_format;
+                        brush = MapParser::parseBrushRange(m_ranges[index], m_worldBounds, m_forceIntegerFacePoints, format, m_consoles[index]);
+                    } catch (MapParserException&) {
+                        return;
+                    }
+                    if (brush == NULL)
+                        return;
+                    m_brushes[index].second = brush;
+                }
+                
+                try {
+                    brush->rebuildGeometry();
+                    m_valid[index] = 1;
+                } catch (Model::GeometryException&) {
+                    m_valid[index] = 0;
+                }
+            }
+            
+            void beginThread() {
+                Model::BrushGeometry::beginArena();
+            }
+            
+            void endThread() {
+                Model::BrushGeometry::endArena();
+            }
+        };
+        
         Token MapTokenEmitter::doEmit(Tokenizer& tokenizer) {
             while (!tokenizer.eof()) {
                 size_t line = tokenizer.line();
@@ -126,7 +208,7 @@ namespace TrenchBroom {
             return vec;
         }
 
-        Model::Entity* MapParser::parseEntity(const BBoxf& worldBounds, FacePointFormat& facePointFormat, Utility::ProgressIndicator* indicator) {
+        Model::Entity* MapParser::parseEntity(const BBoxf& worldBounds, FacePointFormat& facePointFormat, Utility::ProgressIndicator* indicator, EntityBrushList* deferredBrushes) {
             Token token = m_tokenizer.nextToken();
             if (token.type() == TokenType::Eof)
                 return NULL;
@@ -141,12 +223,11 @@ namespace TrenchBroom {
             while ((token = m_tokenizer.nextToken()).type() != TokenType::Eof) {
                 switch (token.type()) {
                     case TokenType::String: {
-                        String key = token.data();
+                        const Token keyToken = token;
                         expect(TokenType::String, token = m_tokenizer.nextToken());
-                        String value = token.data();
-                        entity->setProperty(key, value);
-                        if (facePointFormat == Unknown && key == Model::Entity::FacePointFormatKey) {
-                            if (value == "1") {
+                        entity->setProperty(keyToken.data(), token.data());
+                        if (facePointFormat == Unknown && keyToken.equals(Model::Entity::FacePointFormatKey)) {
+                            if (token.length() == 1 && *token.begin() == '1') {
                                 facePointFormat = Integer;
                             } else {
                                 facePointFormat = Float;
@@ -162,9 +243,19 @@ namespace TrenchBroom {
                         m_tokenizer.pushToken(token);
                         bool moreBrushes = true;
                         while (moreBrushes) {
-                            Model::Brush* brush = parseBrush(worldBounds, facePointFormat == Integer, indicator);
-                            if (brush != NULL)
-                                entity->addBrush(*brush);
+                            if (m_brushRanges != NULL) {
+                                assert(deferredBrushes != NULL);
+                                skipBrush();
+                                deferredBrushes->push_back(EntityBrush(entity, NULL));
+                            } else if (deferredBrushes != NULL) {
+                                Model::Brush* brush = parseBrushFaces(worldBounds, facePointFormat == Integer, indicator);
+                                if (brush != NULL)
+                                    deferredBrushes->push_back(EntityBrush(entity, brush));
+                            } else {
+                                Model::Brush* brush = parseBrush(worldBounds, facePointFormat == Integer, indicator);
+                                if (brush != NULL)
+                                    entity->addBrush(*brush);
+                            }
                             expect(TokenType::OBrace | TokenType::CBrace, token = m_tokenizer.nextToken());
                             moreBrushes = (token.type() == TokenType::OBrace);
                             m_tokenizer.pushToken(token);
@@ -190,11 +281,25 @@ namespace TrenchBroom {
             return entity;
         }
 
+        MapParser::MapParser(const char* begin, const char* end, size_t line, size_t column, Utility::Console& console) :
+        m_console(console),
+        m_tokenizer(begin, end, line, column),
+        m_format(Undefined),
+        m_begin(begin),
+        m_size(static_cast<size_t>(end - begin)),
+        m_brushRanges(NULL),
+        m_nextBrushRange(0) {
+            assert(end >= begin);
+        }
+        
         MapParser::MapParser(const char* begin, const char* end, Utility::Console& console) :
         m_console(console),
         m_tokenizer(begin, end),
         m_format(Undefined),
-        m_size(static_cast<size_t>(end - begin)) {
+        m_begin(begin),
+        m_size(static_cast<size_t>(end - begin)),
+        m_brushRanges(NULL),
+        m_nextBrushRange(0) {
             assert(end >= begin);
         }
 
@@ -202,30 +307,12 @@ namespace TrenchBroom {
         m_console(console),
         m_tokenizer(str.c_str(), str.c_str() + str.size()),
         m_format(Undefined),
-        m_size(str.size()) {}
+        m_begin(str.c_str()),
+        m_size(str.size()),
+        m_brushRanges(NULL),
+        m_nextBrushRange(0) {}
 
-        void MapParser::parseMap(Model::Map& map, Utility::ProgressIndicator* indicator) {
-            Model::Entity* entity = NULL;
-            
-            if (indicator != NULL) indicator->reset(static_cast<int>(m_size));
-            try {
-                FacePointFormat facePointFormat = Unknown;
-                while ((entity = parseEntity(map.worldBounds(), facePointFormat, indicator)) != NULL)
-                    map.addEntity(*entity);
-            } catch (MapParserException& e) {
-                m_console.error(e.what());
-            }
-            
-            if (indicator != NULL)
-                indicator->update(static_cast<int>(m_size));
-        }
-        
-        Model::Entity* MapParser::parseEntity(const BBoxf& worldBounds, bool forceIntegerFacePoints, Utility::ProgressIndicator* indicator) {
-            FacePointFormat format = forceIntegerFacePoints ? Integer : Float;
-            return parseEntity(worldBounds, format, indicator);
-        }
-        
-        Model::Brush* MapParser::parseBrush(const BBoxf& worldBounds, bool forceIntegerFacePoints, Utility::ProgressIndicator* indicator) {
+        Model::Brush* MapParser::parseBrushFaces(const BBoxf& worldBounds, bool forceIntegerFacePoints, Utility::ProgressIndicator* indicator) {
             Token token = m_tokenizer.nextToken();
             if (token.type() == TokenType::Eof)
                 return NULL;
@@ -249,17 +336,9 @@ namespace TrenchBroom {
                     case TokenType::CBrace: {
                         if (indicator != NULL) indicator->update(static_cast<int>(token.position()));
                         
-                        try {
-                            Model::Brush* brush = new Model::Brush(worldBounds, forceIntegerFacePoints, faces);
-                            brush->setFilePosition(firstLine, token.line() - firstLine);
-                            if (!brush->closed())
-                                m_console.warn("Non-closed brush at line %i", firstLine);
-                            return brush;
-                        } catch (Model::GeometryException&) {
-                            m_console.warn("Invalid brush at line %i", firstLine);
-                            Utility::deleteAll(faces);
-                            return NULL;
-                        }
+                        Model::Brush* brush = new Model::Brush(worldBounds, forceIntegerFacePoints, faces, false);
+                        brush->setFilePosition(firstLine, token.line() - firstLine);
+                        return brush;
                     }
                     default: {
                         Utility::deleteAll(faces);
@@ -271,6 +350,249 @@ namespace TrenchBroom {
             return NULL;
         }
         
+        bool MapParser::checkBrush(Model::Brush* brush, bool geometryValid) {
+            if (!geometryValid) {
+                m_console.warn("Invalid brush at line %i", brush->fileLine());
+                delete brush;
+                return false;
+            }
+            
+            if (!brush->closed())
+                m_console.warn("Non-closed brush at line %i", brush->fileLine());
+            return true;
+        }
+        
+        void MapParser::buildBrushGeometries(const EntityBrushList& brushes, std::vector<char>& geometryValid) {
+            Model::BrushList brushList;
+            brushList.reserve(brushes.size());
+            for (size_t i = 0; i < brushes.size(); i++)
+                brushList.push_back(brushes[i].second);
+            
+            geometryValid.assign(brushList.size(), 0);
+            BuildBrushGeometryTask task(brushList, geometryValid);
+            Utility::WorkerPool::run(task, brushList.size());
+        }
+        
+        void MapParser::addEntities(Model::Map& map, const Model::EntityList& entities, const EntityBrushList& brushes, const std::vector<char>& geometryValid) {
+            for (size_t i = 0; i < brushes.size(); i++) {
+                Model::Entity* entity = brushes[i].first;
+                Model::Brush* brush = brushes[i].second;
+                if (checkBrush(brush, geometryValid[i] != 0))
+                    entity->addBrush(*brush);
+            }
+            
+            for (size_t i = 0; i < entities.size(); i++)
+                map.addEntity(*entities[i]);
+        }
+        
+        bool MapParser::findBrushRanges(BrushRangeList& ranges) const {
+            // mirrors the rules of MapTokenEmitter: comments and quoted strings only start at the beginning of a token
+            MapTokenEmitter emitter;
+            size_t depth = 0;
+            size_t line = 1;
+            size_t column = 1;
+            bool tokenStart = true;
+            bool comment = false;
+            bool quoted = false;
+            
+            const char* end = m_begin + m_size;
+            for (const char* c = m_begin; c < end; ++c) {
+                if (comment) {
+                    comment = *c != '\n';
+                } else if (quoted) {
+                    quoted = *c != '"';
+                } else if (tokenStart && *c == '/' && c + 1 < end && *(c + 1) == '/') {
+                    if (c + 2 < end && *(c + 2) == '/') {
+                        // TB comments only consist of the three slashes
+                        c += 2;
+                        column += 2;
+                    } else {
+                        comment = true;
+                    }
+                } else if (tokenStart && *c == '"') {
+                    quoted = true;
+                } else {
+                    if (*c == '{') {
+                        if (depth == 1) {
+                            BrushRange range;
+                            range.begin = c;
+                            range.line = line;
+                            range.column = column;
+                            ranges.push_back(range);
+                        } else if (depth > 1) {
+                            return false;
+                        }
+                        depth++;
+                    } else if (*c == '}') {
+                        if (depth == 0)
+                            return false;
+                        if (depth == 2) {
+                            BrushRange& range = ranges.back();
+                            range.end = c + 1;
+                            range.endLine = line;
+                            range.endColumn = column + 1;
+                        }
+                        depth--;
+                    }
+                    tokenStart = emitter.isDelimiter(*c) || (tokenStart && (*c == '/' || *c == '[' || *c == ']'));
+                }
+                
+                if (*c == '\n') {
+                    line++;
+                    column = 1;
+                } else {
+                    column++;
+                }
+            }
+            
+            return depth == 0 && !quoted;
+        }
+        
+        void MapParser::skipBrush() {
+            assert(m_brushRanges != NULL);
+            
+            Token token = m_tokenizer.nextToken();
+            expect(TokenType::OBrace, token);
+            if (m_nextBrushRange >= m_brushRanges->size() || (*m_brushRanges)[m_nextBrushRange].begin != token.begin())
+                throw MapParserException(token, "brush boundaries do not match");
+            
+            const BrushRange& range = (*m_brushRanges)[m_nextBrushRange++];
+            m_tokenizer.seek(range.end, range.endLine, range.endColumn);
+        }
+        
+        Model::Brush* MapParser::parseBrushRange(const BrushRange& range, const BBoxf& worldBounds, bool forceIntegerFacePoints, MapFormat& format, Utility::Console& console) {
+            MapParser parser(range.begin, range.end, range.line, range.column, console);
+            parser.m_format = format;
+            Model::Brush* brush = parser.parseBrushFaces(worldBounds, forceIntegerFacePoints, NULL);
+            format = parser.m_format;
+            return brush;
+        }
+        
+        bool MapParser::parseMapParallel(Model::Map& map, Utility::ProgressIndicator* indicator) {
+            BrushRangeList ranges;
+            if (!findBrushRanges(ranges) || ranges.empty())
+                return false;
+            
+            // the entities are parsed by a separate parser that skips the brushes, the messages of all parsers are only
+            // logged once the whole map has been parsed successfully
+            Utility::Console entityConsole(true);
+            MapParser entityParser(m_begin, m_begin + m_size, entityConsole);
+            entityParser.m_brushRanges = &ranges;
+            
+            Model::EntityList entities;
+            EntityBrushList brushes;
+            FacePointFormat facePointFormat = Unknown;
+            try {
+                Model::Entity* entity = NULL;
+                while ((entity = entityParser.parseEntity(map.worldBounds(), facePointFormat, indicator, &brushes)) != NULL)
+                    entities.push_back(entity);
+            } catch (MapParserException&) {
+                if (!brushes.empty() && (entities.empty() || brushes.back().first != entities.back()))
+                    delete brushes.back().first;
+                Utility::deleteAll(entities);
+                return false;
+            }
+            
+            if (brushes.size() != ranges.size()) {
+                Utility::deleteAll(entities);
+                return false;
+            }
+            
+            const bool forceIntegerFacePoints = facePointFormat == Integer;
+            std::vector<Utility::Console> consoles(ranges.size(), Utility::Console(true));
+            std::vector<char> geometryValid(ranges.size(), 0);
+            
+            // the first brush determines the format of the faces, all brushes are then parsed and built in parallel
+            MapFormat format = m_format;
+            try {
+                brushes[0].second = parseBrushRange(ranges[0], map.worldBounds(), forceIntegerFacePoints, format, consoles[0]);
+            } catch (MapParserException&) {
+            }
+            
+            if (brushes[0].second != NULL) {
+                ParseBrushesTask task(ranges, map.worldBounds(), forceIntegerFacePoints, format, brushes, geometryValid, consoles);
+                Utility::WorkerPool::run(task, brushes.size());
+            }
+            
+            bool success = true;
+            for (size_t i = 0; i < brushes.size() && success; i++)
+                success = brushes[i].second != NULL;
+            
+            if (!success) {
+                for (size_t i = 0; i < brushes.size(); i++)
+                    delete brushes[i].second;
+                Utility::deleteAll(entities);
+                return false;
+            }
+            
+            m_format = format;
+            entityConsole.flushTo(m_console);
+            for (size_t i = 0; i < consoles.size(); i++)
+                consoles[i].flushTo(m_console);
+            
+            addEntities(map, entities, brushes, geometryValid);
+            return true;
+        }
+        
+        void MapParser::parseMapSequential(Model::Map& map, Utility::ProgressIndicator* indicator) {
+            Model::EntityList entities;
+            EntityBrushList brushes;
+            
+            try {
+                FacePointFormat facePointFormat = Unknown;
+                Model::Entity* entity = NULL;
+                while ((entity = parseEntity(map.worldBounds(), facePointFormat, indicator, &brushes)) != NULL)
+                    entities.push_back(entity);
+            } catch (MapParserException& e) {
+                m_console.error(e.what());
+                
+                // drop the brushes of the entity that could not be parsed completely
+                while (!brushes.empty() && (entities.empty() || brushes.back().first != entities.back())) {
+                    delete brushes.back().second;
+                    brushes.pop_back();
+                }
+            }
+            
+            // the brush geometries are independent of each other, so they are built in parallel once all faces are known
+            std::vector<char> geometryValid;
+            buildBrushGeometries(brushes, geometryValid);
+            addEntities(map, entities, brushes, geometryValid);
+        }
+        
+        void MapParser::parseMap(Model::Map& map, Utility::ProgressIndicator* indicator) {
+            if (indicator != NULL) indicator->reset(static_cast<int>(m_size));
+            
+            // if the map cannot be split into brushes up front or if it contains errors, it is parsed sequentially so
+            // that errors are reported and handled exactly as before
+            if (Utility::WorkerPool::workerCount() == 1 || !parseMapParallel(map, indicator))
+                parseMapSequential(map, indicator);
+            
+            if (indicator != NULL)
+                indicator->update(static_cast<int>(m_size));
+        }
+        
+        Model::Entity* MapParser::parseEntity(const BBoxf& worldBounds, bool forceIntegerFacePoints, Utility::ProgressIndicator* indicator) {
+            FacePointFormat format = forceIntegerFacePoints ? Integer : Float;
+            return parseEntity(worldBounds, format, indicator, NULL);
+        }
+        
+        Model::Brush* MapParser::parseBrush(const BBoxf& worldBounds, bool forceIntegerFacePoints, Utility::ProgressIndicator* indicator) {
+            Model::Brush* brush = parseBrushFaces(worldBounds, forceIntegerFacePoints, indicator);
+            if (brush == NULL)
+                return NULL;
+            
+            bool geometryValid = true;
+            try {
+                brush->rebuildGeometry();
+            } catch (Model::GeometryException&) {
+                geometryValid = false;
+            }
+            
+            if (!checkBrush(brush, geometryValid))
+                return NULL;
+            return brush;
+        }
+        
         Model::Face* MapParser::parseFace(const BBoxf& worldBounds, bool forceIntegerFacePoints) {
             Vec3f p1, p2, p3;
             float xOffset, yOffset, rotation, xScale, yScale;
@@ -288,8 +610,8 @@ namespace TrenchBroom {
             p3 = parseVector().corrected();
             expect(TokenType::CParenthesis, token = m_tokenizer.nextToken());
             
-            expect(TokenType::String, token = m_tokenizer.nextToken());
-            String textureName = token.data();
+            Token textureToken = m_tokenizer.nextToken();
+            expect(TokenType::String, textureToken);
             
             token = m_tokenizer.nextToken();
             if (m_format == Undefined) {
@@ -333,9 +655,7 @@ namespace TrenchBroom {
                 return NULL;
             }
             
-            if (textureName == Model::Texture::Empty)
-                textureName = "";
-            
+            const String textureName = textureToken.equals(Model::Texture::Empty) ? "" : textureToken.data();
             Model::Face* face = new Model::Face(worldBounds, forceIntegerFacePoints, p1, p2, p3, textureName);
             face->setXOffset(xOffset);
             face->setYOffset(yOffset);
@@ -64,11 +64,11 @@ namespace TrenchBroom {
 
         class MapTokenEmitter : public TokenEmitter<MapTokenEmitter> {
         protected:
-            bool isDelimiter(char c) {
+            Token doEmit(Tokenizer& tokenizer);
+        public:
+            inline bool isDelimiter(char c) const {
                 return isWhitespace(c) || c == '(' || c == ')' || c == '{' || c == '}' || c == '?' || c == ';' || c == ',' || c == '=';
             }
-
-            Token doEmit(Tokenizer& tokenizer);
         };
         
         class MapParserException : public TrenchBroom::Utility::MessageException {
@@ -140,10 +140,29 @@ namespace TrenchBroom {
                 Unknown
             };
             
+            typedef std::pair<Model::Entity*, Model::Brush*> EntityBrush;
+            typedef std::vector<EntityBrush> EntityBrushList;
+            
+            struct BrushRange {
+                const char* begin;
+                const char* end;
+                size_t line;
+                size_t column;
+                size_t endLine;
+                size_t endColumn;
+            };
+            typedef std::vector<BrushRange> BrushRangeList;
+            
+            friend class ParseBrushesTask;
+            
             Utility::Console& m_console;
             StreamTokenizer<MapTokenEmitter> m_tokenizer;
             MapFormat m_format;
+            const char* m_begin;
             size_t m_size;
+            
+            const BrushRangeList* m_brushRanges;
+            size_t m_nextBrushRange;
 
             inline void expect(unsigned int expectedType, const Token& actualToken) const {
                 if ((actualToken.type() & expectedType) == 0)
@@ -152,7 +171,20 @@ namespace TrenchBroom {
             
             Vec3f parseVector();
 
-            Model::Entity* parseEntity(const BBoxf& worldBounds, FacePointFormat& facePointFormat, Utility::ProgressIndicator* indicator);
+            Model::Entity* parseEntity(const BBoxf& worldBounds, FacePointFormat& facePointFormat, Utility::ProgressIndicator* indicator, EntityBrushList* deferredBrushes);
+            Model::Brush* parseBrushFaces(const BBoxf& worldBounds, bool forceIntegerFacePoints, Utility::ProgressIndicator* indicator);
+            bool checkBrush(Model::Brush* brush, bool geometryValid);
+            void buildBrushGeometries(const EntityBrushList& brushes, std::vector<char>& geometryValid);
+            void addEntities(Model::Map& map, const Model::EntityList& entities, const EntityBrushList& brushes, const std::vector<char>& geometryValid);
+            
+            bool findBrushRanges(BrushRangeList& ranges) const;
+            void skipBrush();
+            static Model::Brush* parseBrushRange(const BrushRange& range, const BBoxf& worldBounds, bool forceIntegerFacePoints, MapFormat& format, Utility::Console& console);
+            
+            bool parseMapParallel(Model::Map& map, Utility::ProgressIndicator* indicator);
+            void parseMapSequential(Model::Map& map, Utility::ProgressIndicator* indicator);
+            
+            MapParser(const char* begin, const char* end, size_t line, size_t column, Utility::Console& console);
         public:
             MapParser(const char* begin, const char* end, Utility::Console& console);
             MapParser(const String& str, Utility::Console& console);
@@ -0,0 +1,185 @@
+/*
+ Copyright (C) 2010-2012 Kristian Duske
+ 
+ This file is part of TrenchBroom.
+ 
+ TrenchBroom is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+ 
+ TrenchBroom is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ 
+ You should have received a copy of the GNU General Public License
+ along with TrenchBroom.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "MapSerializer.h"
+
+#include "Model/Brush.h"
+#include "Model/Entity.h"
+#include "Model/Face.h"
+#include "Model/Texture.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+
+#if defined _MSC_VER
+#include <cstdint>
+#elif defined __GNUC__
+#include <stdint.h>
+#endif
+
+namespace TrenchBroom {
+    namespace IO {
+        static inline void writeUnsigned(uint32_t value, String& buffer) {
+            char digits[10];
+            size_t count = 0;
+            do {
+                digits[count++] = static_cast<char>('0' + value % 10);
+                value /= 10;
+            } while (value > 0);
+            while (count > 0)
+                buffer += digits[--count];
+        }
+        
+        static inline void writePrintf(const float value, const int precision, String& buffer) {
+            char str[256];
+#if defined _MSC_VER
+            sprintf_s(str, "%.*g", precision, static_cast<double>(value));
+#else
+            std::sprintf(str, "%.*g", precision, static_cast<double>(value));
+#endif
+            buffer += str;
+        }
+        
+        void MapSerializer::writeFloat(const float value, const int precision, String& buffer) {
+            uint32_t bits;
+            std::memcpy(&bits, &value, sizeof(bits));
+            const bool negative = (bits & 0x80000000u) != 0;
+            
+            const double absValue = std::fabs(static_cast<double>(value));
+            if (absValue == 0.0) {
+                buffer += negative ? "-0" : "0";
+                return;
+            }
+            
+            // %g prints values in [1e-4, 10^precision) in fixed notation, so if the exact decimal expansion of the
+            // value has no more than precision significant digits, it is printed as is and no rounding is involved;
+            // we stay below 17 digits because some C runtimes don't print more digits exactly
+            if (!(absValue >= 1e-4 && absValue < 4294967296.0)) {
+                writePrintf(value, precision, buffer);
+                return;
+            }
+            
+            const uint32_t integer = static_cast<uint32_t>(absValue);
+            
+            // the fraction is n / 2^k with odd n, its decimal expansion has exactly k digits and k <= 37 for floats >= 1e-4
+            double fraction = absValue - integer;
+            unsigned int fractionDigitCount = 0;
+            while (fraction != std::floor(fraction)) {
+                fraction *= 2.0;
+                fractionDigitCount++;
+            }
+            
+            uint64_t numerator = static_cast<uint64_t>(fraction);
+            const uint64_t mask = (static_cast<uint64_t>(1) << fractionDigitCount) - 1;
+            char fractionDigits[64];
+            unsigned int leadingZeroCount = 0;
+            for (unsigned int i = 0; i < fractionDigitCount; i++) {
+                numerator *= 10;
+                fractionDigits[i] = static_cast<char>('0' + (numerator >> fractionDigitCount));
+                numerator &= mask;
+                if (leadingZeroCount == i && fractionDigits[i] == '0')
+                    leadingZeroCount++;
+            }
+            
+            unsigned int integerDigitCount = 0;
+            for (uint32_t i = integer; i > 0; i /= 10)
+                integerDigitCount++;
+            
+            const unsigned int significantDigitCount = integer > 0 ? integerDigitCount + fractionDigitCount : fractionDigitCount - leadingZeroCount;
+            if (significantDigitCount > static_cast<unsigned int>(std::min(precision, 17))) {
+                writePrintf(value, precision, buffer);
+                return;
+            }
+            
+            if (negative)
+                buffer += '-';
+            writeUnsigned(integer, buffer);
+            if (fractionDigitCount > 0) {
+                buffer += '.';
+                buffer.append(fractionDigits, fractionDigitCount);
+            }
+        }
+        
+        void MapSerializer::writeFace(const Model::Face& face, String& buffer) {
+            const String& textureName = Utility::isBlank(face.textureName()) ? Model::Texture::Empty : face.textureName();
+            
+            for (size_t i = 0; i < 3; i++) {
+                const Vec3f& point = face.point(i);
+                buffer += "( ";
+                writeFloat(point.x(), PointPrecision, buffer);
+                buffer += ' ';
+                writeFloat(point.y(), PointPrecision, buffer);
+                buffer += ' ';
+                writeFloat(point.z(), PointPrecision, buffer);
+                buffer += " ) ";
+            }
+            
+            buffer += textureName;
+            buffer += ' ';
+            writeFloat(face.xOffset(), TexturePrecision, buffer);
+            buffer += ' ';
+            writeFloat(face.yOffset(), TexturePrecision, buffer);
+            buffer += ' ';
+            writeFloat(face.rotation(), TexturePrecision, buffer);
+            buffer += ' ';
+            writeFloat(face.xScale(), TexturePrecision, buffer);
+            buffer += ' ';
+            writeFloat(face.yScale(), TexturePrecision, buffer);
+            buffer += '\n';
+        }
+        
+        void MapSerializer::writeBrush(const Model::Brush& brush, String& buffer) {
+            buffer += "{\n";
+            const Model::FaceList& faces = brush.faces();
+            Model::FaceList::const_iterator faceIt, faceEnd;
+            for (faceIt = faces.begin(), faceEnd = faces.end(); faceIt != faceEnd; ++faceIt)
+                writeFace(**faceIt, buffer);
+            buffer += "}\n";
+        }
+        
+        void MapSerializer::writeEntityHeader(const Model::Entity& entity, String& buffer) {
+            buffer += "{\n";
+            
+            const Model::PropertyList& properties = entity.properties();
+            Model::PropertyList::const_iterator it, end;
+            for (it = properties.begin(), end = properties.end(); it != end; ++it) {
+                const Model::Property& property = *it;
+                buffer += '"';
+                buffer += property.key();
+                buffer += "\" \"";
+                buffer += property.value();
+                buffer += "\"\n";
+            }
+        }
+        
+        void MapSerializer::writeEntityFooter(String& buffer) {
+            buffer += "}\n";
+        }
+        
+        size_t MapSerializer::brushLineCount(const Model::Brush& brush) {
+            return brush.faces().size() + 2;
+        }
+        
+        size_t MapSerializer::entityHeaderLineCount(const Model::Entity& entity) {
+            return entity.properties().size() + 1;
+        }
+    }
+}
@@ -0,0 +1,52 @@
+/*
+ Copyright (C) 2010-2012 Kristian Duske
+ 
+ This file is part of TrenchBroom.
+ 
+ TrenchBroom is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+ 
+ TrenchBroom is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ 
+ You should have received a copy of the GNU General Public License
+ along with TrenchBroom.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __TrenchBroom__MapSerializer__
+#define __TrenchBroom__MapSerializer__
+
+#include "Utility/String.h"
+
+namespace TrenchBroom {
+    namespace Model {
+        class Brush;
+        class Entity;
+        class Face;
+    }
+    
+    namespace IO {
+        class MapSerializer {
+        public:
+            static const int PointPrecision = 100;
+            static const int TexturePrecision = 6;
+            
+            // appends the same text as printf's %.<precision>g
+            static void writeFloat(float value, int precision, String& buffer);
+            
+            static void writeFace(const Model::Face& face, String& buffer);
+            static void writeBrush(const Model::Brush& brush, String& buffer);
+            static void writeEntityHeader(const Model::Entity& entity, String& buffer);
+            static void writeEntityFooter(String& buffer);
+            
+            static size_t brushLineCount(const Model::Brush& brush);
+            static size_t entityHeaderLineCount(const Model::Entity& entity);
+        };
+    }
+}
+
+#endif /* defined(__TrenchBroom__MapSerializer__) */
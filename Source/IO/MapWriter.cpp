@@ -19,167 +19,106 @@
 
 #include "MapWriter.h"
 
-#include "Model/Texture.h"
 #include "Model/Brush.h"
-#include "Model/BrushGeometry.h"
 #include "Model/Entity.h"
-#include "Model/EntityDefinition.h"
 #include "Model/Face.h"
 #include "Model/Map.h"
 #include "IO/FileManager.h"
 #include "IO/IOException.h"
+#include "IO/MapSerializer.h"
+#include "Utility/WorkerPool.h"
 
+#include <algorithm>
 #include <cassert>
-#include <fstream>
-#include <limits>
+#include <cstdio>
+#include <map>
 
 namespace TrenchBroom {
     namespace IO {
-        size_t MapWriter::writeFace(Model::Face& face, const size_t lineNumber, FILE* stream) {
-            const String textureName = Utility::isBlank(face.textureName()) ? Model::Texture::Empty : face.textureName();
-
-            std::fprintf(stream, FaceFormat.c_str(),
-                    face.point(0).x(),
-                    face.point(0).y(),
-                    face.point(0).z(),
-                    face.point(1).x(),
-                    face.point(1).y(),
-                    face.point(1).z(),
-                    face.point(2).x(),
-                    face.point(2).y(),
-                    face.point(2).z(),
-                    textureName.c_str(),
-                    face.xOffset(),
-                    face.yOffset(),
-                    face.rotation(),
-                    face.xScale(),
-                    face.yScale());
-            face.setFilePosition(lineNumber);
-            return 1;
-        }
-        
-        size_t MapWriter::writeBrush(Model::Brush& brush, const size_t lineNumber, FILE* stream) {
-            size_t lineCount = 0;
-            std::fprintf(stream, "{\n"); lineCount++;
-            const Model::FaceList& faces = brush.faces();
-            Model::FaceList::const_iterator faceIt, faceEnd;
-            for (faceIt = faces.begin(), faceEnd = faces.end(); faceIt != faceEnd; ++faceIt) {
-                lineCount += writeFace(**faceIt, lineNumber + lineCount, stream);
-            }
-            std::fprintf(stream, "}\n"); lineCount++;
-            brush.setFilePosition(lineNumber, lineCount);
-            return lineCount;
-        }
-        
-        size_t MapWriter::writeEntityHeader(Model::Entity& entity, FILE* stream) {
-            size_t lineCount = 0;
-            std::fprintf(stream, "{\n"); lineCount++;
+        class SerializeChunksTask : public Utility::ParallelTask {
+        private:
+            typedef MapWriter::Chunk Chunk;
+            typedef MapWriter::ChunkList ChunkList;
             
-            const Model::PropertyList& properties = entity.properties();
-            Model::PropertyList::const_iterator it, end;
-            for (it = properties.begin(), end = properties.end(); it != end; ++it) {
-                const Model::Property& property = *it;
-                std::fprintf(stream, "\"%s\" \"%s\"\n", property.key().c_str(), property.value().c_str()); lineCount++;
+            const ChunkList& m_chunks;
+            bool m_setFilePositions;
+            StringList& m_buffers;
+        public:
+            SerializeChunksTask(const ChunkList& chunks, bool setFilePositions, StringList& buffers) :
+            m_chunks(chunks),
+            m_setFilePositions(setFilePositions),
+            m_buffers(buffers) {}
+            
+            void operator()(size_t index) {
+                const Chunk& chunk = m_chunks[index];
+                String& buffer = m_buffers[index];
+                size_t lineNumber = chunk.firstLine;
+                
+                if (chunk.header) {
+                    MapSerializer::writeEntityHeader(*chunk.entity, buffer);
+                    lineNumber += MapSerializer::entityHeaderLineCount(*chunk.entity);
+                }
+                
+                for (size_t i = chunk.firstBrush; i < chunk.lastBrush; i++) {
+                    Model::Brush& brush = *(*chunk.brushes)[i];
+                    const size_t lineCount = MapSerializer::brushLineCount(brush);
+                    if (m_setFilePositions) {
+                        brush.setFilePosition(lineNumber, lineCount);
+                        const Model::FaceList& faces = brush.faces();
+                        for (size_t j = 0; j < faces.size(); j++)
+                            faces[j]->setFilePosition(lineNumber + j + 1);
+                    }
+                    MapSerializer::writeBrush(brush, buffer);
+                    lineNumber += lineCount;
+                }
+                
+                if (chunk.footer)
+                    MapSerializer::writeEntityFooter(buffer);
             }
-            return lineCount;
-        }
+        };
         
-        size_t MapWriter::writeEntityFooter(FILE* stream) {
-            std::fprintf(stream, "}\n");
-            return 1;
-        }
-        
-        size_t MapWriter::writeEntity(Model::Entity& entity, const size_t lineNumber, FILE* stream) {
-            size_t lineCount = writeEntityHeader(entity, stream);
-            const Model::BrushList& brushes = entity.brushes();
-            for (unsigned int i = 0; i < brushes.size(); i++)
-                lineCount += writeBrush(*brushes[i], lineNumber + lineCount, stream);
-            lineCount += writeEntityFooter(stream);
-            entity.setFilePosition(lineNumber, lineCount);
-            return lineCount;
-        }
-
-        void MapWriter::writeFace(const Model::Face& face, std::ostream& stream) {
-            const String textureName = Utility::isBlank(face.textureName()) ? Model::Texture::Empty : face.textureName();
+        size_t MapWriter::addChunks(Model::Entity& entity, const Model::BrushList& brushes, const size_t firstLine, ChunkList& chunks) {
+            size_t lineNumber = firstLine;
+            size_t firstBrush = 0;
+            do {
+                Chunk chunk;
+                chunk.entity = &entity;
+                chunk.brushes = &brushes;
+                chunk.firstBrush = firstBrush;
+                chunk.lastBrush = std::min(firstBrush + ChunkBrushCount, brushes.size());
+                chunk.header = chunk.firstBrush == 0;
+                chunk.footer = chunk.lastBrush == brushes.size();
+                chunk.firstLine = lineNumber;
+                chunks.push_back(chunk);
+                
+                if (chunk.header)
+                    lineNumber += MapSerializer::entityHeaderLineCount(entity);
+                for (size_t i = chunk.firstBrush; i < chunk.lastBrush; i++)
+                    lineNumber += MapSerializer::brushLineCount(*brushes[i]);
+                firstBrush = chunk.lastBrush;
+            } while (firstBrush < brushes.size());
             
-            stream.precision(FloatPrecision);
-            stream <<
-            "( " <<
-            face.point(0).x() << " " <<
-            face.point(0).y() << " " <<
-            face.point(0).z() <<
-            " ) ( "           <<
-            face.point(1).x() << " " <<
-            face.point(1).y() << " " <<
-            face.point(1).z() <<
-            " ) ( "           <<
-            face.point(2).x() << " " <<
-            face.point(2).y() << " " <<
-            face.point(2).z() <<
-            " ) ";
-
-            stream.precision(6);
-            stream <<
-            textureName     << " " <<
-            face.xOffset()  << " " <<
-            face.yOffset()  << " " <<
-            face.rotation() << " " <<
-            face.xScale()   << " " <<
-            face.yScale()   << "\n";
+            // the footer
+            lineNumber++;
+            return lineNumber - firstLine;
         }
-
-        void MapWriter::writeBrush(const Model::Brush& brush, std::ostream& stream) {
-            stream << "{\n";
-            const Model::FaceList& faces = brush.faces();
-            Model::FaceList::const_iterator faceIt, faceEnd;
-            for (faceIt = faces.begin(), faceEnd = faces.end(); faceIt != faceEnd; ++faceIt)
-                writeFace(**faceIt, stream);
-            stream << "}\n";
-        }
-
-        void MapWriter::writeEntityHeader(const Model::Entity& entity, std::ostream& stream) {
-            stream << "{\n";
+        
+        void MapWriter::serializeChunks(const ChunkList& chunks, const bool setFilePositions, StringList& buffers) {
+            buffers.clear();
+            buffers.resize(chunks.size());
             
-            const Model::PropertyList& properties = entity.properties();
-            Model::PropertyList::const_iterator it, end;
-            for (it = properties.begin(), end = properties.end(); it != end; ++it) {
-                const Model::Property& property = *it;
-                stream << "\"" << property.key() << "\" \"" << property.value() << "\"" << "\n";
-            }
+            SerializeChunksTask task(chunks, setFilePositions, buffers);
+            Utility::WorkerPool::run(task, chunks.size());
         }
         
-        void MapWriter::writeEntityFooter(std::ostream& stream) {
-            stream << "}\n";
+        void MapWriter::writeBuffers(const StringList& buffers, std::ostream& stream) {
+            StringList::const_iterator it, end;
+            for (it = buffers.begin(), end = buffers.end(); it != end; ++it)
+                stream.write(it->data(), static_cast<std::streamsize>(it->size()));
         }
 
-        void MapWriter::writeEntity(const Model::Entity& entity, std::ostream& stream) {
-            writeEntityHeader(entity, stream);
-            const Model::BrushList& brushes = entity.brushes();
-            for (unsigned int i = 0; i < brushes.size(); i++)
-                writeBrush(*brushes[i], stream);
-            writeEntityFooter(stream);
-        }
-
-        MapWriter::MapWriter() {
-            StringStream str;
-            str <<
-            "( %." << FloatPrecision << "g " <<
-              "%." << FloatPrecision << "g " <<
-              "%." << FloatPrecision << "g ) " <<
-            "( %." << FloatPrecision << "g " <<
-              "%." << FloatPrecision << "g " <<
-              "%." << FloatPrecision << "g ) " <<
-            "( %." << FloatPrecision << "g " <<
-              "%." << FloatPrecision << "g " <<
-              "%." << FloatPrecision << "g ) " <<
-            "%s %.6g %.6g %.6g %.6g %.6g\n";
-            
-            FaceFormat = str.str();
-        }
-        
         void MapWriter::writeObjectsToStream(const Model::EntityList& pointEntities, const Model::BrushList& brushes, std::ostream& stream) {
             assert(stream.good());
-            stream.unsetf(std::ios::floatfield);
 
             Model::Entity* worldspawn = NULL;
             
@@ -196,53 +135,54 @@ namespace TrenchBroom {
                     worldspawn = &entity;
             }
             
+            ChunkList chunks;
+            size_t lineNumber = 1;
+            
             // write worldspawn first
-            if (worldspawn != NULL) {
-                Model::BrushList& brushList = entityToBrushes[worldspawn];
-                writeEntityHeader(*worldspawn, stream);
-                for (brushIt = brushList.begin(), brushEnd = brushList.end(); brushIt != brushEnd; ++brushIt) {
-                    writeBrush(**brushIt, stream);
-                }
-                writeEntityFooter(stream);
-            }
+            if (worldspawn != NULL)
+                lineNumber += addChunks(*worldspawn, entityToBrushes[worldspawn], lineNumber, chunks);
             
             // now write the point entities
             Model::EntityList::const_iterator entityIt, entityEnd;
             for (entityIt = pointEntities.begin(), entityEnd = pointEntities.end(); entityIt != entityEnd; ++entityIt) {
                 Model::Entity& entity = **entityIt;
-                writeEntity(entity, stream);
+                lineNumber += addChunks(entity, entity.brushes(), lineNumber, chunks);
             }
 
             // finally write the brush entities
             EntityBrushMap::iterator it, end;
             for (it = entityToBrushes.begin(), end = entityToBrushes.end(); it != end; ++it) {
                 Model::Entity* entity = it->first;
-                if (entity != worldspawn) {
-                    Model::BrushList& brushList = it->second;
-                    writeEntityHeader(*entity, stream);
-                    for (brushIt = brushList.begin(), brushEnd = brushList.end(); brushIt != brushEnd; ++brushIt) {
-                        writeBrush(**brushIt, stream);
-                    }
-                    writeEntityFooter(stream);
-                }
+                if (entity != worldspawn)
+                    lineNumber += addChunks(*entity, it->second, lineNumber, chunks);
             }
+            
+            StringList buffers;
+            serializeChunks(chunks, false, buffers);
+            writeBuffers(buffers, stream);
         }
         
         void MapWriter::writeFacesToStream(const Model::FaceList& faces, std::ostream& stream) {
             assert(stream.good());
-            stream.unsetf(std::ios::floatfield);
             
+            String buffer;
             for (unsigned int i = 0; i < faces.size(); i++)
-                writeFace(*faces[i], stream);
+                MapSerializer::writeFace(*faces[i], buffer);
+            stream.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
         }
 
         void MapWriter::writeToStream(const Model::Map& map, std::ostream& stream) {
             assert(stream.good());
-            stream.unsetf(std::ios::floatfield);
             
+            ChunkList chunks;
+            size_t lineNumber = 1;
             const Model::EntityList& entities = map.entities();
             for (unsigned int i = 0; i < entities.size(); i++)
-                writeEntity(*entities[i], stream);
+                lineNumber += addChunks(*entities[i], entities[i]->brushes(), lineNumber, chunks);
+            
+            StringList buffers;
+            serializeChunks(chunks, false, buffers);
+            writeBuffers(buffers, stream);
         }
         
         void MapWriter::writeToFileAtPath(Model::Map& map, const String& path, bool overwrite) {
@@ -257,12 +197,24 @@ namespace TrenchBroom {
             FILE* stream = fopen(path.c_str(), "w");
             if (stream == NULL)
                 throw IOException::openError(path);
-            // std::fstream stream(path.c_str(), std::ios::out | std::ios::trunc);
-
+            
+            // the line numbers of all objects are known up front, so the entities can be serialized independently
+            ChunkList chunks;
             size_t lineNumber = 1;
             const Model::EntityList& entities = map.entities();
-            for (unsigned int i = 0; i < entities.size(); i++)
-                lineNumber += writeEntity(*entities[i], lineNumber, stream);
+            for (unsigned int i = 0; i < entities.size(); i++) {
+                Model::Entity& entity = *entities[i];
+                const size_t lineCount = addChunks(entity, entity.brushes(), lineNumber, chunks);
+                entity.setFilePosition(lineNumber, lineCount);
+                lineNumber += lineCount;
+            }
+            
+            StringList buffers;
+            serializeChunks(chunks, true, buffers);
+            
+            StringList::const_iterator it, end;
+            for (it = buffers.begin(), end = buffers.end(); it != end; ++it)
+                std::fwrite(it->data(), 1, it->size(), stream);
             fclose(stream);
         }
     }
@@ -25,42 +25,38 @@
 #include "Model/FaceTypes.h"
 #include "Utility/String.h"
 
-#include <cstdio>
 #include <ostream>
-
-#if defined _MSC_VER
-#include <cstdint>
-#elif defined __GNUC__
-#include <stdint.h>
-#endif
+#include <vector>
 
 namespace TrenchBroom {
     namespace Model {
-        class Brush;
         class Entity;
-        class Face;
         class Map;
     }
     
     namespace IO {
         class MapWriter {
         private:
-            static const int FloatPrecision = 100;
-            String FaceFormat;
-        protected:
-            size_t writeFace(Model::Face& face, const size_t lineNumber, FILE* stream);
-            size_t writeBrush(Model::Brush& brush, const size_t lineNumber, FILE* stream);
-            size_t writeEntityHeader(Model::Entity& entity, FILE* stream);
-            size_t writeEntityFooter(FILE* stream);
-            size_t writeEntity(Model::Entity& entity, const size_t lineNumber, FILE* stream);
+            // a run of brushes of one entity that is serialized into its own buffer
+            struct Chunk {
+                Model::Entity* entity;
+                const Model::BrushList* brushes;
+                size_t firstBrush;
+                size_t lastBrush;
+                bool header;
+                bool footer;
+                size_t firstLine;
+            };
+            typedef std::vector<Chunk> ChunkList;
+            
+            static const size_t ChunkBrushCount = 256;
+            
+            friend class SerializeChunksTask;
             
-            void writeFace(const Model::Face& face, std::ostream& stream);
-            void writeBrush(const Model::Brush& brush, std::ostream& stream);
-            void writeEntityHeader(const Model::Entity& entity, std::ostream& stream);
-            void writeEntityFooter(std::ostream& stream);
-            void writeEntity(const Model::Entity& entity, std::ostream& stream);
+            size_t addChunks(Model::Entity& entity, const Model::BrushList& brushes, size_t firstLine, ChunkList& chunks);
+            void serializeChunks(const ChunkList& chunks, bool setFilePositions, StringList& buffers);
+            void writeBuffers(const StringList& buffers, std::ostream& stream);
         public:
-            MapWriter();
             void writeObjectsToStream(const Model::EntityList& pointEntities, const Model::BrushList& brushes, std::ostream& stream);
             void writeFacesToStream(const Model::FaceList& faces, std::ostream& stream);
             void writeToStream(const Model::Map& map, std::ostream& stream);
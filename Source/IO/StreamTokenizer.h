@@ -21,18 +21,17 @@
 #define __TrenchBroom__StreamTokenizer__
 
 #include "IO/ParserException.h"
-#include "Utility/Allocator.h"
+#include "Utility/String.h"
 
 #include <cassert>
 #include <cstdlib>
 #include <cstring>
 #include <istream>
 #include <memory>
-#include <stack>
 
 namespace TrenchBroom {
     namespace IO {
-        class Token : public Utility::Allocator<Token> {
+        class Token {
         protected:
             unsigned int m_type;
             const char* m_begin;
@@ -83,28 +82,131 @@ namespace TrenchBroom {
                 return m_column;
             }
 
+            inline const char* begin() const {
+                return m_begin;
+            }
+
+            inline const char* end() const {
+                return m_end;
+            }
+
+            inline bool equals(const String& str) const {
+                return str.size() == length() && std::memcmp(str.data(), m_begin, length()) == 0;
+            }
+
             inline float toFloat() const {
-                static char buffer[64];
-                memcpy(buffer, m_begin, length());
-                buffer[length()] = 0;
-                float f = static_cast<float>(std::atof(buffer));
-                return f;
+                double value;
+                if (!parseDecimal(value)) {
+                    // fall back to the C library for anything unusual, but use a local buffer so that
+                    // tokens can be converted concurrently
+                    char buffer[64];
+                    if (length() < sizeof(buffer)) {
+                        std::memcpy(buffer, m_begin, length());
+                        buffer[length()] = 0;
+                        value = std::atof(buffer);
+                    } else {
+                        value = std::atof(data().c_str());
+                    }
+                }
+                return static_cast<float>(value);
             }
 
             inline int toInteger() const {
-                static char buffer[64];
-                memcpy(buffer, m_begin, length());
-                buffer[length()] = 0;
-                int i = static_cast<int>(std::atoi(buffer));
-                return i;
+                const char* c = m_begin;
+                while (c < m_end && (*c == ' ' || *c == '\t' || *c == '\n' || *c == '\r'))
+                    ++c;
+
+                bool negative = false;
+                if (c < m_end && (*c == '-' || *c == '+'))
+                    negative = *c++ == '-';
+
+                int i = 0;
+                while (c < m_end && *c >= '0' && *c <= '9')
+                    i = 10 * i + (*c++ - '0');
+                return negative ? -i : i;
+            }
+        private:
+            /**
+             * Parses the token as [-]digits[.digits][e[+|-]digits] without copying it. Returns false if the
+             * token has a different form or if the value cannot be computed exactly, that is, if the result
+             * might differ from the correctly rounded result that atof returns.
+             */
+            inline bool parseDecimal(double& value) const {
+                static const double powersOf10[] = { 1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+                    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22 };
+
+                const char* c = m_begin;
+                bool negative = false;
+                if (c < m_end && (*c == '-' || *c == '+'))
+                    negative = *c++ == '-';
+
+                // the mantissa is exact as long as it has at most 15 significant digits
+                double mantissa = 0.0;
+                size_t significantDigits = 0;
+                size_t digits = 0;
+                int exponent = 0;
+
+                for (; c < m_end && *c >= '0' && *c <= '9'; ++c, ++digits) {
+                    if (significantDigits > 0 || *c != '0') {
+                        mantissa = 10.0 * mantissa + (*c - '0');
+                        significantDigits++;
+                    }
+                }
+
+                if (c < m_end && *c == '.') {
+                    for (++c; c < m_end && *c >= '0' && *c <= '9'; ++c, ++digits) {
+                        if (significantDigits > 0 || *c != '0') {
+                            mantissa = 10.0 * mantissa + (*c - '0');
+                            significantDigits++;
+                        }
+                        exponent--;
+                    }
+                }
+
+                if (digits == 0 || significantDigits > 15)
+                    return false;
+
+                if (c < m_end && (*c == 'e' || *c == 'E')) {
+                    ++c;
+                    bool negativeExponent = false;
+                    if (c < m_end && (*c == '-' || *c == '+'))
+                        negativeExponent = *c++ == '-';
+                    if (c == m_end)
+                        return false;
+
+                    int explicitExponent = 0;
+                    for (; c < m_end && *c >= '0' && *c <= '9'; ++c) {
+                        explicitExponent = 10 * explicitExponent + (*c - '0');
+                        if (explicitExponent > 1000)
+                            return false;
+                    }
+                    exponent += negativeExponent ? -explicitExponent : explicitExponent;
+                }
+
+                if (c != m_end)
+                    return false;
+
+                // both operands are exactly representable, so a single multiplication or division is
+                // correctly rounded
+                if (mantissa == 0.0) {
+                    value = 0.0;
+                } else if (exponent >= 0 && exponent <= 22) {
+                    value = mantissa * powersOf10[exponent];
+                } else if (exponent < 0 && exponent >= -22) {
+                    value = mantissa / powersOf10[-exponent];
+                } else {
+                    return false;
+                }
+
+                if (negative)
+                    value = -value;
+                return true;
             }
         };
 
         template <typename Emitter>
         class StreamTokenizer {
         private:
-            typedef std::stack<Token> TokenStack;
-
             const char* m_begin;
             const char* m_end;
             const char* m_cur;
@@ -113,22 +215,19 @@ namespace TrenchBroom {
             size_t m_lastColumn;
 
             Emitter m_emitter;
-            TokenStack m_tokenStack;
-        protected:
-            inline Token popToken() {
-                assert(!m_tokenStack.empty());
-                Token token = m_tokenStack.top();
-                m_tokenStack.pop();
-                return token;
-            }
+
+            // the parsers never push back more than the token they just read, so a single slot suffices
+            Token m_pushedToken;
+            bool m_hasPushedToken;
         public:
-            StreamTokenizer(const char* begin, const char* end) :
+            StreamTokenizer(const char* begin, const char* end, size_t line = 1, size_t column = 1) :
             m_begin(begin),
             m_end(end),
             m_cur(begin),
-            m_line(1),
-            m_column(1),
-            m_lastColumn(0) {}
+            m_line(line),
+            m_column(column),
+            m_lastColumn(0),
+            m_hasPushedToken(false) {}
 
             inline size_t line() const {
                 return m_line;
@@ -176,12 +275,28 @@ namespace TrenchBroom {
                 return *(m_cur + offset);
             }
 
+            /**
+             * Continues tokenizing at the given position, which must lie within the stream. The caller must supply the
+             * line and column of that position.
+             */
+            inline void seek(const char* position, size_t line, size_t column) {
+                assert(position >= m_begin && position <= m_end);
+                assert(!m_hasPushedToken);
+                m_cur = position;
+                m_line = line;
+                m_column = column;
+            }
+
             inline bool eof() const {
                 return m_cur >= m_end;
             }
 
             inline Token nextToken() {
-                return !m_tokenStack.empty() ? popToken() : m_emitter.emit(*this);
+                if (m_hasPushedToken) {
+                    m_hasPushedToken = false;
+                    return m_pushedToken;
+                }
+                return m_emitter.emit(*this);
             }
 
             inline Token peekToken() {
@@ -191,7 +306,9 @@ namespace TrenchBroom {
             }
 
             inline void pushToken(Token& token) {
-                m_tokenStack.push(token);
+                assert(!m_hasPushedToken);
+                m_pushedToken = token;
+                m_hasPushedToken = true;
             }
 
             inline String remainder(unsigned int delimiterType) {
@@ -222,6 +339,7 @@ namespace TrenchBroom {
                 m_line = 1;
                 m_column = 1;
                 m_cur = m_begin;
+                m_hasPushedToken = false;
             }
         };
 
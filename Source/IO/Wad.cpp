@@ -33,6 +33,7 @@ namespace TrenchBroom {
             static const unsigned int DirEntryNameLength    = 16;
             static const unsigned int PalLength             = 256;
             static const unsigned int TexWidthOffset        = 16;
+            static const unsigned int MipLevelCount         = 4;
         }
 
         Mip* Wad::loadMip(const WadEntry& entry, unsigned int mipCount) const throw (IOException) {
@@ -61,6 +62,29 @@ namespace TrenchBroom {
             return new Mip(entry.name(), static_cast<unsigned int>(width), static_cast<unsigned int>(height), mip0);
         }
 
+        Mip* Wad::loadSmallestMip(const WadEntry& entry) const throw (IOException) {
+            if (entry.type() != WadEntryType::WEMip)
+                throw IOException("Entry %s is not a mip", entry.name().c_str());
+            
+            char* cursor = m_file->begin() + entry.address() + WadLayout::TexWidthOffset;
+            unsigned int width = readUnsignedInt<int32_t>(cursor) >> (WadLayout::MipLevelCount - 1);
+            unsigned int height = readUnsignedInt<int32_t>(cursor) >> (WadLayout::MipLevelCount - 1);
+            cursor += (WadLayout::MipLevelCount - 1) * sizeof(int32_t);
+            unsigned int mipSize = width * height;
+            unsigned int mipOffset = readUnsignedInt<int32_t>(cursor);
+            
+            if (width == 0 || height == 0)
+                throw IOException("Invalid mip dimensions (%ix%i)", width, height);
+            if (mipOffset + mipSize > entry.length())
+                throw IOException("Mip data beyond wad entry");
+            
+            unsigned char* mip = new unsigned char[mipSize];
+            cursor = m_file->begin() + entry.address() + mipOffset;
+            readBytes(cursor, mip, mipSize);
+            
+            return new Mip(entry.name(), width, height, mip);
+        }
+        
         Wad::Wad(const String& path) throw (IOException) {
             FileManager fileManager;
             m_file = fileManager.mapFile(path);
@@ -109,6 +133,13 @@ namespace TrenchBroom {
             return loadMip(it->second, mipCount);
         }
 
+        Mip* Wad::loadSmallestMip(const String& name) const throw (IOException) {
+            EntryMap::const_iterator it = m_entries.find(name);
+            if (it == m_entries.end())
+                throw IOException("Wad entry %s not found", name.c_str());
+            return loadSmallestMip(it->second);
+        }
+        
         Mip::List Wad::loadMips(unsigned int mipCount) const throw (IOException) {
             Mip::List mips;
             EntryMap::const_iterator it, end;
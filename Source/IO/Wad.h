@@ -123,11 +123,15 @@ namespace TrenchBroom {
             EntryMap m_entries;
 
             Mip* loadMip(const WadEntry& entry, unsigned int mipCount) const throw (IOException);
+            Mip* loadSmallestMip(const WadEntry& entry) const throw (IOException);
         public:
             Wad(const String& path) throw (IOException);
             
             Mip* loadMip(const String& name, unsigned int mipCount) const throw (IOException);
             Mip::List loadMips(unsigned int mipCount) const throw (IOException);
+            
+            // returns the last of the four mip levels, which is an eighth of the texture's width and height
+            Mip* loadSmallestMip(const String& name) const throw (IOException);
         };
     }
 }
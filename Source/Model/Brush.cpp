@@ -25,18 +25,175 @@
 #include "Model/Picker.h"
 #include "Model/Texture.h"
 #include "Utility/List.h"
+#include "Utility/ThreadLocal.h"
 
 #include <algorithm>
+#include <limits>
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#define TB_BRUSH_SSE
+#include <xmmintrin.h>
+#endif
 
 namespace TrenchBroom {
     namespace Model {
+        typedef Utility::ThreadLocalPointer<EntitySet> DeferredEntities;
+        
+        /*
+         * Since brushes are convex, a ray hits a brush if the last plane it enters through is closer than the first
+         * plane it exits through. Returns the distance to the entry plane and sets hitFace to its face, or returns NaN
+         * if the ray misses the brush or starts inside of it.
+         */
+        static float intersectFacesWithRay(const FaceList& faces, const Rayf& ray, Face*& hitFace) {
+            float enter = -std::numeric_limits<float>::max();
+            float exit = std::numeric_limits<float>::max();
+            hitFace = NULL;
+            
+            for (size_t i = 0; i < faces.size(); i++) {
+                const Planef& boundary = faces[i]->boundary();
+                const float dot = boundary.normal.dot(ray.direction);
+                const float dist = boundary.distance - boundary.normal.dot(ray.origin);
+                if (Math<float>::neg(dot)) {
+                    const float t = dist / dot;
+                    if (t > enter) {
+                        enter = t;
+                        hitFace = faces[i];
+                    }
+                } else if (Math<float>::pos(dot)) {
+                    const float t = dist / dot;
+                    if (t < exit)
+                        exit = t;
+                } else if (dist < 0.0f) {
+                    // the ray is (almost) parallel to and above this plane
+                    return Math<float>::nan();
+                }
+            }
+            
+            if (hitFace == NULL || enter < 0.0f || enter > exit)
+                return Math<float>::nan();
+            return enter;
+        }
+        
+#if defined(TB_BRUSH_SSE)
+        /*
+         * Intersects the ray with up to four brushes at once, one brush per lane, using the same computation as
+         * intersectFacesWithRay. Lanes whose brush has fewer faces are padded with a plane that the ray never crosses.
+         */
+        static void pickBrushBatch(Brush* const* brushes, const size_t count, const Rayf& ray, PickResult& pickResults) {
+            assert(count > 0 && count <= 4);
+            
+            size_t faceCount = 0;
+            for (size_t i = 0; i < count; i++)
+                faceCount = std::max(faceCount, brushes[i]->faces().size());
+            
+            const __m128 zero = _mm_setzero_ps();
+            const __m128 almostZero = _mm_set1_ps(Math<float>::AlmostZero);
+            const __m128 negAlmostZero = _mm_set1_ps(-Math<float>::AlmostZero);
+            const __m128 originX = _mm_set1_ps(ray.origin.x());
+            const __m128 originY = _mm_set1_ps(ray.origin.y());
+            const __m128 originZ = _mm_set1_ps(ray.origin.z());
+            const __m128 directionX = _mm_set1_ps(ray.direction.x());
+            const __m128 directionY = _mm_set1_ps(ray.direction.y());
+            const __m128 directionZ = _mm_set1_ps(ray.direction.z());
+            
+            __m128 enter = _mm_set1_ps(-std::numeric_limits<float>::max());
+            __m128 exit = _mm_set1_ps(std::numeric_limits<float>::max());
+            __m128 enterIndex = _mm_set1_ps(-1.0f);
+            __m128 miss = zero;
+            
+            for (size_t i = 0; i < faceCount; i++) {
+                float normalsX[4], normalsY[4], normalsZ[4], distances[4];
+                for (size_t j = 0; j < 4; j++) {
+                    if (j < count && i < brushes[j]->faces().size()) {
+                        const Planef& boundary = brushes[j]->faces()[i]->boundary();
+                        normalsX[j] = boundary.normal.x();
+                        normalsY[j] = boundary.normal.y();
+                        normalsZ[j] = boundary.normal.z();
+                        distances[j] = boundary.distance;
+                    } else {
+                        normalsX[j] = normalsY[j] = normalsZ[j] = 0.0f;
+                        distances[j] = 1.0f;
+                    }
+                }
+                
+                const __m128 normalX = _mm_loadu_ps(normalsX);
+                const __m128 normalY = _mm_loadu_ps(normalsY);
+                const __m128 normalZ = _mm_loadu_ps(normalsZ);
+                const __m128 dot = _mm_add_ps(_mm_add_ps(_mm_mul_ps(normalX, directionX),
+                                                         _mm_mul_ps(normalY, directionY)),
+                                              _mm_mul_ps(normalZ, directionZ));
+                const __m128 dist = _mm_sub_ps(_mm_loadu_ps(distances),
+                                               _mm_add_ps(_mm_add_ps(_mm_mul_ps(normalX, originX),
+                                                                     _mm_mul_ps(normalY, originY)),
+                                                          _mm_mul_ps(normalZ, originZ)));
+                const __m128 t = _mm_div_ps(dist, dot);
+                
+                const __m128 negative = _mm_cmplt_ps(dot, negAlmostZero);
+                const __m128 positive = _mm_cmpgt_ps(dot, almostZero);
+                
+                const __m128 entering = _mm_and_ps(negative, _mm_cmpgt_ps(t, enter));
+                enter = _mm_or_ps(_mm_and_ps(entering, t), _mm_andnot_ps(entering, enter));
+                enterIndex = _mm_or_ps(_mm_and_ps(entering, _mm_set1_ps(static_cast<float>(i))), _mm_andnot_ps(entering, enterIndex));
+                
+                const __m128 exiting = _mm_and_ps(positive, _mm_cmplt_ps(t, exit));
+                exit = _mm_or_ps(_mm_and_ps(exiting, t), _mm_andnot_ps(exiting, exit));
+                
+                miss = _mm_or_ps(miss, _mm_andnot_ps(_mm_or_ps(negative, positive), _mm_cmplt_ps(dist, zero)));
+            }
+            
+            const __m128 hit = _mm_andnot_ps(miss, _mm_and_ps(_mm_cmpge_ps(enterIndex, zero),
+                                                              _mm_and_ps(_mm_cmpge_ps(enter, zero), _mm_cmple_ps(enter, exit))));
+            const int hitMask = _mm_movemask_ps(hit);
+            if (hitMask == 0)
+                return;
+            
+            float enters[4], enterIndices[4];
+            _mm_storeu_ps(enters, enter);
+            _mm_storeu_ps(enterIndices, enterIndex);
+            for (size_t i = 0; i < count; i++) {
+                if ((hitMask & (1 << i)) != 0) {
+                    Face& face = *brushes[i]->faces()[static_cast<size_t>(enterIndices[i])];
+                    const Vec3f hitPoint = ray.pointAtDistance(enters[i]);
+                    pickResults.add(new FaceHit(face, hitPoint, enters[i]));
+                }
+            }
+        }
+#endif
+
         void Brush::init() {
             m_entity = NULL;
             setEditState(EditState::Default);
             m_selectedFaceCount = 0;
+            m_contentTypes = 0;
+            m_contentTypesValid = false;
+        }
+
+        void Brush::invalidateFaceGeometry() {
+            for (FaceList::iterator it = m_faces.begin(); it != m_faces.end(); ++it) {
+                Face* face = *it;
+                face->invalidateTexAxes();
+                face->invalidateVertexCache();
+            }
+
+            if (m_entity != NULL) {
+                EntitySet* deferredEntities = DeferredEntities::get();
+                if (deferredEntities != NULL)
+                    deferredEntities->insert(m_entity);
+                else
+                    m_entity->invalidateGeometry();
+            }
+        }
+        
+        void Brush::validateContentTypes() const {
+            m_contentTypes = 0;
+            for (FaceList::const_iterator it = m_faces.begin(); it != m_faces.end(); ++it) {
+                const Face* face = *it;
+                m_contentTypes |= Face::contentTypeBit(face->contentType());
+            }
+            m_contentTypesValid = true;
         }
 
-        Brush::Brush(const BBoxf& worldBounds, bool forceIntegerFacePoints, const FaceList& faces) :
+        Brush::Brush(const BBoxf& worldBounds, bool forceIntegerFacePoints, const FaceList& faces, bool buildGeometry) :
         MapObject(),
         m_geometry(NULL),
         m_worldBounds(worldBounds),
@@ -50,7 +207,9 @@ namespace TrenchBroom {
                 m_faces.push_back(face);
             }
 
-            rebuildGeometry();
+            // the geometry is built when the brush is added to an entity or when rebuildGeometry is called
+            if (buildGeometry)
+                rebuildGeometry();
         }
 
         Brush::Brush(const BBoxf& worldBounds, bool forceIntegerFacePoints, const Brush& brushTemplate) :
@@ -138,6 +297,12 @@ namespace TrenchBroom {
             Utility::deleteAll(m_faces);
         }
 
+        EntitySet* Brush::deferEntityInvalidation(EntitySet* entities) {
+            EntitySet* previous = DeferredEntities::get();
+            DeferredEntities::set(entities);
+            return previous;
+        }
+        
         void Brush::restore(const Brush& brushTemplate, bool checkId) {
             if (checkId)
                 assert(uniqueId() == brushTemplate.uniqueId());
@@ -185,6 +350,7 @@ namespace TrenchBroom {
             }
 
             m_entity = entity;
+            invalidateFilterVisibility();
 
             if (m_entity != NULL) {
                 if (selected())
@@ -240,23 +406,30 @@ namespace TrenchBroom {
                 delete face;
             }
 
-            for (FaceList::iterator it = m_faces.begin(); it != m_faces.end(); ++it) {
-                Face* face = *it;
-                face->invalidateTexAxes();
-                face->invalidateVertexCache();
-            }
-
-            if (m_entity != NULL)
-                m_entity->invalidateGeometry();
+            invalidateFaceGeometry();
         }
 
         void Brush::transform(const Mat4f& pointTransform, const Mat4f& vectorTransform, const bool lockTextures, const bool invertOrientation) {
+            transform(pointTransform, vectorTransform, lockTextures, invertOrientation, false);
+        }
+
+        void Brush::transform(const Mat4f& pointTransform, const Mat4f& vectorTransform, const bool lockTextures, const bool invertOrientation, const bool transformGeometry) {
             FaceList::const_iterator faceIt, faceEnd;
             for (faceIt = m_faces.begin(), faceEnd = m_faces.end(); faceIt != faceEnd; ++faceIt) {
                 Face& face = **faceIt;
                 face.transform(pointTransform, vectorTransform, lockTextures, invertOrientation);
             }
 
+            if (transformGeometry && m_geometry != NULL) {
+                m_geometry->transform(pointTransform, invertOrientation);
+                
+                // a rebuilt geometry would be clipped by the world bounds
+                if (m_worldBounds.contains(m_geometry->bounds)) {
+                    invalidateFaceGeometry();
+                    return;
+                }
+            }
+
             rebuildGeometry();
         }
 
@@ -512,20 +685,38 @@ namespace TrenchBroom {
             if (Math<float>::isnan(dist))
                 return;
 
-            dist = Math<float>::nan();
-            Side* side = NULL;
-            for (unsigned int i = 0; i < m_geometry->sides.size() && Math<float>::isnan(dist); i++) {
-                side = m_geometry->sides[i];
-                dist = side->intersectWithRay(ray);
-            }
-
+            Face* face = NULL;
+            dist = intersectFacesWithRay(m_faces, ray, face);
             if (!Math<float>::isnan(dist)) {
-                assert(side != NULL);
+                assert(face != NULL);
                 Vec3f hitPoint = ray.pointAtDistance(dist);
-                FaceHit* hit = new FaceHit(*(side->face), hitPoint, dist);
+                FaceHit* hit = new FaceHit(*face, hitPoint, dist);
                 pickResults.add(hit);
             }
         }
+        
+        void Brush::pick(const BrushList& brushes, const Rayf& ray, PickResult& pickResults) {
+#if defined(TB_BRUSH_SSE)
+            // only the brushes whose bounds are hit are intersected with their faces
+            Brush* batch[4];
+            size_t count = 0;
+            for (size_t i = 0; i < brushes.size(); i++) {
+                Brush* brush = brushes[i];
+                if (!Math<float>::isnan(brush->bounds().intersectWithRay(ray, NULL))) {
+                    batch[count++] = brush;
+                    if (count == 4) {
+                        pickBrushBatch(batch, count, ray, pickResults);
+                        count = 0;
+                    }
+                }
+            }
+            if (count > 0)
+                pickBrushBatch(batch, count, ray, pickResults);
+#else
+            for (size_t i = 0; i < brushes.size(); i++)
+                brushes[i]->pick(ray, pickResults);
+#endif
+        }
 
         bool Brush::containsPoint(const Vec3f point) const {
             if (!bounds().contains(point))
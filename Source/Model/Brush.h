@@ -23,6 +23,7 @@
 #include "IO/ByteBuffer.h"
 #include "Model/BrushGeometry.h"
 #include "Model/EditState.h"
+#include "Model/EntityTypes.h"
 #include "Model/FaceTypes.h"
 #include "Model/MapObject.h"
 #include "Utility/Allocator.h"
@@ -47,17 +48,29 @@ namespace TrenchBroom {
             BrushGeometry* m_geometry;
 
             unsigned int m_selectedFaceCount;
+            
+            mutable unsigned int m_contentTypes;
+            mutable bool m_contentTypesValid;
 
             const BBoxf& m_worldBounds;
             bool m_forceIntegerFacePoints;
 
             void init();
+            void invalidateFaceGeometry();
+            void validateContentTypes() const;
         public:
-            Brush(const BBoxf& worldBounds, bool forceIntegerFacePoints, const FaceList& faces);
+            Brush(const BBoxf& worldBounds, bool forceIntegerFacePoints, const FaceList& faces, bool buildGeometry = true);
             Brush(const BBoxf& worldBounds, bool forceIntegerFacePoints, const Brush& brushTemplate);
             Brush(const BBoxf& worldBounds, bool forceIntegerFacePoints, const BBoxf& brushBounds, Texture* texture);
             ~Brush();
 
+            /*
+             * While a set is installed on the calling thread, brushes whose geometry changes on that thread add their
+             * entity to the set instead of invalidating the entity's geometry, which may be shared with other threads.
+             * Returns the previously installed set.
+             */
+            static EntitySet* deferEntityInvalidation(EntitySet* entities);
+
             void restore(const Brush& brushTemplate, bool checkId = false);
             void restore(const FaceList& faces);
 
@@ -86,6 +99,21 @@ namespace TrenchBroom {
             inline void decSelectedFaceCount() {
                 m_selectedFaceCount--;
             }
+            
+            /**
+             * The content types of this brush's faces, with one bit set per content type (see
+             * Face::contentTypeBit).
+             */
+            inline unsigned int contentTypes() const {
+                if (!m_contentTypesValid)
+                    validateContentTypes();
+                return m_contentTypes;
+            }
+            
+            inline void invalidateContentTypes() {
+                m_contentTypesValid = false;
+                invalidateFilterVisibility();
+            }
 
             virtual EditState::Type setEditState(EditState::Type editState);
 
@@ -136,6 +164,8 @@ namespace TrenchBroom {
             void rebuildGeometry();
 
             void transform(const Mat4f& pointTransform, const Mat4f& vectorTransform, const bool lockTextures, const bool invertOrientation);
+            // if transformGeometry is set, the geometry is transformed instead of rebuilt, see BrushGeometry::transform
+            void transform(const Mat4f& pointTransform, const Mat4f& vectorTransform, const bool lockTextures, const bool invertOrientation, const bool transformGeometry);
 
             bool clip(Face& face);
             
@@ -158,6 +188,8 @@ namespace TrenchBroom {
             Vec3f splitFace(const FaceInfo& faceInfo, const Vec3f& delta);
 
             void pick(const Rayf& ray, PickResult& pickResults);
+            // picks several brushes with the same ray, which is faster than picking each brush on its own
+            static void pick(const BrushList& brushes, const Rayf& ray, PickResult& pickResults);
             bool containsPoint(const Vec3f point) const;
             bool intersectsBrush(const Brush& brush) const;
             bool containsBrush(const Brush& brush) const;
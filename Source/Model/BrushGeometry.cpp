@@ -22,6 +22,7 @@
 #include "Model/Face.h"
 #include "Utility/List.h"
 
+#include <algorithm>
 #include <map>
 #include <cstdio>
 
@@ -115,6 +116,8 @@ namespace TrenchBroom {
         Side::Side(Edge* newEdges[], bool invert[], unsigned int count) :
         face(NULL),
         mark(Side::New) {
+            vertices.reserve(count);
+            edges.reserve(count);
             for (unsigned int i = 0; i < count; i++) {
                 Edge* edge = newEdges[i];
                 edges.push_back(edge);
@@ -363,6 +366,20 @@ namespace TrenchBroom {
                          newEdge);
         }
 
+        void Side::flip() {
+            // reverse the order of the vertices and edges so that every edge still starts at the vertex with the same index
+            const size_t count = vertices.size();
+            VertexList newVertices(count);
+            EdgeList newEdges(count);
+            for (size_t i = 0; i < count; i++) {
+                newVertices[i] = vertices[(count - i) % count];
+                newEdges[i] = edges[count - i - 1];
+            }
+            
+            vertices = newVertices;
+            edges = newEdges;
+        }
+        
         void Side::shift(size_t offset) {
             size_t count = edges.size();
             if (offset % count == 0)
@@ -437,13 +454,7 @@ namespace TrenchBroom {
         }
 
         BrushGeometry::FaceManager::~FaceManager() {
-            CopyMap::iterator mapIt, mapEnd;
-            for (mapIt = m_newFaces.begin(), mapEnd = m_newFaces.end(); mapIt != mapEnd; ++mapIt) {
-                FaceSet& faces = mapIt->second;
-                FaceSet::iterator faceIt, faceEnd;
-                for (faceIt = faces.begin(), faceEnd = faces.end(); faceIt != faceEnd; ++faceIt)
-                    delete *faceIt;
-            }
+            clear();
         }
 
         void BrushGeometry::FaceManager::addFace(Face* original, Face* copy) {
@@ -507,6 +518,19 @@ namespace TrenchBroom {
             m_droppedFaces.clear();
         }
 
+        void BrushGeometry::FaceManager::clear() {
+            CopyMap::iterator mapIt, mapEnd;
+            for (mapIt = m_newFaces.begin(), mapEnd = m_newFaces.end(); mapIt != mapEnd; ++mapIt) {
+                FaceSet& faces = mapIt->second;
+                FaceSet::iterator faceIt, faceEnd;
+                for (faceIt = faces.begin(), faceEnd = faces.end(); faceIt != faceEnd; ++faceIt)
+                    delete *faceIt;
+            }
+
+            m_newFaces.clear();
+            m_droppedFaces.clear();
+        }
+
         void BrushGeometry::deleteDegenerateTriangle(Side* side, Edge* edge, FaceManager& faceManager) {
             assert(side->edges.size() == 3);
 
@@ -690,24 +714,37 @@ namespace TrenchBroom {
             assert(side->edges.size() == totalVertexCount);
         }
 
+        static inline Planef boundaryOfVertices(const Side* side) {
+            Planef boundary;
+            boundary.setPoints(side->vertices[0]->position,
+                               side->vertices[1]->position,
+                               side->vertices[2]->position);
+            return boundary;
+        }
+
         void BrushGeometry::mergeSides(FaceManager& faceManager) {
+            // every boundary is compared with all neighbours of its side, so compute each of them only once
+            std::vector<Planef> boundaries;
+            boundaries.reserve(sides.size());
+            for (size_t i = 0; i < sides.size(); i++)
+                boundaries.push_back(boundaryOfVertices(sides[i]));
+
             for (unsigned int i = 0; i < sides.size(); i++) {
                 Side* side = sides[i];
-                Planef sideBoundary;
-                sideBoundary.setPoints(side->vertices[0]->position,
-                                       side->vertices[1]->position,
-                                       side->vertices[2]->position);
+                const Planef sideBoundary = boundaries[i];
 
                 for (unsigned int j = 0; j < side->edges.size(); j++) {
                     Edge* edge = side->edges[j];
                     Side* neighbour = edge->left != side ? edge->left : edge->right;
-                    Planef neighbourBoundary;
-                    neighbourBoundary.setPoints(neighbour->vertices[0]->position,
-                                                neighbour->vertices[1]->position,
-                                                neighbour->vertices[2]->position);
+                    const size_t neighbourIndex = findElement(sides, neighbour);
+                    assert(neighbourIndex < sides.size());
 
-                    if (sideBoundary.equals(neighbourBoundary, Math<float>::ColinearEpsilon)) {
+                    if (sideBoundary.equals(boundaries[neighbourIndex], Math<float>::ColinearEpsilon)) {
                         mergeNeighbours(side, j, faceManager);
+                        boundaries.erase(boundaries.begin() + neighbourIndex);
+
+                        // merging shifts the vertices of side, the other sides are unchanged
+                        boundaries[findElement(sides, side)] = boundaryOfVertices(side);
                         i -= 1;
                         break;
                     }
@@ -1036,37 +1073,74 @@ namespace TrenchBroom {
             return newVertex;
         }
 
-        void BrushGeometry::copy(const BrushGeometry& original) {
-            std::map<Vertex*, Vertex*> vertexMap;
-            std::map<Edge*, Edge*> edgeMap;
+        // maps the elements of a geometry to their copies without allocating a node for each of them
+        template <class T>
+        class CopyLookup {
+        private:
+            typedef std::pair<T*, T*> Entry;
+            typedef std::vector<Entry> EntryList;
+            EntryList m_entries;
+        public:
+            CopyLookup(size_t count) {
+                m_entries.reserve(count);
+            }
 
-            Utility::deleteAll(vertices);
-            Utility::deleteAll(edges);
-            Utility::deleteAll(sides);
+            inline void add(T* original, T* copy) {
+                m_entries.push_back(Entry(original, copy));
+            }
 
-            vertices.reserve(original.vertices.size());
-            edges.reserve(original.edges.size());
-            sides.reserve(original.sides.size());
+            inline void sort() {
+                std::sort(m_entries.begin(), m_entries.end());
+            }
+
+            inline T* operator[](T* original) const {
+                typename EntryList::const_iterator it = std::lower_bound(m_entries.begin(), m_entries.end(), Entry(original, NULL));
+                assert(it != m_entries.end() && it->first == original);
+                return it->second;
+            }
+        };
+
+        // resizes the given list, keeping the existing elements so that they can be overwritten
+        template <class T>
+        inline void resizeElements(std::vector<T*>& elements, size_t size) {
+            if (elements.size() > size)
+                Utility::deleteAll(elements, elements.begin() + size);
+            elements.reserve(size);
+            while (elements.size() < size)
+                elements.push_back(new T());
+        }
+
+        void BrushGeometry::copy(const BrushGeometry& original) {
+            CopyLookup<Vertex> vertexMap(original.vertices.size());
+            CopyLookup<Edge> edgeMap(original.edges.size());
+
+            resizeElements(vertices, original.vertices.size());
+            resizeElements(edges, original.edges.size());
+            resizeElements(sides, original.sides.size());
 
             for (size_t i = 0; i < original.vertices.size(); i++) {
                 Vertex* originalVertex = original.vertices[i];
-                Vertex* copyVertex = new Vertex(*originalVertex);
-                vertexMap[originalVertex] = copyVertex;
-                vertices.push_back(copyVertex);
+                Vertex* copyVertex = vertices[i];
+                *copyVertex = *originalVertex;
+                vertexMap.add(originalVertex, copyVertex);
             }
+            vertexMap.sort();
 
             for (size_t i = 0; i < original.edges.size(); i++) {
                 Edge* originalEdge = original.edges[i];
-                Edge* copyEdge = new Edge(*originalEdge);
+                Edge* copyEdge = edges[i];
+                *copyEdge = *originalEdge;
                 copyEdge->start = vertexMap[originalEdge->start];
                 copyEdge->end = vertexMap[originalEdge->end];
-                edgeMap[originalEdge] = copyEdge;
-                edges.push_back(copyEdge);
+                edgeMap.add(originalEdge, copyEdge);
             }
+            edgeMap.sort();
 
             for (size_t i = 0; i < original.sides.size(); i++) {
                 Side* originalSide = original.sides[i];
-                Side* copySide = new Side(*originalSide);
+                Side* copySide = sides[i];
+                copySide->face = originalSide->face;
+                copySide->mark = originalSide->mark;
                 copySide->vertices.clear();
                 copySide->edges.clear();
 
@@ -1081,11 +1155,129 @@ namespace TrenchBroom {
                     copySide->edges.push_back(copyEdge);
                     copySide->vertices.push_back(copyEdge->startVertex(copySide));
                 }
-
-                sides.push_back(copySide);
             }
 
             bounds = original.bounds;
+            center = original.center;
+        }
+
+        class BrushGeometry::Trial {
+        public:
+            TrialType type;
+            Vec3f delta;
+            Vec3f::List positions;
+            std::vector<size_t> counts;
+            bool valid;
+            bool success;
+
+            BrushGeometry* geometry;
+            FaceManager faceManager;
+            Vec3f::List newVertexPositions;
+
+            // the faces of the original geometry and their states before and after the edit
+            FaceList faces;
+            std::vector<Face::GeometryState> originalStates;
+            std::vector<Face::GeometryState> trialStates;
+
+            Trial(BrushGeometry* i_geometry) :
+            valid(false),
+            success(false),
+            geometry(i_geometry) {}
+
+            ~Trial() {
+                delete geometry;
+                geometry = NULL;
+            }
+        };
+
+        bool BrushGeometry::hasTrial(TrialType type, const Vec3f& delta, const Vec3f::List& positions, const std::vector<size_t>& counts) const {
+            return (m_trial != NULL &&
+                    m_trial->valid &&
+                    m_trial->type == type &&
+                    m_trial->delta == delta &&
+                    m_trial->positions == positions &&
+                    m_trial->counts == counts);
+        }
+
+        BrushGeometry::Trial& BrushGeometry::beginTrial(TrialType type, const Vec3f& delta, const Vec3f::List& positions, const std::vector<size_t>& counts) {
+            if (m_trial == NULL)
+                m_trial = new Trial(new BrushGeometry());
+            else
+                m_trial->faceManager.clear();
+
+            Trial& trial = *m_trial;
+            trial.type = type;
+            trial.delta = delta;
+            trial.positions = positions;
+            trial.counts = counts;
+            trial.valid = false;
+            trial.success = false;
+            trial.newVertexPositions.clear();
+
+            trial.faces.clear();
+            trial.originalStates.clear();
+            for (size_t i = 0; i < sides.size(); i++) {
+                Face* face = sides[i]->face;
+                trial.faces.push_back(face);
+                trial.originalStates.push_back(face->geometryState());
+            }
+
+            trial.geometry->copy(*this);
+            trial.geometry->restoreFaceSides();
+            return trial;
+        }
+
+        bool BrushGeometry::endTrial(bool success) {
+            Trial& trial = *m_trial;
+            trial.valid = true;
+            trial.success = success;
+
+            trial.trialStates.clear();
+            for (size_t i = 0; i < trial.faces.size(); i++) {
+                Face* face = trial.faces[i];
+                trial.trialStates.push_back(face->geometryState());
+                face->setGeometryState(trial.originalStates[i]);
+            }
+            restoreFaceSides();
+
+            if (!success)
+                trial.faceManager.clear();
+            return success;
+        }
+
+        void BrushGeometry::commitTrial(FaceSet& newFaces, FaceSet& droppedFaces) {
+            assert(m_trial != NULL && m_trial->valid && m_trial->success);
+            if (m_trial == NULL || !m_trial->valid || !m_trial->success) {
+                newFaces.clear();
+                droppedFaces.clear();
+                return;
+            }
+
+            Trial& trial = *m_trial;
+            for (size_t i = 0; i < trial.faces.size(); i++)
+                trial.faces[i]->setGeometryState(trial.trialStates[i]);
+
+            // the replaced elements stay with the scratch geometry to be overwritten by the next trial
+            BrushGeometry& geometry = *trial.geometry;
+            std::swap(vertices, geometry.vertices);
+            std::swap(edges, geometry.edges);
+            std::swap(sides, geometry.sides);
+            std::swap(bounds, geometry.bounds);
+            std::swap(center, geometry.center);
+
+            for (size_t i = 0; i < sides.size(); i++)
+                if (sides[i]->face != NULL)
+                    sides[i]->face->setSide(sides[i]);
+
+            trial.faceManager.getFaces(newFaces, droppedFaces);
+            trial.valid = false;
+        }
+
+        void BrushGeometry::discardTrial() {
+            if (m_trial != NULL) {
+                m_trial->valid = false;
+                m_trial->faceManager.clear();
+            }
         }
 
         bool BrushGeometry::sanityCheck() {
@@ -1184,7 +1376,11 @@ namespace TrenchBroom {
             return true;
         }
 
-        BrushGeometry::BrushGeometry(const BBoxf& i_bounds) {
+        BrushGeometry::BrushGeometry() :
+        m_trial(NULL) {}
+
+        BrushGeometry::BrushGeometry(const BBoxf& i_bounds) :
+        m_trial(NULL) {
             Vertex* lfd = new Vertex(i_bounds.min.x(), i_bounds.min.y(), i_bounds.min.z());
             Vertex* lfu = new Vertex(i_bounds.min.x(), i_bounds.min.y(), i_bounds.max.z());
             Vertex* lbd = new Vertex(i_bounds.min.x(), i_bounds.max.y(), i_bounds.min.z());
@@ -1265,11 +1461,25 @@ namespace TrenchBroom {
             this->center = centerOfVertices(vertices);
         }
 
-        BrushGeometry::BrushGeometry(const BrushGeometry& original) {
+        void BrushGeometry::beginArena() {
+            Vertex::beginArena();
+            Edge::beginArena();
+            Side::beginArena();
+        }
+
+        void BrushGeometry::endArena() {
+            Side::endArena();
+            Edge::endArena();
+            Vertex::endArena();
+        }
+
+        BrushGeometry::BrushGeometry(const BrushGeometry& original) :
+        m_trial(NULL) {
             copy(original);
         }
 
         BrushGeometry::BrushGeometry(const Model::VertexList& i_vertices, const Model::EdgeList& i_edges, const Model::SideList& i_sides) :
+        m_trial(NULL),
         vertices(i_vertices),
         edges(i_edges),
         sides(i_sides) {
@@ -1278,6 +1488,8 @@ namespace TrenchBroom {
         }
 
         BrushGeometry::~BrushGeometry() {
+            delete m_trial;
+            m_trial = NULL;
             Utility::deleteAll(sides);
             Utility::deleteAll(edges);
             Utility::deleteAll(vertices);
@@ -1295,7 +1507,30 @@ namespace TrenchBroom {
                 sides[i]->face->setSide(sides[i]);
         }
 
+        void BrushGeometry::transform(const Mat4f& pointTransform, bool invertOrientation) {
+            discardTrial();
+
+            for (size_t i = 0; i < vertices.size(); i++) {
+                Vec3f& position = vertices[i]->position;
+                position = pointTransform * position;
+                position.correct();
+            }
+            
+            if (invertOrientation) {
+                // a mirrored edge has its sides swapped
+                for (size_t i = 0; i < edges.size(); i++)
+                    std::swap(edges[i]->start, edges[i]->end);
+                for (size_t i = 0; i < sides.size(); i++)
+                    sides[i]->flip();
+            }
+            
+            bounds = boundsOfVertices(vertices);
+            center = centerOfVertices(vertices);
+        }
+        
         BrushGeometry::CutResult BrushGeometry::addFace(Face& face, FaceSet& droppedFaces) {
+            discardTrial();
+
             // if all of the face's points are on a previous face, it's a duplicate
             for (size_t i = 0; i < sides.size(); i++) {
                 const Side& side = *sides[i];
@@ -1448,6 +1683,8 @@ namespace TrenchBroom {
         }
 
         bool BrushGeometry::addFaces(const FaceList& faces, FaceSet& droppedFaces) {
+            discardTrial();
+
             for (size_t i = 0; i < faces.size(); i++) {
                 CutResult result = addFace(*faces[i], droppedFaces);
                 if (result == Redundant)
@@ -1474,6 +1711,8 @@ namespace TrenchBroom {
         }
 
         void BrushGeometry::correct(FaceSet& newFaces, FaceSet& droppedFaces, float epsilon) {
+            discardTrial();
+
             assert(epsilon >= 0.0f);
 
             Vec3f::Map positions;
@@ -1507,6 +1746,8 @@ namespace TrenchBroom {
         }
 
         void BrushGeometry::snap(FaceSet& newFaces, FaceSet& droppedFaces, unsigned int snapTo) {
+            discardTrial();
+
             assert(snapTo > 0);
 
             Vec3f::Map positions;
@@ -1544,40 +1785,7 @@ namespace TrenchBroom {
             return vertex->incidentSides(edges);
         }
 
-        bool BrushGeometry::canMoveVertices(const BBoxf& worldBounds, const Vec3f::List& vertexPositions, const Vec3f& delta) {
-            FaceManager faceManager;
-
-            BrushGeometry testGeometry(*this);
-            testGeometry.restoreFaceSides();
-
-            Vec3f::List sortedVertexPositions = vertexPositions;
-            std::sort(sortedVertexPositions.begin(), sortedVertexPositions.end(), Vec3f::InverseDotOrder(delta));
-
-            bool canMove = true;
-            Vec3f::List::const_iterator vertexIt, vertexEnd;
-            for (vertexIt = sortedVertexPositions.begin(), vertexEnd = sortedVertexPositions.end(); vertexIt != vertexEnd && canMove; ++vertexIt) {
-                const Vec3f& vertexPosition = *vertexIt;
-                Vertex* vertex = findVertex(testGeometry.vertices, vertexPosition);
-                assert(vertex != NULL);
-
-                const Vec3f start = vertex->position;
-                const Vec3f end = start + delta;
-
-                MoveVertexResult result = testGeometry.moveVertex(vertex, true, start, end, faceManager);
-                canMove = result.type != MoveVertexResult::VertexUnchanged;
-            }
-
-            canMove &= testGeometry.sides.size() >= 3;
-            canMove &= worldBounds.contains(testGeometry.bounds);
-
-            restoreFaceSides();
-            return canMove;
-        }
-
-        Vec3f::List BrushGeometry::moveVertices(const BBoxf& worldBounds, const Vec3f::List& vertexPositions, const Vec3f& delta, FaceSet& newFaces, FaceSet& droppedFaces) {
-            assert(canMoveVertices(worldBounds, vertexPositions, delta));
-
-            FaceManager faceManager;
+        bool BrushGeometry::applyMoveVertices(const BBoxf& worldBounds, const Vec3f::List& vertexPositions, const Vec3f& delta, FaceManager& faceManager, Vec3f::List& newVertexPositions) {
             VertexList movedVertices;
             Vec3f::List sortedVertexPositions = vertexPositions;
             std::sort(sortedVertexPositions.begin(), sortedVertexPositions.end(), Vec3f::InverseDotOrder(delta));
@@ -1592,26 +1800,23 @@ namespace TrenchBroom {
                 const Vec3f end = start + delta;
 
                 MoveVertexResult result = moveVertex(vertex, true, start, end, faceManager);
+                if (result.type == MoveVertexResult::VertexUnchanged)
+                    return false;
                 if (result.type == MoveVertexResult::VertexMoved)
                     movedVertices.push_back(result.vertex);
                 updateFacePoints(faceManager);
             }
 
-            Vec3f::List newVertexPositions;
+            if (sides.size() < 3 || !worldBounds.contains(bounds))
+                return false;
+
             newVertexPositions.reserve(movedVertices.size());
             for (unsigned int i = 0; i < movedVertices.size(); i++)
                 newVertexPositions.push_back(movedVertices[i]->position);
-
-            faceManager.getFaces(newFaces, droppedFaces);
-            return newVertexPositions;
+            return true;
         }
 
-        bool BrushGeometry::canMoveEdges(const BBoxf& worldBounds, const EdgeInfoList& edgeInfos, const Vec3f& delta) {
-            FaceManager faceManager;
-
-            BrushGeometry testGeometry(*this);
-            testGeometry.restoreFaceSides();
-
+        bool BrushGeometry::applyMoveEdges(const BBoxf& worldBounds, const EdgeInfoList& edgeInfos, const Vec3f& delta, FaceManager& faceManager) {
             Vec3f::List sortedVertexPositions;
             EdgeInfoList::const_iterator edgeIt, edgeEnd;
             for (edgeIt = edgeInfos.begin(), edgeEnd = edgeInfos.end(); edgeIt != edgeEnd; ++edgeIt) {
@@ -1621,48 +1826,39 @@ namespace TrenchBroom {
             }
             std::sort(sortedVertexPositions.begin(), sortedVertexPositions.end(), Vec3f::InverseDotOrder(delta));
 
-            bool canMove = true;
             Vec3f::List::const_iterator vertexIt, vertexEnd;
             for (vertexIt = sortedVertexPositions.begin(), vertexEnd = sortedVertexPositions.end(); vertexIt != vertexEnd; ++vertexIt) {
                 const Vec3f& vertexPosition = *vertexIt;
-                Vertex* vertex = findVertex(testGeometry.vertices, vertexPosition);
-                if (vertex == NULL) {
-                    canMove = false;
-                    break;
-                }
+                Vertex* vertex = findVertex(vertices, vertexPosition);
+                if (vertex == NULL)
+                    return false;
 
                 const Vec3f start = vertex->position;
                 const Vec3f end = start + delta;
 
-                MoveVertexResult result = testGeometry.moveVertex(vertex, false, start, end, faceManager);
-                if (result.type != MoveVertexResult::VertexMoved) {
-                    canMove = false;
-                    break;
-                }
+                MoveVertexResult result = moveVertex(vertex, false, start, end, faceManager);
+                if (result.type != MoveVertexResult::VertexMoved)
+                    return false;
+                updateFacePoints(faceManager);
             }
 
-            for (edgeIt = edgeInfos.begin(), edgeEnd = edgeInfos.end(); edgeIt != edgeEnd && canMove; ++edgeIt) {
+            for (edgeIt = edgeInfos.begin(), edgeEnd = edgeInfos.end(); edgeIt != edgeEnd; ++edgeIt) {
                 const EdgeInfo& edgeInfo = *edgeIt;
-                canMove = findEdge(testGeometry.edges, edgeInfo.start + delta, edgeInfo.end + delta) != NULL;
+                if (findEdge(edges, edgeInfo.start + delta, edgeInfo.end + delta) == NULL)
+                    return false;
             }
 
-            canMove &= testGeometry.sides.size() >= 3;
-            canMove &= worldBounds.contains(testGeometry.bounds);
-
-            restoreFaceSides();
-            return canMove;
+            return sides.size() >= 3 && worldBounds.contains(bounds);
         }
 
-        EdgeInfoList BrushGeometry::moveEdges(const BBoxf& worldBounds, const EdgeInfoList& i_edges, const Vec3f& delta, FaceSet& newFaces, FaceSet& droppedFaces) {
-            assert(canMoveEdges(worldBounds, i_edges, delta));
-
-            FaceManager faceManager;
+        bool BrushGeometry::applyMoveFaces(const BBoxf& worldBounds, const FaceInfoList& faceInfos, const Vec3f& delta, FaceManager& faceManager) {
             Vec3f::List sortedVertexPositions;
-            EdgeInfoList::const_iterator edgeIt, edgeEnd;
-            for (edgeIt = i_edges.begin(), edgeEnd = i_edges.end(); edgeIt != edgeEnd; ++edgeIt) {
-                const EdgeInfo& edgeInfo = *edgeIt;
-                sortedVertexPositions.push_back(edgeInfo.start);
-                sortedVertexPositions.push_back(edgeInfo.end);
+            FaceInfoList::const_iterator faceIt, faceEnd;
+            for (faceIt = faceInfos.begin(), faceEnd = faceInfos.end(); faceIt != faceEnd; ++faceIt) {
+                const FaceInfo& faceInfo = *faceIt;
+                Vec3f::List::const_iterator vertexIt, vertexEnd;
+                for (vertexIt = faceInfo.vertices.begin(), vertexEnd = faceInfo.vertices.end(); vertexIt != vertexEnd; ++vertexIt)
+                    sortedVertexPositions.push_back(*vertexIt);
             }
             std::sort(sortedVertexPositions.begin(), sortedVertexPositions.end(), Vec3f::InverseDotOrder(delta));
 
@@ -1670,115 +1866,155 @@ namespace TrenchBroom {
             for (vertexIt = sortedVertexPositions.begin(), vertexEnd = sortedVertexPositions.end(); vertexIt != vertexEnd; ++vertexIt) {
                 const Vec3f& vertexPosition = *vertexIt;
                 Vertex* vertex = findVertex(vertices, vertexPosition);
-                assert(vertex != NULL);
+                if (vertex == NULL)
+                    return false;
 
                 const Vec3f start = vertex->position;
                 const Vec3f end = start + delta;
 
                 MoveVertexResult result = moveVertex(vertex, false, start, end, faceManager);
-                assert(result.type == MoveVertexResult::VertexMoved);
-                updateFacePoints(faceManager);
+                if (result.type != MoveVertexResult::VertexMoved)
+                    return false;
             }
 
-            faceManager.getFaces(newFaces, droppedFaces);
+            updateFacePoints(faceManager);
 
-            EdgeInfoList result;
-            EdgeInfoList::const_iterator infoIt, infoEnd;
-            for (infoIt = i_edges.begin(), infoEnd = i_edges.end(); infoIt != infoEnd; ++infoIt) {
-                const EdgeInfo& info = *infoIt;
-                assert(findEdge(edges, info.start + delta, info.end + delta) != NULL);
-                result.push_back(EdgeInfo(info.start + delta, info.end + delta));
+            for (faceIt = faceInfos.begin(), faceEnd = faceInfos.end(); faceIt != faceEnd; ++faceIt) {
+                const FaceInfo& faceInfo = *faceIt;
+                const FaceInfo translated = faceInfo.translated(delta);
+                Side* side = findSide(sides, translated.vertices);
+                if (side == NULL || side->face == NULL)
+                    return false;
             }
 
-            return result;
+            return sides.size() >= 3 && worldBounds.contains(bounds);
         }
 
-        bool BrushGeometry::canMoveFaces(const BBoxf& worldBounds, const FaceInfoList& faceInfos, const Vec3f& delta) {
-            FaceManager faceManager;
+        bool BrushGeometry::applySplitEdge(const BBoxf& worldBounds, const EdgeInfo& edgeInfo, const Vec3f& delta, FaceManager& faceManager, Vec3f::List& newVertexPositions) {
+            Edge* edge = findEdge(edges, edgeInfo.start, edgeInfo.end);
+            assert(edge != NULL);
 
-            BrushGeometry testGeometry(*this);
-            testGeometry.restoreFaceSides();
+            Vertex* newVertex = splitEdge(edge);
+            const Vec3f start = newVertex->position;
+            const Vec3f end = start + delta;
+            MoveVertexResult result = moveVertex(newVertex, false, start, end, faceManager);
+            if (result.type != MoveVertexResult::VertexMoved)
+                return false;
 
-            Vec3f::List sortedVertexPositions;
-            FaceInfoList::const_iterator faceIt, faceEnd;
-            for (faceIt = faceInfos.begin(), faceEnd = faceInfos.end(); faceIt != faceEnd; ++faceIt) {
-                const FaceInfo& faceInfo = *faceIt;
-                Vec3f::List::const_iterator vertexIt, vertexEnd;
-                for (vertexIt = faceInfo.vertices.begin(), vertexEnd = faceInfo.vertices.end(); vertexIt != vertexEnd; ++vertexIt)
-                    sortedVertexPositions.push_back(*vertexIt);
-            }
-            std::sort(sortedVertexPositions.begin(), sortedVertexPositions.end(), Vec3f::InverseDotOrder(delta));
+            updateFacePoints(faceManager);
+            if (sides.size() < 3 || !worldBounds.contains(bounds))
+                return false;
 
-            bool canMove = true;
-            Vec3f::List::const_iterator vertexIt, vertexEnd;
-            for (vertexIt = sortedVertexPositions.begin(), vertexEnd = sortedVertexPositions.end(); vertexIt != vertexEnd; ++vertexIt) {
-                const Vec3f& vertexPosition = *vertexIt;
-                Vertex* vertex = findVertex(testGeometry.vertices, vertexPosition);
-                if (vertex == NULL) {
-                    canMove = false;
-                    break;
-                }
+            newVertexPositions.push_back(result.vertex->position);
+            return true;
+        }
 
-                const Vec3f start = vertex->position;
-                const Vec3f end = start + delta;
+        bool BrushGeometry::applySplitFace(const BBoxf& worldBounds, const FaceInfo& faceInfo, const Vec3f& delta, FaceManager& faceManager, Vec3f::List& newVertexPositions) {
+            Side* side = findSide(sides, faceInfo.vertices);
+            assert(side != NULL);
 
-                MoveVertexResult result = testGeometry.moveVertex(vertex, false, start, end, faceManager);
-                if (result.type != MoveVertexResult::VertexMoved) {
-                    canMove = false;
-                    break;
-                }
-            }
+            Face* face = side->face;
+            assert(face != NULL);
 
-            canMove &= testGeometry.sides.size() >= 3;
-            canMove &= worldBounds.contains(testGeometry.bounds);
+            Vertex* newVertex = splitFace(face, faceManager);
+            const Vec3f start = newVertex->position;
+            const Vec3f end = start + delta;
+            MoveVertexResult result = moveVertex(newVertex, false, start, end, faceManager);
+            if (result.type != MoveVertexResult::VertexMoved)
+                return false;
 
-            for (faceIt = faceInfos.begin(), faceEnd = faceInfos.end(); faceIt != faceEnd; ++faceIt) {
-                const FaceInfo& faceInfo = *faceIt;
-                const FaceInfo translated = faceInfo.translated(delta);
-                canMove = findSide(testGeometry.sides, translated.vertices) != NULL;
-            }
+            updateFacePoints(faceManager);
+            if (sides.size() < 3 || !worldBounds.contains(bounds))
+                return false;
 
-            restoreFaceSides();
-            return canMove;
+            newVertexPositions.push_back(result.vertex->position);
+            return true;
         }
 
-        FaceInfoList BrushGeometry::moveFaces(const BBoxf& worldBounds, const FaceInfoList& faceInfos, const Vec3f& delta, FaceSet& newFaces, FaceSet& droppedFaces) {
-            assert(canMoveFaces(worldBounds, faceInfos, delta));
+        // the positions and vertex counts by which a trial of an edge or face edit is recognized
+        static void edgeInfoPositions(const EdgeInfoList& edgeInfos, Vec3f::List& positions) {
+            EdgeInfoList::const_iterator it, end;
+            for (it = edgeInfos.begin(), end = edgeInfos.end(); it != end; ++it) {
+                positions.push_back(it->start);
+                positions.push_back(it->end);
+            }
+        }
 
-            FaceManager faceManager;
-            Vec3f::List sortedVertexPositions;
-            FaceInfoList::const_iterator faceIt, faceEnd;
-            for (faceIt = faceInfos.begin(), faceEnd = faceInfos.end(); faceIt != faceEnd; ++faceIt) {
-                const FaceInfo& faceInfo = *faceIt;
-                Vec3f::List::const_iterator vertexIt, vertexEnd;
-                for (vertexIt = faceInfo.vertices.begin(), vertexEnd = faceInfo.vertices.end(); vertexIt != vertexEnd; ++vertexIt)
-                    sortedVertexPositions.push_back(*vertexIt);
+        static void faceInfoPositions(const FaceInfoList& faceInfos, Vec3f::List& positions, std::vector<size_t>& counts) {
+            FaceInfoList::const_iterator it, end;
+            for (it = faceInfos.begin(), end = faceInfos.end(); it != end; ++it) {
+                positions.insert(positions.end(), it->vertices.begin(), it->vertices.end());
+                counts.push_back(it->vertices.size());
             }
-            std::sort(sortedVertexPositions.begin(), sortedVertexPositions.end(), Vec3f::InverseDotOrder(delta));
+        }
 
-            Vec3f::List::const_iterator vertexIt, vertexEnd;
-            for (vertexIt = sortedVertexPositions.begin(), vertexEnd = sortedVertexPositions.end(); vertexIt != vertexEnd; ++vertexIt) {
-                const Vec3f& vertexPosition = *vertexIt;
-                Vertex* vertex = findVertex(vertices, vertexPosition);
-                assert(vertex != NULL);
+        bool BrushGeometry::canMoveVertices(const BBoxf& worldBounds, const Vec3f::List& vertexPositions, const Vec3f& delta) {
+            if (hasTrial(MoveVerticesTrial, delta, vertexPositions, std::vector<size_t>()))
+                return m_trial->success;
 
-                const Vec3f start = vertex->position;
-                const Vec3f end = start + delta;
+            Trial& trial = beginTrial(MoveVerticesTrial, delta, vertexPositions, std::vector<size_t>());
+            return endTrial(trial.geometry->applyMoveVertices(worldBounds, vertexPositions, delta, trial.faceManager, trial.newVertexPositions));
+        }
 
-                MoveVertexResult result = moveVertex(vertex, false, start, end, faceManager);
-                assert(result.type == MoveVertexResult::VertexMoved);
+        Vec3f::List BrushGeometry::moveVertices(const BBoxf& worldBounds, const Vec3f::List& vertexPositions, const Vec3f& delta, FaceSet& newFaces, FaceSet& droppedFaces) {
+            const bool canMove = canMoveVertices(worldBounds, vertexPositions, delta);
+            assert(canMove);
+
+            const Vec3f::List newVertexPositions = m_trial->newVertexPositions;
+            commitTrial(newFaces, droppedFaces);
+            return newVertexPositions;
+        }
+
+        bool BrushGeometry::canMoveEdges(const BBoxf& worldBounds, const EdgeInfoList& edgeInfos, const Vec3f& delta) {
+            Vec3f::List positions;
+            edgeInfoPositions(edgeInfos, positions);
+
+            if (hasTrial(MoveEdgesTrial, delta, positions, std::vector<size_t>()))
+                return m_trial->success;
+
+            Trial& trial = beginTrial(MoveEdgesTrial, delta, positions, std::vector<size_t>());
+            return endTrial(trial.geometry->applyMoveEdges(worldBounds, edgeInfos, delta, trial.faceManager));
+        }
+
+        EdgeInfoList BrushGeometry::moveEdges(const BBoxf& worldBounds, const EdgeInfoList& i_edges, const Vec3f& delta, FaceSet& newFaces, FaceSet& droppedFaces) {
+            const bool canMove = canMoveEdges(worldBounds, i_edges, delta);
+            assert(canMove);
+            commitTrial(newFaces, droppedFaces);
+
+            EdgeInfoList result;
+            EdgeInfoList::const_iterator infoIt, infoEnd;
+            for (infoIt = i_edges.begin(), infoEnd = i_edges.end(); infoIt != infoEnd; ++infoIt) {
+                const EdgeInfo& info = *infoIt;
+                assert(findEdge(edges, info.start + delta, info.end + delta) != NULL);
+                result.push_back(EdgeInfo(info.start + delta, info.end + delta));
             }
 
-            updateFacePoints(faceManager);
-            faceManager.getFaces(newFaces, droppedFaces);
+            return result;
+        }
+
+        bool BrushGeometry::canMoveFaces(const BBoxf& worldBounds, const FaceInfoList& faceInfos, const Vec3f& delta) {
+            Vec3f::List positions;
+            std::vector<size_t> counts;
+            faceInfoPositions(faceInfos, positions, counts);
+
+            if (hasTrial(MoveFacesTrial, delta, positions, counts))
+                return m_trial->success;
+
+            Trial& trial = beginTrial(MoveFacesTrial, delta, positions, counts);
+            return endTrial(trial.geometry->applyMoveFaces(worldBounds, faceInfos, delta, trial.faceManager));
+        }
+
+        FaceInfoList BrushGeometry::moveFaces(const BBoxf& worldBounds, const FaceInfoList& faceInfos, const Vec3f& delta, FaceSet& newFaces, FaceSet& droppedFaces) {
+            const bool canMove = canMoveFaces(worldBounds, faceInfos, delta);
+            assert(canMove);
+            commitTrial(newFaces, droppedFaces);
 
             FaceInfoList result;
+            FaceInfoList::const_iterator faceIt, faceEnd;
             for (faceIt = faceInfos.begin(), faceEnd = faceInfos.end(); faceIt != faceEnd; ++faceIt) {
                 const FaceInfo& faceInfo = *faceIt;
                 const FaceInfo translated = faceInfo.translated(delta);
-                Side* side = findSide(sides, translated.vertices);
-                assert(side != NULL);
-                assert(side->face != NULL);
+                assert(findSide(sides, translated.vertices) != NULL);
                 result.push_back(translated);
             }
             return result;
@@ -1799,42 +2035,26 @@ namespace TrenchBroom {
                 Math<float>::neg(delta.dot(rightNorm), 0.01f))
                 return false;
 
-            FaceManager faceManager;
-
-            BrushGeometry testGeometry(*this);
-            testGeometry.restoreFaceSides();
+            Vec3f::List positions;
+            positions.push_back(edgeInfo.start);
+            positions.push_back(edgeInfo.end);
 
-            // The given edge is not an edge of testGeometry!
-            Edge* testEdge = findEdge(testGeometry.edges, edgeInfo.start, edgeInfo.end);
-            assert(testEdge != NULL);
-
-            Vertex* newVertex = testGeometry.splitEdge(testEdge);
-            const Vec3f start = newVertex->position;
-            const Vec3f end = start + delta;
-            MoveVertexResult result = testGeometry.moveVertex(newVertex, false, start, end, faceManager);
-            bool canSplit = result.type == MoveVertexResult::VertexMoved;
-            canSplit &= testGeometry.sides.size() >= 3;
-            canSplit &= worldBounds.contains(testGeometry.bounds);
+            if (hasTrial(SplitEdgeTrial, delta, positions, std::vector<size_t>()))
+                return m_trial->success;
 
-            restoreFaceSides();
-            return canSplit;
+            Trial& trial = beginTrial(SplitEdgeTrial, delta, positions, std::vector<size_t>());
+            return endTrial(trial.geometry->applySplitEdge(worldBounds, edgeInfo, delta, trial.faceManager, trial.newVertexPositions));
         }
 
         Vec3f BrushGeometry::splitEdge(const BBoxf& worldBounds, const EdgeInfo& edgeInfo, const Vec3f& delta, FaceSet& newFaces, FaceSet& droppedFaces) {
-            assert(canSplitEdge(worldBounds, edgeInfo, delta));
-
-            Edge* edge = findEdge(edges, edgeInfo.start, edgeInfo.end);
-
-            FaceManager faceManager;
-            Vertex* newVertex = splitEdge(edge);
-            const Vec3f start = newVertex->position;
-            const Vec3f end = start + delta;
-            MoveVertexResult result = moveVertex(newVertex, false, start, end, faceManager);
-            assert(result.type == MoveVertexResult::VertexMoved);
-
-            updateFacePoints(faceManager);
-            faceManager.getFaces(newFaces, droppedFaces);
-            return result.vertex->position;
+            const bool canSplit = canSplitEdge(worldBounds, edgeInfo, delta);
+            assert(canSplit);
+            if (!canSplit)
+                return Vec3f::NaN;
+
+            const Vec3f newVertexPosition = m_trial->newVertexPositions.front();
+            commitTrial(newFaces, droppedFaces);
+            return newVertexPosition;
         }
 
         bool BrushGeometry::canSplitFace(const BBoxf& worldBounds, const FaceInfo& faceInfo, const Vec3f& delta) {
@@ -1850,42 +2070,22 @@ namespace TrenchBroom {
             if (Math<float>::zero(delta.dot(norm)))
                 return false;
 
-            FaceManager faceManager;
-
-            BrushGeometry testGeometry(*this);
-            testGeometry.restoreFaceSides();
+            if (hasTrial(SplitFaceTrial, delta, faceInfo.vertices, std::vector<size_t>()))
+                return m_trial->success;
 
-            Vertex* newVertex = testGeometry.splitFace(face, faceManager);
-            const Vec3f start = newVertex->position;
-            const Vec3f end = start + delta;
-            MoveVertexResult result = testGeometry.moveVertex(newVertex, false, start, end, faceManager);
-            bool canSplit = result.type == MoveVertexResult::VertexMoved;
-            canSplit &= testGeometry.sides.size() >= 3;
-            canSplit &= worldBounds.contains(testGeometry.bounds);
-
-            restoreFaceSides();
-            return canSplit;
+            Trial& trial = beginTrial(SplitFaceTrial, delta, faceInfo.vertices, std::vector<size_t>());
+            return endTrial(trial.geometry->applySplitFace(worldBounds, faceInfo, delta, trial.faceManager, trial.newVertexPositions));
         }
 
         Vec3f BrushGeometry::splitFace(const BBoxf& worldBounds, const FaceInfo& faceInfo, const Vec3f& delta, FaceSet& newFaces, FaceSet& droppedFaces) {
-            assert(canSplitFace(worldBounds, faceInfo, delta));
-
-            Side* side = findSide(sides, faceInfo.vertices);
-            assert(side != NULL);
-
-            Face* face = side->face;
-            assert(face != NULL);
-
-            FaceManager faceManager;
-            Vertex* newVertex = splitFace(face, faceManager);
-            const Vec3f start = newVertex->position;
-            const Vec3f end = start + delta;
-            MoveVertexResult result = moveVertex(newVertex, false, start, end, faceManager);
-            assert(result.type == MoveVertexResult::VertexMoved);
-
-            updateFacePoints(faceManager);
-            faceManager.getFaces(newFaces, droppedFaces);
-            return result.vertex->position;
+            const bool canSplit = canSplitFace(worldBounds, faceInfo, delta);
+            assert(canSplit);
+            if (!canSplit)
+                return Vec3f::NaN;
+
+            const Vec3f newVertexPosition = m_trial->newVertexPositions.front();
+            commitTrial(newFaces, droppedFaces);
+            return newVertexPosition;
         }
 
         Vertex* findVertex(const VertexList& vertices, const Vec3f& position, float epsilon) {
@@ -317,8 +317,41 @@ namespace TrenchBroom {
                 void addFace(Face* original, Face* copy);
                 void dropFace(Side* side);
                 void getFaces(FaceSet& newFaces, FaceSet& droppedFaces);
+                void clear();
             };
 
+            /*
+             * The can* methods run the edit on a scratch geometry that is kept with this geometry and reused for the
+             * next check, e.g. on the next drag event. The result of the last trial is kept until the next trial, and
+             * the edit method with the same arguments commits it instead of running the edit again. Any other change
+             * to this geometry discards the trial.
+             */
+            enum TrialType {
+                MoveVerticesTrial,
+                MoveEdgesTrial,
+                MoveFacesTrial,
+                SplitEdgeTrial,
+                SplitFaceTrial
+            };
+
+            class Trial;
+            Trial* m_trial;
+
+            BrushGeometry();
+            BrushGeometry& operator=(const BrushGeometry& other);
+
+            bool hasTrial(TrialType type, const Vec3f& delta, const Vec3f::List& positions, const std::vector<size_t>& counts) const;
+            Trial& beginTrial(TrialType type, const Vec3f& delta, const Vec3f::List& positions, const std::vector<size_t>& counts);
+            bool endTrial(bool success);
+            void commitTrial(FaceSet& newFaces, FaceSet& droppedFaces);
+            void discardTrial();
+
+            bool applyMoveVertices(const BBoxf& worldBounds, const Vec3f::List& vertexPositions, const Vec3f& delta, FaceManager& faceManager, Vec3f::List& newVertexPositions);
+            bool applyMoveEdges(const BBoxf& worldBounds, const EdgeInfoList& edgeInfos, const Vec3f& delta, FaceManager& faceManager);
+            bool applyMoveFaces(const BBoxf& worldBounds, const FaceInfoList& faceInfos, const Vec3f& delta, FaceManager& faceManager);
+            bool applySplitEdge(const BBoxf& worldBounds, const EdgeInfo& edgeInfo, const Vec3f& delta, FaceManager& faceManager, Vec3f::List& newVertexPositions);
+            bool applySplitFace(const BBoxf& worldBounds, const FaceInfo& faceInfo, const Vec3f& delta, FaceManager& faceManager, Vec3f::List& newVertexPositions);
+
             void deleteDegenerateTriangle(Side* side, Edge* edge, FaceManager& faceManager);
             void mergeEdges();
             void mergeNeighbours(Side* side, size_t edgeIndex, FaceManager& faceManager);
@@ -331,6 +364,25 @@ namespace TrenchBroom {
             void copy(const BrushGeometry& original);
             bool sanityCheck();
         public:
+            /*
+             * Vertices, edges and sides that are created on this thread while an arena is active come from memory that is
+             * private to the thread, see Utility::Allocator::Arena. Use this for geometry that is built and thrown away,
+             * and on worker threads that build many brushes.
+             */
+            class ArenaScope {
+            public:
+                ArenaScope() {
+                    beginArena();
+                }
+
+                ~ArenaScope() {
+                    endArena();
+                }
+            };
+
+            static void beginArena();
+            static void endArena();
+
             VertexList vertices;
             EdgeList edges;
             SideList sides;
@@ -345,6 +397,14 @@ namespace TrenchBroom {
             bool closed() const;
             void restoreFaceSides();
 
+            /*
+             * Transforms the vertices without changing the topology. This is only correct if the transformation maps
+             * the faces of the brush onto faces which have the transformed planes, e.g. if it is a translation or a
+             * rotation by a multiple of 90 degrees. If the transformation is a mirroring, the orientation of the edges
+             * and sides must be inverted.
+             */
+            void transform(const Mat4f& pointTransform, bool invertOrientation);
+
             CutResult addFace(Face& face, FaceSet& droppedFaces);
             bool addFaces(const FaceList& faces, FaceSet& droppedFaces);
 
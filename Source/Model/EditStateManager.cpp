@@ -22,7 +22,8 @@
 #include "Model/Brush.h"
 #include "Model/Entity.h"
 #include "Model/Face.h"
-#include "Utility/List.h"
+
+#include <algorithm>
 
 namespace TrenchBroom {
     namespace Model {
@@ -36,18 +37,18 @@ namespace TrenchBroom {
                     changeSet.addEntity(previousState, entity);
                     
                     if (previousState == EditState::Selected)
-                        Utility::erase(current().selectedEntities, &entity);
+                        current().selectedEntities.remove(entity);
                     else if (previousState == EditState::Hidden)
-                        Utility::erase(current().hiddenEntities, &entity);
+                        current().hiddenEntities.remove(entity);
                     else if (previousState == EditState::Locked)
-                        Utility::erase(current().lockedEntities, &entity);
+                        current().lockedEntities.remove(entity);
                     
                     if (newState == EditState::Selected)
-                        current().selectedEntities.push_back(&entity);
+                        current().selectedEntities.add(entity);
                     else if (newState == EditState::Hidden)
-                        current().hiddenEntities.push_back(&entity);
+                        current().hiddenEntities.add(entity);
                     else if (newState == EditState::Locked)
-                        current().lockedEntities.push_back(&entity);
+                        current().lockedEntities.add(entity);
                     changed = true;
                 }
             }
@@ -65,18 +66,18 @@ namespace TrenchBroom {
                     changeSet.addBrush(previousState, brush);
                     
                     if (previousState == EditState::Selected)
-                        Utility::erase(current().selectedBrushes, &brush);
+                        current().selectedBrushes.remove(brush);
                     else if (previousState == EditState::Hidden)
-                        Utility::erase(current().hiddenBrushes, &brush);
+                        current().hiddenBrushes.remove(brush);
                     else if (previousState == EditState::Locked)
-                        Utility::erase(current().lockedBrushes, &brush);
+                        current().lockedBrushes.remove(brush);
                     
                     if (newState == EditState::Selected)
-                        current().selectedBrushes.push_back(&brush);
+                        current().selectedBrushes.add(brush);
                     else if (newState == EditState::Hidden)
-                        current().hiddenBrushes.push_back(&brush);
+                        current().hiddenBrushes.add(brush);
                     else if (newState == EditState::Locked)
-                        current().lockedBrushes.push_back(&brush);
+                        current().lockedBrushes.add(brush);
                     changed = true;
                 }
             }
@@ -90,9 +91,9 @@ namespace TrenchBroom {
                 Face& face = *faces[i];
                 if (face.selected() != newState) {
                     if (newState)
-                        current().selectedFaces.push_back(&face);
+                        current().selectedFaces.add(face);
                     else
-                        Utility::erase(current().selectedFaces, &face);
+                        current().selectedFaces.remove(face);
                     face.setSelected(newState);
                     changeSet.addFace(!newState, face);
                     changed = true;
@@ -101,58 +102,64 @@ namespace TrenchBroom {
             return changed;
         }
 
-        void EditStateManager::setDefaultAndClear(EntityList& entities, EditStateChangeSet& changeSet, const EntityList& except) {
+        void EditStateManager::setDefaultAndClear(EditStateList<Entity>& entities, EditStateChangeSet& changeSet, const EntityList& except) {
             if (except.empty()) {
-                EntityList::iterator it, end;
-                for (it = entities.begin(), end = entities.end(); it != end; ++it) {
+                const EntityList& objects = entities.objects();
+                EntityList::const_iterator it, end;
+                for (it = objects.begin(), end = objects.end(); it != end; ++it) {
                     Entity& entity = **it;
                     EditState::Type previousState = entity.setEditState(EditState::Default);
                     changeSet.addEntity(previousState, entity);
                 }
                 entities.clear();
             } else {
-                EntityList::iterator it = entities.begin();
-                while (it != entities.end()) {
+                EntityList sortedExcept = except;
+                std::sort(sortedExcept.begin(), sortedExcept.end());
+                
+                const EntityList objects = entities.objects();
+                EntityList::const_iterator it, end;
+                for (it = objects.begin(), end = objects.end(); it != end; ++it) {
                     Entity& entity = **it;
-                    if (std::find(except.begin(), except.end(), &entity) == except.end()) {
+                    if (!std::binary_search(sortedExcept.begin(), sortedExcept.end(), &entity)) {
                         EditState::Type previousState = entity.setEditState(EditState::Default);
                         changeSet.addEntity(previousState, entity);
-                        it = entities.erase(it);
-                    } else {
-                        ++it;
+                        entities.remove(entity);
                     }
                 }
             }
         }
         
-        void EditStateManager::setDefaultAndClear(BrushList& brushes, EditStateChangeSet& changeSet, const BrushList& except) {
+        void EditStateManager::setDefaultAndClear(EditStateList<Brush>& brushes, EditStateChangeSet& changeSet, const BrushList& except) {
             if (except.empty()) {
-                BrushList::iterator it, end;
-                for (it = brushes.begin(), end = brushes.end(); it != end; ++it) {
+                const BrushList& objects = brushes.objects();
+                BrushList::const_iterator it, end;
+                for (it = objects.begin(), end = objects.end(); it != end; ++it) {
                     Brush& brush = **it;
                     EditState::Type previousState = brush.setEditState(EditState::Default);
                     changeSet.addBrush(previousState, brush);
                 }
                 brushes.clear();
             } else {
-                BrushList::iterator it = brushes.begin();
-                while (it != brushes.end()) {
+                BrushList sortedExcept = except;
+                std::sort(sortedExcept.begin(), sortedExcept.end());
+                
+                const BrushList objects = brushes.objects();
+                BrushList::const_iterator it, end;
+                for (it = objects.begin(), end = objects.end(); it != end; ++it) {
                     Brush& brush = **it;
-                    if (std::find(except.begin(), except.end(), &brush) == except.end()) {
+                    if (!std::binary_search(sortedExcept.begin(), sortedExcept.end(), &brush)) {
                         EditState::Type previousState = brush.setEditState(EditState::Default);
                         changeSet.addBrush(previousState, brush);
-                        it = brushes.erase(it);
-                    } else {
-                        ++it;
+                        brushes.remove(brush);
                     }
                 }
             }
-            
         }
         
-        void EditStateManager::deselectAndClear(FaceList& faces, EditStateChangeSet& changeSet) {
-            for (unsigned int i = 0; i < faces.size(); i++) {
-                Face& face = *faces[i];
+        void EditStateManager::deselectAndClear(EditStateList<Face>& faces, EditStateChangeSet& changeSet) {
+            const FaceList& objects = faces.objects();
+            for (unsigned int i = 0; i < objects.size(); i++) {
+                Face& face = *objects[i];
                 face.setSelected(false);
                 changeSet.addFace(true, face);
             }
@@ -186,7 +193,7 @@ namespace TrenchBroom {
             if (replace)
                 setDefaultAndClear(newState, changeSet, entities, EmptyBrushList);
             
-            FaceList& selectedFaces = current().selectedFaces;
+            EditStateList<Face>& selectedFaces = current().selectedFaces;
             if (doSetEditState(entities, newState, changeSet) &&
                 newState == EditState::Selected &&
                 !selectedFaces.empty()) {
@@ -204,7 +211,7 @@ namespace TrenchBroom {
             if (replace)
                 setDefaultAndClear(newState, changeSet, EmptyEntityList, brushes);
             
-            FaceList& selectedFaces = current().selectedFaces;
+            EditStateList<Face>& selectedFaces = current().selectedFaces;
             if (doSetEditState(brushes, newState, changeSet) &&
                 newState == EditState::Selected &&
                 !selectedFaces.empty()) {
@@ -225,7 +232,7 @@ namespace TrenchBroom {
             bool deselectFaces = doSetEditState(entities, newState, changeSet);
             deselectFaces |= doSetEditState(brushes, newState, changeSet);
 
-            FaceList& selectedFaces = current().selectedFaces;
+            EditStateList<Face>& selectedFaces = current().selectedFaces;
             if (deselectFaces && newState == EditState::Selected && !selectedFaces.empty())
                 deselectAndClear(selectedFaces, changeSet);
             
@@ -243,8 +250,8 @@ namespace TrenchBroom {
             
             bool changed = doSetSelected(faces, select, changeSet);
             if (select && changed) {
-                EntityList& entities = current().selectedEntities;
-                BrushList& brushes = current().selectedBrushes;
+                EditStateList<Entity>& entities = current().selectedEntities;
+                EditStateList<Brush>& brushes = current().selectedBrushes;
 
                 if (!entities.empty())
                     setDefaultAndClear(entities, changeSet);
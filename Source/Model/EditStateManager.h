@@ -35,6 +35,68 @@ namespace TrenchBroom {
     namespace Model {
         class EditStateChangeSet;
         
+        /**
+         * A list of objects that share an edit state. Every object stores its index in the list, so that it can be
+         * removed in constant time. Removed objects leave a gap which is closed the next time the list is accessed,
+         * so the remaining objects keep their order.
+         */
+        template <typename T>
+        class EditStateList {
+        public:
+            typedef std::vector<T*> List;
+        private:
+            mutable List m_objects;
+            mutable size_t m_gapCount;
+            
+            inline void compact() const {
+                size_t count = 0;
+                for (size_t i = 0; i < m_objects.size(); i++) {
+                    T* object = m_objects[i];
+                    if (object != NULL) {
+                        object->setEditStateIndex(count);
+                        m_objects[count++] = object;
+                    }
+                }
+                m_objects.resize(count);
+                m_gapCount = 0;
+            }
+        public:
+            EditStateList() :
+            m_gapCount(0) {}
+            
+            inline bool empty() const {
+                return m_objects.size() == m_gapCount;
+            }
+            
+            inline bool contains(const T& object) const {
+                const size_t index = object.editStateIndex();
+                return index < m_objects.size() && m_objects[index] == &object;
+            }
+            
+            inline void add(T& object) {
+                object.setEditStateIndex(m_objects.size());
+                m_objects.push_back(&object);
+            }
+            
+            inline void remove(T& object) {
+                if (contains(object)) {
+                    m_objects[object.editStateIndex()] = NULL;
+                    m_gapCount++;
+                }
+            }
+            
+            inline void clear() {
+                m_objects.clear();
+                m_gapCount = 0;
+            }
+            
+            inline const List& objects() const {
+                if (m_gapCount > 0)
+                    compact();
+                return m_objects;
+            }
+        };
+        
         class EditStateManager {
         public:
             typedef enum {
@@ -47,13 +109,13 @@ namespace TrenchBroom {
 
             class State {
             public:
-                EntityList selectedEntities;
-                EntityList hiddenEntities;
-                EntityList lockedEntities;
-                BrushList selectedBrushes;
-                BrushList hiddenBrushes;
-                BrushList lockedBrushes;
-                FaceList selectedFaces;
+                EditStateList<Entity> selectedEntities;
+                EditStateList<Entity> hiddenEntities;
+                EditStateList<Entity> lockedEntities;
+                EditStateList<Brush> selectedBrushes;
+                EditStateList<Brush> hiddenBrushes;
+                EditStateList<Brush> lockedBrushes;
+                EditStateList<Face> selectedFaces;
                 
                 inline SelectionMode selectionMode() const {
                     if (!selectedEntities.empty()) {
@@ -98,9 +160,9 @@ namespace TrenchBroom {
             bool doSetEditState(const EntityList& entities, EditState::Type newState, EditStateChangeSet& changeSet);
             bool doSetEditState(const BrushList& brushes, EditState::Type newState, EditStateChangeSet& changeSet);
             bool doSetSelected(const FaceList& faces, bool newState, EditStateChangeSet& changeSet);
-            void setDefaultAndClear(EntityList& entities, EditStateChangeSet& changeSet, const EntityList& except = EmptyEntityList);
-            void setDefaultAndClear(BrushList& brushes, EditStateChangeSet& changeSet, const BrushList& except = EmptyBrushList);
-            void deselectAndClear(FaceList& faces, EditStateChangeSet& changeSet);
+            void setDefaultAndClear(EditStateList<Entity>& entities, EditStateChangeSet& changeSet, const EntityList& except = EmptyEntityList);
+            void setDefaultAndClear(EditStateList<Brush>& brushes, EditStateChangeSet& changeSet, const BrushList& except = EmptyBrushList);
+            void deselectAndClear(EditStateList<Face>& faces, EditStateChangeSet& changeSet);
             void setDefaultAndClear(EditState::Type previousState, EditStateChangeSet& changeSet, const EntityList& exceptEntities, const BrushList& exceptBrushes);
         public:
             EditStateManager();
@@ -122,31 +184,31 @@ namespace TrenchBroom {
             }
 
             inline const EntityList& selectedEntities() const {
-                return current().selectedEntities;
+                return current().selectedEntities.objects();
             }
             
             inline const EntityList& hiddenEntities() const {
-                return current().hiddenEntities;
+                return current().hiddenEntities.objects();
             }
             
             inline const EntityList& lockedEntities() const {
-                return current().lockedEntities;
+                return current().lockedEntities.objects();
             }
             
             inline const BrushList& selectedBrushes() const {
-                return current().selectedBrushes;
+                return current().selectedBrushes.objects();
             }
             
             inline const BrushList& hiddenBrushes() const {
-                return current().hiddenBrushes;
+                return current().hiddenBrushes.objects();
             }
             
             inline const BrushList& lockedBrushes() const {
-                return current().lockedBrushes;
+                return current().lockedBrushes.objects();
             }
             
             inline const FaceList& selectedFaces() const {
-                return current().selectedFaces;
+                return current().selectedFaces.objects();
             }
             
             inline EntityList allSelectedEntities() const {
@@ -168,10 +230,10 @@ namespace TrenchBroom {
             
             inline FaceList allSelectedFaces() const {
                 if (selectionMode() == SMFaces)
-                    return current().selectedFaces;
+                    return current().selectedFaces.objects();
                 
                 FaceList faces;
-                const BrushList& brushes = current().selectedBrushes;
+                const BrushList& brushes = current().selectedBrushes.objects();
                 for (unsigned int i = 0; i < brushes.size(); i++) {
                     Brush& brush = *brushes[i];
                     const FaceList& brushFaces = brush.faces();
@@ -241,6 +241,13 @@ namespace TrenchBroom {
             m_killSources.clear();
         }
 
+        void Entity::invalidateBrushFilterVisibility() {
+            for (BrushList::const_iterator it = m_brushes.begin(); it != m_brushes.end(); ++it) {
+                Brush* brush = *it;
+                brush->invalidateFilterVisibility();
+            }
+        }
+
         void Entity::init() {
             m_map = NULL;
             m_worldspawn = false;
@@ -515,6 +522,7 @@ namespace TrenchBroom {
         void Entity::setProperties(const PropertyList& properties, bool replace) {
             if (replace) {
                 m_propertyStore.clear();
+                invalidateBrushFilterVisibility();
                 setProperty(SpawnFlagsKey, "0");
             }
             PropertyList::const_iterator it, end;
@@ -559,6 +567,7 @@ namespace TrenchBroom {
             if (key == ClassnameKey && value != classname()) {
                 m_worldspawn = *value == WorldspawnClassname;
                 setDefinition(NULL);
+                invalidateBrushFilterVisibility();
             }
             
             if (isNumberedProperty(TargetKey, key)) {
@@ -591,6 +600,7 @@ namespace TrenchBroom {
             else
                 m_propertyStore.setPropertyValue(key, *value);
             invalidateGeometry();
+            invalidateFilterVisibility();
         }
         
         StringList Entity::linkTargetnames() const {
@@ -657,6 +667,7 @@ namespace TrenchBroom {
             brush.setEntity(this);
             m_brushes.push_back(&brush);
             invalidateGeometry();
+            invalidateFilterVisibility();
         }
         
         void Entity::addBrushes(const BrushList& brushes) {
@@ -666,12 +677,14 @@ namespace TrenchBroom {
                 m_brushes.push_back(brush);
             }
             invalidateGeometry();
+            invalidateFilterVisibility();
         }
         
         void Entity::removeBrush(Brush& brush) {
             brush.setEntity(NULL);
             m_brushes.erase(std::remove(m_brushes.begin(), m_brushes.end(), &brush), m_brushes.end());
             invalidateGeometry();
+            invalidateFilterVisibility();
         }
 
         void Entity::setDefinition(EntityDefinition* definition) {
@@ -683,10 +696,6 @@ namespace TrenchBroom {
             invalidateGeometry();
         }
 
-        bool Entity::selectable() const {
-            return m_brushes.empty();
-        }
-
         EditState::Type Entity::setEditState(EditState::Type editState) {
             if (worldspawn())
                 return EditState::Default;
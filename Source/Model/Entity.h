@@ -94,6 +94,8 @@ namespace TrenchBroom {
             EntityList m_killTargets;
             EntityList m_killSources;
 
+            void invalidateBrushFilterVisibility();
+            
             void addLinkTarget(Entity& entity);
             void removeLinkTarget(Entity& entity);
             void addLinkSource(Entity& entity);
@@ -247,7 +249,9 @@ namespace TrenchBroom {
 
             void setDefinition(EntityDefinition* definition);
 
-            bool selectable() const;
+            inline bool selectable() const {
+                return m_brushes.empty();
+            }
 
             inline bool partiallySelected() const {
                 return m_selectedBrushCount > 0;
@@ -267,10 +271,12 @@ namespace TrenchBroom {
 
             inline void incHiddenBrushCount() {
                 m_hiddenBrushCount++;
+                invalidateFilterVisibility();
             }
 
             inline void decHiddenBrushCount() {
                 m_hiddenBrushCount--;
+                invalidateFilterVisibility();
             }
 
             virtual EditState::Type setEditState(EditState::Type editState);
@@ -22,6 +22,7 @@
 #include "Model/Brush.h"
 #include "Model/BrushGeometry.h"
 #include "Model/Texture.h"
+#include "Utility/Atomic.h"
 
 namespace TrenchBroom {
     namespace Model {
@@ -98,8 +99,8 @@ namespace TrenchBroom {
         };
         
         void Face::init() {
-            static unsigned int currentId = 1;
-            m_faceId = currentId++;
+            static volatile long currentId = 0;
+            m_faceId = static_cast<unsigned int>(Utility::atomicIncrement(currentId));
             for (size_t i = 0; i < 3; i++)
                 m_points[i] = Vec3f::Null;
             m_xOffset = 0.0f;
@@ -111,11 +112,21 @@ namespace TrenchBroom {
             m_texture = NULL;
             m_filePosition = 0;
             m_selected = false;
+            m_editStateIndex = 0;
             m_texAxesValid = false;
             m_vertexCacheValid = false;
             m_contentType = CTDefault;
         }
         
+        void Face::initPoints(const Vec3f& point1, const Vec3f& point2, const Vec3f& point3) {
+            m_points[0] = point1;
+            m_points[1] = point2;
+            m_points[2] = point3;
+            correctFacePoints();
+            m_boundary.setPoints(m_points[0], m_points[1], m_points[2]);
+            updatePointsFromBoundary();
+        }
+        
         void Face::texAxesAndIndices(const Vec3f& faceNormal, Vec3f& xAxis, Vec3f& yAxis, unsigned int& planeNormIndex, unsigned int& faceNormIndex) const {
             unsigned int bestIndex = 0;
             float bestDot = 0.0f;
@@ -168,27 +179,16 @@ namespace TrenchBroom {
             unsigned int width = m_texture != NULL ? m_texture->width() : 1;
             unsigned int height = m_texture != NULL ? m_texture->height() : 1;
             
+            // the polygon is stored once, the renderer triangulates it with an index fan
             size_t vertexCount = m_side->vertices.size();
-            m_vertexCache.resize(3 * (vertexCount - 2));
-            
-            Vec2f texCoords;
-            size_t j = 0;
-            for (size_t i = 1; i < vertexCount - 1; i++) {
-                m_vertexCache[j++] = Renderer::FaceVertex(m_side->vertices[0]->position,
-                                                          m_boundary.normal,
-                                                          Vec2f((m_side->vertices[0]->position.dot(m_scaledTexAxisX) + m_xOffset) / width,
-                                                                (m_side->vertices[0]->position.dot(m_scaledTexAxisY) + m_yOffset) / height)
-                                                          );
-                m_vertexCache[j++] = Renderer::FaceVertex(m_side->vertices[i]->position,
-                                                          m_boundary.normal,
-                                                          Vec2f((m_side->vertices[i]->position.dot(m_scaledTexAxisX) + m_xOffset) / width,
-                                                                (m_side->vertices[i]->position.dot(m_scaledTexAxisY) + m_yOffset) / height)
-                                                          );
-                m_vertexCache[j++] = Renderer::FaceVertex(m_side->vertices[i+1]->position,
-                                                          m_boundary.normal,
-                                                          Vec2f((m_side->vertices[i+1]->position.dot(m_scaledTexAxisX) + m_xOffset) / width,
-                                                                (m_side->vertices[i+1]->position.dot(m_scaledTexAxisY) + m_yOffset) / height)
-                                                          );
+            m_vertexCache.resize(vertexCount);
+            
+            for (size_t i = 0; i < vertexCount; i++) {
+                m_vertexCache[i] = Renderer::FaceVertex(m_side->vertices[i]->position,
+                                                        m_boundary.normal,
+                                                        Vec2f((m_side->vertices[i]->position.dot(m_scaledTexAxisX) + m_xOffset) / width,
+                                                              (m_side->vertices[i]->position.dot(m_scaledTexAxisY) + m_yOffset) / height)
+                                                        );
             }
             
             m_vertexCacheValid = true;
@@ -348,17 +348,21 @@ namespace TrenchBroom {
             } else {
                 m_contentType = CTDefault;
             }
+            
+            if (m_brush != NULL)
+                m_brush->invalidateContentTypes();
         }
 
-        Face::Face(const BBoxf& worldBounds, bool forceIntegerFacePoints, const Vec3f& point1, const Vec3f& point2, const Vec3f& point3, const String& textureName) : m_worldBounds(worldBounds), m_textureName(textureName) {
+        Face::Face(const BBoxf& worldBounds, bool forceIntegerFacePoints, const Vec3f& point1, const Vec3f& point2, const Vec3f& point3, const String& textureName) : m_worldBounds(worldBounds), m_forceIntegerFacePoints(forceIntegerFacePoints), m_textureName(textureName) {
             init();
-            m_worldBounds = worldBounds;
-            m_points[0] = point1;
-            m_points[1] = point2;
-            m_points[2] = point3;
-            correctFacePoints();
-            m_boundary.setPoints(m_points[0], m_points[1], m_points[2]);
-            updatePointsFromBoundary();
+            initPoints(point1, point2, point3);
+            setTextureName(textureName);
+        }
+        
+        Face::Face(const BBoxf& worldBounds, bool forceIntegerFacePoints, unsigned int faceId, const Vec3f& point1, const Vec3f& point2, const Vec3f& point3, const String& textureName) : m_worldBounds(worldBounds), m_forceIntegerFacePoints(forceIntegerFacePoints), m_textureName(textureName) {
+            init();
+            m_faceId = faceId;
+            initPoints(point1, point2, point3);
             setTextureName(textureName);
         }
         
@@ -370,6 +374,7 @@ namespace TrenchBroom {
         }
         
         Face::Face(const Face& face) :
+        m_brush(NULL),
         m_side(NULL),
         m_faceId(face.faceId()),
         m_boundary(face.boundary()),
@@ -386,6 +391,7 @@ namespace TrenchBroom {
         m_vertexCacheValid(false),
         m_filePosition(face.filePosition()),
         m_selected(false),
+        m_editStateIndex(0),
         m_contentType(face.contentType()) {
             face.getPoints(m_points[0], m_points[1], m_points[2]);
             updatePointsFromBoundary();
@@ -433,17 +439,25 @@ namespace TrenchBroom {
             m_vertexCacheValid = false;
 			m_selected = faceTemplate.selected();
             m_contentType = faceTemplate.contentType();
+            if (m_brush != NULL)
+                m_brush->invalidateContentTypes();
         }
         
         void Face::setBrush(Brush* brush) {
             if (brush == m_brush)
                 return;
             
-            if (m_brush != NULL && m_selected)
-                m_brush->decSelectedFaceCount();
+            if (m_brush != NULL) {
+                if (m_selected)
+                    m_brush->decSelectedFaceCount();
+                m_brush->invalidateContentTypes();
+            }
             m_brush = brush;
-            if (m_brush != NULL && m_selected)
-                m_brush->incSelectedFaceCount();
+            if (m_brush != NULL) {
+                if (m_selected)
+                    m_brush->incSelectedFaceCount();
+                m_brush->invalidateContentTypes();
+            }
         }
         
         void Face::updatePointsFromVertices() {
@@ -78,6 +78,10 @@ namespace TrenchBroom {
                 CTDefault
             };
             
+            static inline unsigned int contentTypeBit(ContentType contentType) {
+                return 1u << contentType;
+            }
+            
             class WeightOrder {
             private:
                 const Planef::WeightOrder& m_planeOrder;
@@ -89,6 +93,15 @@ namespace TrenchBroom {
                     return m_planeOrder(lhs->boundary(), rhs->boundary());
                 }
             };
+
+            /*
+             * The points and boundary of a face, which trial edits of the brush geometry save and restore.
+             */
+            class GeometryState {
+            public:
+                FacePoints points;
+                Planef boundary;
+            };
         protected:
             static const Vec3f BaseAxes[18];
 
@@ -136,6 +149,7 @@ namespace TrenchBroom {
 
             size_t m_filePosition;
             bool m_selected;
+            size_t m_editStateIndex;
             
             ContentType m_contentType;
 
@@ -147,6 +161,7 @@ namespace TrenchBroom {
             }
 
             void init();
+            void initPoints(const Vec3f& point1, const Vec3f& point2, const Vec3f& point3);
             void texAxesAndIndices(const Vec3f& faceNormal, Vec3f& xAxis, Vec3f& yAxis, unsigned int& planeNormIndex, unsigned int& faceNormIndex) const;
             void validateTexAxes(const Vec3f& faceNormal) const;
             void validateVertexCache() const;
@@ -156,6 +171,8 @@ namespace TrenchBroom {
             void updateContentType();
         public:
             Face(const BBoxf& worldBounds, bool forceIntegerFacePoints, const Vec3f& point1, const Vec3f& point2, const Vec3f& point3, const String& textureName);
+            // recreates a face with the given ID from the points of the original face, used for undo snapshots
+            Face(const BBoxf& worldBounds, bool forceIntegerFacePoints, unsigned int faceId, const Vec3f& point1, const Vec3f& point2, const Vec3f& point3, const String& textureName);
             Face(const BBoxf& worldBounds, bool forceIntegerFacePoints, const Face& faceTemplate);
             Face(const Face& face);
 			~Face();
@@ -203,6 +220,20 @@ namespace TrenchBroom {
                 return m_boundary;
             }
 
+            inline GeometryState geometryState() const {
+                GeometryState state;
+                for (size_t i = 0; i < 3; i++)
+                    state.points[i] = m_points[i];
+                state.boundary = m_boundary;
+                return state;
+            }
+
+            inline void setGeometryState(const GeometryState& state) {
+                for (size_t i = 0; i < 3; i++)
+                    m_points[i] = state.points[i];
+                m_boundary = state.boundary;
+            }
+
             inline const BBoxf& worldBounds() const {
                 return m_worldBounds;
             }
@@ -336,6 +367,18 @@ namespace TrenchBroom {
             }
 
             void setSelected(bool selected);
+            
+            /**
+             * The index of this face in the edit state manager's list of selected faces, only the edit state manager
+             * may change this.
+             */
+            inline size_t editStateIndex() const {
+                return m_editStateIndex;
+            }
+            
+            inline void setEditStateIndex(size_t editStateIndex) {
+                m_editStateIndex = editStateIndex;
+            }
 
             inline size_t filePosition() const {
                 return m_filePosition;
@@ -81,11 +81,8 @@ namespace TrenchBroom {
         class DefaultFilter : public Filter {
         protected:
             const View::ViewOptions& m_viewOptions;
-        public:
-            DefaultFilter(const View::ViewOptions& viewOptions) :
-            m_viewOptions(viewOptions) {}
-
-            virtual inline bool entityVisible(const Model::Entity& entity) const {
+            
+            inline bool evaluateEntityVisible(const Model::Entity& entity) const {
                 if (entity.brushes().empty() && !m_viewOptions.showEntities())
                     return false;
 
@@ -97,7 +94,7 @@ namespace TrenchBroom {
                     const Model::PropertyList& properties = entity.properties();
                     Model::PropertyList::const_iterator it, end;
                     for (it = properties.begin(), end = properties.end(); it != end; ++it) {
-                        const Model::Property property = *it;
+                        const Model::Property& property = *it;
                         if (Utility::containsString(property.key(), pattern, false) ||
                             Utility::containsString(property.value(), pattern, false))
                             return true;
@@ -107,17 +104,8 @@ namespace TrenchBroom {
 
                 return true;
             }
-
-            virtual inline bool entityPickable(const Model::Entity& entity) const {
-                if (entity.worldspawn() ||
-                    entity.locked() ||
-                    !entity.brushes().empty())
-                    return false;
-
-                return entityVisible(entity);
-            }
-
-            virtual inline bool brushVisible(const Model::Brush& brush) const {
+            
+            inline bool evaluateBrushVisible(const Model::Brush& brush) const {
                 if (!m_viewOptions.showBrushes() || brush.hidden())
                     return false;
 
@@ -133,53 +121,60 @@ namespace TrenchBroom {
                             return false;
                     }
                     
-                    const Model::FaceList& faces = brush.faces();
-                    unsigned int clipCount = 0;
-                    unsigned int skipCount = 0;
-                    unsigned int hintCount = 0;
-                    unsigned int liquidCount = 0;
-                    unsigned int triggerCount = 0;
-                    bool matches = pattern.empty();
-                    for (unsigned int i = 0; i < faces.size(); i++) {
-                        switch (faces[i]->contentType()) {
-                            case Face::CTLiquid:
-                                liquidCount++;
-                                break;
-                            case Face::CTClip:
-                                clipCount++;
-                                break;
-                            case Face::CTSkip:
-                                skipCount++;
-                                break;
-                            case Face::CTHint:
-                                hintCount++;
-                                break;
-                            case Face::CTTrigger:
-                                triggerCount++;
-                                break;
-                            default:
-                                if (!matches)
-                                    matches = Utility::containsString(faces[i]->textureName(), pattern, false);
-                                break;
-                        }
-                    }
-
-                    if (!m_viewOptions.showClipBrushes() && clipCount == faces.size())
+                    const unsigned int contentTypes = brush.contentTypes();
+                    if (!m_viewOptions.showClipBrushes() && contentTypes == Face::contentTypeBit(Face::CTClip))
                         return false;
-                    if (!m_viewOptions.showSkipBrushes() && skipCount == faces.size())
+                    if (!m_viewOptions.showSkipBrushes() && contentTypes == Face::contentTypeBit(Face::CTSkip))
                         return false;
-                    if (!m_viewOptions.showHintBrushes() && hintCount == faces.size())
+                    if (!m_viewOptions.showHintBrushes() && contentTypes == Face::contentTypeBit(Face::CTHint))
                         return false;
-                    if (!m_viewOptions.showLiquidBrushes() && liquidCount == faces.size())
+                    if (!m_viewOptions.showLiquidBrushes() && contentTypes == Face::contentTypeBit(Face::CTLiquid))
                         return false;
-                    if (!m_viewOptions.showTriggerBrushes() && triggerCount == faces.size())
+                    if (!m_viewOptions.showTriggerBrushes() && contentTypes == Face::contentTypeBit(Face::CTTrigger))
                         return false;
 
-                    return matches;
+                    if (pattern.empty())
+                        return true;
+                    if ((contentTypes & Face::contentTypeBit(Face::CTDefault)) == 0)
+                        return false;
+                    
+                    const Model::FaceList& faces = brush.faces();
+                    for (unsigned int i = 0; i < faces.size(); i++) {
+                        if (faces[i]->contentType() == Face::CTDefault &&
+                            Utility::containsString(faces[i]->textureName(), pattern, false))
+                            return true;
+                    }
+                    return false;
                 }
 
                 return true;
             }
+        public:
+            DefaultFilter(const View::ViewOptions& viewOptions) :
+            m_viewOptions(viewOptions) {}
+
+            virtual inline bool entityVisible(const Model::Entity& entity) const {
+                const unsigned int filterGeneration = m_viewOptions.filterGeneration();
+                if (entity.filterGeneration() != filterGeneration)
+                    entity.setFilterVisible(filterGeneration, evaluateEntityVisible(entity));
+                return entity.filterVisible();
+            }
+
+            virtual inline bool entityPickable(const Model::Entity& entity) const {
+                if (entity.worldspawn() ||
+                    entity.locked() ||
+                    !entity.brushes().empty())
+                    return false;
+
+                return entityVisible(entity);
+            }
+
+            virtual inline bool brushVisible(const Model::Brush& brush) const {
+                const unsigned int filterGeneration = m_viewOptions.filterGeneration();
+                if (brush.filterGeneration() != filterGeneration)
+                    brush.setFilterVisible(filterGeneration, evaluateBrushVisible(brush));
+                return brush.filterVisible();
+            }
 
             virtual inline bool brushPickable(const Model::Brush& brush) const {
                 if (brush.locked() || brush.entity()->locked())
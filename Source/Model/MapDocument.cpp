@@ -49,6 +49,7 @@
 #include "View/Inspector.h"
 #include "View/ProgressIndicatorDialog.h"
 
+#include <algorithm>
 #include <cassert>
 
 #include <wx/msgdlg.h>
@@ -135,7 +136,12 @@ namespace TrenchBroom {
             IO::MapParser parser(begin, end, console());
             parser.parseMap(*m_map, &progressIndicator);
             
-            console().info("Loaded map file in %f seconds", watch.Time() / 1000.0f);
+            const float seconds = watch.Time() / 1000.0f;
+            const float megabytes = static_cast<float>(end - begin) / (1024.0f * 1024.0f);
+            if (seconds > 0.0f)
+                console().info("Loaded map file in %f seconds (%.2f MB/s)", seconds, megabytes / seconds);
+            else
+                console().info("Loaded map file in %f seconds", seconds);
         }
 
         void MapDocument::setAllTexturesToNull() {
@@ -467,6 +473,10 @@ namespace TrenchBroom {
             return *m_textureManager;
         }
 
+        Octree& MapDocument::octree() const {
+            return *m_octree;
+        }
+
         Picker& MapDocument::picker() const {
             return *m_picker;
         }
@@ -629,7 +639,8 @@ namespace TrenchBroom {
             m_sharedResources = new Renderer::SharedResources(*m_textureManager, *m_console);
             m_map = new Model::Map(worldBounds, false);
             m_editStateManager = new Model::EditStateManager();
-            m_octree = new Octree(*m_map);
+            Preferences::PreferenceManager& prefs = Preferences::PreferenceManager::preferences();
+            m_octree = new Octree(*m_map, 64, std::max(1.0f, prefs.getFloat(Preferences::OctreeLooseness)));
             m_picker = new Model::Picker(*m_octree);
             m_definitionManager = new EntityDefinitionManager(*m_console);
             m_modificationCount = 0;
@@ -121,6 +121,7 @@ namespace TrenchBroom {
             EntityDefinitionManager& definitionManager() const;
             EditStateManager& editStateManager() const;
             TextureManager& textureManager() const;
+            Octree& octree() const;
             Picker& picker() const;
             Utility::Grid& grid() const;
             
@@ -22,6 +22,7 @@
 
 #include "Model/EditState.h"
 #include "Model/MapObjectTypes.h"
+#include "Utility/Atomic.h"
 #include "Utility/VecMath.h"
 
 #include <vector>
@@ -31,6 +32,7 @@ using namespace TrenchBroom::VecMath;
 namespace TrenchBroom {
     namespace Model {
         class Filter;
+        class OctreeNode;
         class PickResult;
         
         class MapObject {
@@ -41,6 +43,14 @@ namespace TrenchBroom {
             
             size_t m_fileFirstLine;
             size_t m_fileLineCount;
+            
+            OctreeNode* m_octreeNode;
+            size_t m_octreeIndex;
+            
+            size_t m_editStateIndex;
+            
+            mutable unsigned int m_filterGeneration;
+            mutable bool m_filterVisible;
         public:
             enum Type {
                 EntityObject,
@@ -51,9 +61,14 @@ namespace TrenchBroom {
             m_editState(EditState::Default),
             m_previouslyLocked(false),
             m_fileFirstLine(0),
-            m_fileLineCount(0) {
-                static unsigned int currentId = 1;
-                m_uniqueId = currentId++;
+            m_fileLineCount(0),
+            m_octreeNode(NULL),
+            m_octreeIndex(0),
+            m_editStateIndex(0),
+            m_filterGeneration(0),
+            m_filterVisible(false) {
+                static volatile long currentId = 0;
+                m_uniqueId = static_cast<unsigned int>(Utility::atomicIncrement(currentId));
             }
             
             virtual ~MapObject() {
@@ -109,6 +124,7 @@ namespace TrenchBroom {
                 } else
                     m_previouslyLocked = false;
 
+                invalidateFilterVisibility();
                 return previous;
             }
             
@@ -152,6 +168,57 @@ namespace TrenchBroom {
                 m_fileFirstLine = firstLine;
                 m_fileLineCount = lineCount;
             }
+            
+            /**
+             * The octree node which holds this object and the index of this object in that node's object list, or
+             * NULL if this object is not in the octree. Only the octree may change these.
+             */
+            inline OctreeNode* octreeNode() const {
+                return m_octreeNode;
+            }
+            
+            inline size_t octreeIndex() const {
+                return m_octreeIndex;
+            }
+            
+            inline void setOctreeNode(OctreeNode* node, size_t index) {
+                m_octreeNode = node;
+                m_octreeIndex = index;
+            }
+            
+            /**
+             * The index of this object in the edit state manager's list of objects with this object's edit state. Only
+             * the edit state manager may change this.
+             */
+            inline size_t editStateIndex() const {
+                return m_editStateIndex;
+            }
+            
+            inline void setEditStateIndex(size_t editStateIndex) {
+                m_editStateIndex = editStateIndex;
+            }
+            
+            /**
+             * The visibility of this object as last evaluated by a filter, together with the view options generation
+             * it was evaluated for (see View::ViewOptions::filterGeneration). Generation 0 is never handed out by the
+             * view options, so an invalidated object is always evaluated again.
+             */
+            inline unsigned int filterGeneration() const {
+                return m_filterGeneration;
+            }
+            
+            inline bool filterVisible() const {
+                return m_filterVisible;
+            }
+            
+            inline void setFilterVisible(unsigned int filterGeneration, bool filterVisible) const {
+                m_filterGeneration = filterGeneration;
+                m_filterVisible = filterVisible;
+            }
+            
+            inline void invalidateFilterVisibility() {
+                m_filterGeneration = 0;
+            }
         };
     }
 }
@@ -23,15 +23,39 @@
 #include "Model/Entity.h"
 #include "Model/Map.h"
 #include "Model/MapObject.h"
+#include "Utility/Console.h"
 
 #include <algorithm>
 #include <cmath>
 #include <cassert>
+#include <limits>
 
 
 namespace TrenchBroom {
     namespace Model {
-        bool OctreeNode::addObject(MapObject& object, unsigned int childIndex) {
+        static inline bool intersectBounds(const BBoxf& bounds, const Rayf& ray, const Vec3f& inverseDirection, float& distance) {
+            float enter = 0.0f;
+            float leave = std::numeric_limits<float>::max();
+            for (size_t i = 0; i < 3; i++) {
+                if (ray.direction[i] == 0.0f) {
+                    if (ray.origin[i] < bounds.min[i] || ray.origin[i] > bounds.max[i])
+                        return false;
+                } else {
+                    float t1 = (bounds.min[i] - ray.origin[i]) * inverseDirection[i];
+                    float t2 = (bounds.max[i] - ray.origin[i]) * inverseDirection[i];
+                    if (t1 > t2)
+                        std::swap(t1, t2);
+                    enter = std::max(enter, t1);
+                    leave = std::min(leave, t2);
+                    if (enter > leave)
+                        return false;
+                }
+            }
+            distance = enter;
+            return true;
+        }
+        
+        OctreeNode& OctreeNode::getOrCreateChild(unsigned int childIndex) {
             if (m_children[childIndex] == NULL) {
                 BBoxf childBounds;
                 switch (childIndex) {
@@ -59,6 +83,14 @@ namespace TrenchBroom {
                         childBounds.max[1] = m_bounds.max[1];
                         childBounds.max[2] = (m_bounds.min[2] + m_bounds.max[2]) / 2.0f;
                         break;
+                    case WNT:
+                        childBounds.min[0] = m_bounds.min[0];
+                        childBounds.min[1] = (m_bounds.min[1] + m_bounds.max[1]) / 2.0f;
+                        childBounds.min[2] = (m_bounds.min[2] + m_bounds.max[2]) / 2.0f;
+                        childBounds.max[0] = (m_bounds.min[0] + m_bounds.max[0]) / 2.0f;
+                        childBounds.max[1] = m_bounds.max[1];
+                        childBounds.max[2] = m_bounds.max[2];
+                        break;
                     case ESB:
                         childBounds.min[0] = (m_bounds.min[0] + m_bounds.max[0]) / 2.0f;
                         childBounds.min[1] = m_bounds.min[1];
@@ -92,14 +124,49 @@ namespace TrenchBroom {
                         childBounds.max[2] = m_bounds.max[2];
                         break;
                 }
-                m_children[childIndex] = new OctreeNode(childBounds, m_minSize);
+                m_children[childIndex] = new OctreeNode(childBounds, m_minSize, m_looseness, this);
             }
-            return m_children[childIndex]->addObject(object);
+            return *m_children[childIndex];
+        }
+        
+        // returns the index of the child whose loose bounds contain the given bounds (see NodePosition), or 8 if no
+        // such child exists, the candidate child is determined by the center of the given bounds
+        unsigned int OctreeNode::childIndex(const BBoxf& bounds) const {
+            const Vec3f center = m_bounds.center();
+            const Vec3f objectCenter = bounds.center();
+            const float margin = (m_looseness - 1.0f) * (m_bounds.max[0] - m_bounds.min[0]) / 4.0f;
+            unsigned int index = 0;
+            for (size_t i = 0; i < 3; i++) {
+                index <<= 1;
+                if (objectCenter[i] <= center[i]) {
+                    if (bounds.min[i] < m_bounds.min[i] - margin || bounds.max[i] > center[i] + margin)
+                        return 8;
+                } else {
+                    if (bounds.min[i] < center[i] - margin || bounds.max[i] > m_bounds.max[i] + margin)
+                        return 8;
+                    index |= 1;
+                }
+            }
+            return index;
+        }
+        
+        void OctreeNode::insertObject(MapObject& object) {
+            object.setOctreeNode(this, m_objects.size());
+            m_objects.push_back(&object);
         }
 
-        OctreeNode::OctreeNode(const BBoxf& bounds, unsigned int minSize) :
+        OctreeNode::OctreeNode(const BBoxf& bounds, unsigned int minSize, float looseness, OctreeNode* parent) :
         m_minSize(minSize),
-        m_bounds(bounds) {
+        m_looseness(looseness),
+        m_bounds(bounds),
+        m_looseBounds(bounds),
+        m_parent(parent),
+        m_pruneRequested(false) {
+            const float margin = (m_looseness - 1.0f) * (m_bounds.max[0] - m_bounds.min[0]) / 2.0f;
+            for (size_t i = 0; i < 3; i++) {
+                m_looseBounds.min[i] -= margin;
+                m_looseBounds.max[i] += margin;
+            }
             for (unsigned int i = 0; i < 8; i++)
                 m_children[i] = NULL;
         }
@@ -113,35 +180,51 @@ namespace TrenchBroom {
         }
         
         bool OctreeNode::addObject(MapObject& object) {
-            if (!m_bounds.contains(object.bounds()))
+            if (!m_looseBounds.contains(object.bounds()))
                 return false;
-            if (m_bounds.max[0] - m_bounds.min[0] > m_minSize)
-                for (unsigned int i = 0; i < 8; i++)
-                    if (addObject(object, i))
-                        return true;
-            m_objects.push_back(&object);
+            
+            OctreeNode* node = this;
+            unsigned int index;
+            while (node->m_bounds.max[0] - node->m_bounds.min[0] > m_minSize && (index = node->childIndex(object.bounds())) < 8)
+                node = &node->getOrCreateChild(index);
+            node->insertObject(object);
             return true;
         }
         
-        bool OctreeNode::removeObject(MapObject& object) {
-            if (!m_bounds.contains(object.bounds()))
-                return false;
+        void OctreeNode::removeObject(MapObject& object) {
+            assert(object.octreeNode() == this);
+            
+            const size_t index = object.octreeIndex();
+            assert(index < m_objects.size() && m_objects[index] == &object);
+            
+            MapObject* last = m_objects.back();
+            m_objects[index] = last;
+            last->setOctreeNode(this, index);
+            m_objects.pop_back();
+            object.setOctreeNode(NULL, 0);
+        }
+        
+        void OctreeNode::requestPrune() {
+            OctreeNode* node = this;
+            while (node != NULL && !node->m_pruneRequested) {
+                node->m_pruneRequested = true;
+                node = node->m_parent;
+            }
+        }
+        
+        void OctreeNode::prune() {
+            if (!m_pruneRequested)
+                return;
             for (unsigned int i = 0; i < 8; i++) {
-                if (m_children[i] != NULL && m_children[i]->removeObject(object)) {
+                if (m_children[i] != NULL) {
+                    m_children[i]->prune();
                     if (m_children[i]->empty()) {
                         delete m_children[i];
                         m_children[i] = NULL;
                     }
-                    return true;
                 }
             }
-
-            MapObjectList::iterator it = find(m_objects.begin(), m_objects.end(), &object);
-            if (it == m_objects.end())
-                return false;
-
-            m_objects.erase(it);
-            return true;
+            m_pruneRequested = false;
         }
         
         bool OctreeNode::empty() const {
@@ -162,19 +245,15 @@ namespace TrenchBroom {
             return count;
         }
 
-        void OctreeNode::intersect(const Rayf& ray, MapObjectList& objects) {
-            if (m_bounds.contains(ray.origin) || !Math<float>::isnan(m_bounds.intersectWithRay(ray))) {
-                objects.insert(objects.end(), m_objects.begin(), m_objects.end());
-                for (unsigned int i = 0; i < 8; i++)
-                    if (m_children[i] != NULL)
-                        m_children[i]->intersect(ray, objects);
-            }
-        }
-        
-        Octree::Octree(Map& map, unsigned int minSize) :
+        Octree::Octree(Map& map, unsigned int minSize, float looseness) :
         m_minSize(minSize),
+        m_looseness(looseness),
         m_map(map),
-        m_root(new OctreeNode(map.worldBounds(), minSize)) {}
+        m_root(new OctreeNode(map.worldBounds(), minSize, looseness)),
+        m_rayCount(0),
+        m_rayNodeCount(0),
+        m_rayObjectCount(0),
+        m_rayCandidateCount(0) {}
         
         Octree::~Octree() {
             delete m_root;
@@ -196,7 +275,7 @@ namespace TrenchBroom {
         
         void Octree::clear() {
             delete m_root;
-            m_root = new OctreeNode(m_map.worldBounds(), m_minSize);
+            m_root = new OctreeNode(m_map.worldBounds(), m_minSize, m_looseness);
         }
         
         void Octree::addObject(MapObject& object) {
@@ -214,27 +293,107 @@ namespace TrenchBroom {
         }
         
         void Octree::removeObject(MapObject& object) {
-            bool result = m_root->removeObject(object);
-            assert(result);
+            OctreeNode* node = object.octreeNode();
+            assert(node != NULL);
+            if (node == NULL)
+                return;
+            
+            node->removeObject(object);
+            node->requestPrune();
+            m_root->prune();
         }
         
         void Octree::removeObjects(const MapObjectList& objects) {
-            bool result;
             for (unsigned int i = 0; i < objects.size(); i++) {
                 MapObject* object = objects[i];
-                result = m_root->removeObject(*object);
-                assert(result);
+                OctreeNode* node = object->octreeNode();
+                assert(node != NULL);
+                if (node != NULL) {
+                    node->removeObject(*object);
+                    node->requestPrune();
+                }
             }
+            m_root->prune();
         }
         
         size_t Octree::count() const {
             return m_root->count();
         }
+        
+        void Octree::printStatistics(Utility::Console& console) const {
+            std::vector<size_t> nodesPerLevel;
+            std::vector<size_t> objectsPerLevel;
+            
+            std::vector<std::pair<const OctreeNode*, size_t> > nodes;
+            nodes.push_back(std::make_pair(static_cast<const OctreeNode*>(m_root), 0));
+            while (!nodes.empty()) {
+                const OctreeNode* node = nodes.back().first;
+                const size_t level = nodes.back().second;
+                nodes.pop_back();
+                
+                if (level >= nodesPerLevel.size()) {
+                    nodesPerLevel.resize(level + 1, 0);
+                    objectsPerLevel.resize(level + 1, 0);
+                }
+                nodesPerLevel[level]++;
+                objectsPerLevel[level] += node->objects().size();
+                
+                for (unsigned int i = 0; i < 8; i++)
+                    if (node->child(i) != NULL)
+                        nodes.push_back(std::make_pair(node->child(i), level + 1));
+            }
+            
+            console.info("Octree with looseness %.2f contains %u objects", m_looseness, static_cast<unsigned int>(count()));
+            for (size_t i = 0; i < nodesPerLevel.size(); i++) {
+                const float size = (m_root->bounds().max[0] - m_root->bounds().min[0]) / static_cast<float>(1 << i);
+                console.info("Level %u (cell size %.0f): %u nodes, %u objects", static_cast<unsigned int>(i), size, static_cast<unsigned int>(nodesPerLevel[i]), static_cast<unsigned int>(objectsPerLevel[i]));
+            }
+            if (m_rayCount > 0) {
+                const float rayCount = static_cast<float>(m_rayCount);
+                console.info("%u rays, per ray: %.1f nodes and %.1f objects tested, %.1f candidates found", static_cast<unsigned int>(m_rayCount), m_rayNodeCount / rayCount, m_rayObjectCount / rayCount, m_rayCandidateCount / rayCount);
+            }
+            
+            m_rayCount = 0;
+            m_rayNodeCount = 0;
+            m_rayObjectCount = 0;
+            m_rayCandidateCount = 0;
+        }
 
-        MapObjectList Octree::intersect(const Rayf& ray) {
-            MapObjectList result;
-            m_root->intersect(ray, result);
-            return result;
+        void Octree::intersect(const Rayf& ray, RayCandidateList& candidates) const {
+            Vec3f inverseDirection;
+            for (size_t i = 0; i < 3; i++)
+                inverseDirection[i] = 1.0f / ray.direction[i];
+            
+            float distance;
+            std::vector<const OctreeNode*> nodes;
+            if (intersectBounds(m_root->looseBounds(), ray, inverseDirection, distance))
+                nodes.push_back(m_root);
+            
+            while (!nodes.empty()) {
+                const OctreeNode* node = nodes.back();
+                nodes.pop_back();
+                
+                const MapObjectList& objects = node->objects();
+                m_rayNodeCount++;
+                m_rayObjectCount += objects.size();
+                for (size_t i = 0; i < objects.size(); i++) {
+                    MapObject* object = objects[i];
+                    // hits can lie slightly outside of the bounds due to rounding errors
+                    if (intersectBounds(object->bounds(), ray, inverseDirection, distance))
+                        candidates.push_back(RayCandidate(object, std::max(0.0f, distance - Math<float>::PointStatusEpsilon)));
+                }
+                
+                for (unsigned int i = 0; i < 8; i++) {
+                    const OctreeNode* child = node->child(i);
+                    if (child != NULL && intersectBounds(child->looseBounds(), ray, inverseDirection, distance))
+                        nodes.push_back(child);
+                }
+            }
+            
+            std::sort(candidates.begin(), candidates.end(), CompareRayCandidatesByDistance());
+            
+            m_rayCount++;
+            m_rayCandidateCount += candidates.size();
         }
     }
 }
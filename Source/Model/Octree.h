@@ -29,9 +29,31 @@
 using namespace TrenchBroom::VecMath;
 
 namespace TrenchBroom {
+    namespace Utility {
+        class Console;
+    }
+    
     namespace Model {
         class Map;
         
+        struct RayCandidate {
+            MapObject* object;
+            float distance; // no hit on the object is closer than this
+            
+            RayCandidate(MapObject* i_object, float i_distance) :
+            object(i_object),
+            distance(i_distance) {}
+        };
+        
+        typedef std::vector<RayCandidate> RayCandidateList;
+        
+        class CompareRayCandidatesByDistance {
+        public:
+            inline bool operator() (const RayCandidate& left, const RayCandidate& right) const {
+                return left.distance < right.distance;
+            }
+        };
+        
         class OctreeNode {
         private:
             typedef enum {
@@ -46,27 +68,72 @@ namespace TrenchBroom {
             } NodePosition;
             
             unsigned int m_minSize;
+            float m_looseness;
             BBoxf m_bounds;
+            BBoxf m_looseBounds;
+            OctreeNode* m_parent;
+            bool m_pruneRequested;
             MapObjectList m_objects;
             OctreeNode* m_children[8];
-            bool addObject(MapObject& object, unsigned int childIndex);
+            
+            OctreeNode& getOrCreateChild(unsigned int childIndex);
+            unsigned int childIndex(const BBoxf& bounds) const;
+            void insertObject(MapObject& object);
         public:
-            OctreeNode(const BBoxf& bounds, unsigned int minSize);
+            /**
+             * Creates a node for the given cell. The node accepts objects which are contained in the cell enlarged by
+             * the given looseness factor, so that objects which straddle the boundaries between cells do not have to
+             * stay in the upper levels of the tree. A looseness of 1 yields a regular octree.
+             */
+            OctreeNode(const BBoxf& bounds, unsigned int minSize, float looseness, OctreeNode* parent = NULL);
             ~OctreeNode();
             bool addObject(MapObject& object);
-            bool removeObject(MapObject& object);
+            
+            /**
+             * Removes the given object, which must be held by this node, in constant time by moving the last object of
+             * this node into its slot. This node is not deleted if it becomes empty, call requestPrune for that.
+             */
+            void removeObject(MapObject& object);
+            
+            /**
+             * Marks the path from the root to this node so that the next call to prune on the root deletes this node
+             * and its ancestors if they have become empty. Only the marked paths are visited by prune.
+             */
+            void requestPrune();
+            void prune();
             bool empty() const;
             size_t count() const;
-            void intersect(const Rayf& ray, MapObjectList& objects);
+            
+            inline const BBoxf& bounds() const {
+                return m_bounds;
+            }
+            
+            inline const BBoxf& looseBounds() const {
+                return m_looseBounds;
+            }
+            
+            inline const MapObjectList& objects() const {
+                return m_objects;
+            }
+            
+            inline const OctreeNode* child(unsigned int index) const {
+                return m_children[index];
+            }
         };
         
         class Octree {
         private:
             unsigned int m_minSize;
+            float m_looseness;
             Map& m_map;
             OctreeNode* m_root;
+            
+            mutable size_t m_rayCount;
+            mutable size_t m_rayNodeCount;
+            mutable size_t m_rayObjectCount;
+            mutable size_t m_rayCandidateCount;
         public:
-            Octree(Map& map, unsigned int minSize = 64);
+            Octree(Map& map, unsigned int minSize = 64, float looseness = 1.0f);
             ~Octree();
             
             void loadMap();
@@ -77,8 +144,19 @@ namespace TrenchBroom {
             void removeObjects(const MapObjectList& objects);
             
             size_t count() const;
+            
+            /**
+             * Prints the number of nodes and objects per level of the tree and the average numbers of nodes and objects
+             * tested and candidates found per ray since the last call.
+             */
+            void printStatistics(Utility::Console& console) const;
 
-            MapObjectList intersect(const Rayf& ray);
+            /**
+             * Collects the objects whose bounds are hit by the given ray, ordered by the distance at which the ray enters
+             * their bounds. That distance is a lower bound for the distance of any hit on the object, so picking can stop
+             * once the nearest hit is known.
+             */
+            void intersect(const Rayf& ray, RayCandidateList& candidates) const;
         };
     }
 }
@@ -18,11 +18,13 @@
  */
 
 #include "Picker.h"
+#include "Model/Brush.h"
 #include "Model/Face.h"
 #include "Model/MapObject.h"
 #include "Model/Octree.h"
 
 #include <algorithm>
+#include <limits>
 
 namespace TrenchBroom {
     namespace Model {
@@ -66,9 +68,39 @@ namespace TrenchBroom {
 
         void PickResult::add(Hit* hit) {
             m_hits.push_back(hit);
+            m_sorted = false;
         }
 
-        Hit* PickResult::first(HitType::Type typeMask, bool ignoreOccluders, Filter& filter) {
+        void PickResult::pickCandidates(size_t first, size_t last) {
+            // brushes are picked together because that is faster than picking them one at a time
+            BrushList brushes;
+            for (size_t i = first; i < last; i++) {
+                MapObject* object = m_candidates[i].object;
+                if (object->objectType() == MapObject::BrushObject)
+                    brushes.push_back(static_cast<Brush*>(object));
+                else
+                    object->pick(m_ray, *this);
+            }
+            Brush::pick(brushes, m_ray, *this);
+        }
+        
+        void PickResult::pickCandidates(float maxDistance) {
+            // pick at least all objects at the next distance, which may be all objects of one octree node
+            const float distance = std::max(maxDistance, m_candidates[m_nextCandidate].distance);
+            size_t last = m_nextCandidate;
+            while (last < m_candidates.size() && m_candidates[last].distance <= distance)
+                last++;
+            pickCandidates(m_nextCandidate, last);
+            m_nextCandidate = last;
+        }
+        
+        void PickResult::pickAllCandidates() {
+            pickCandidates(m_nextCandidate, m_candidates.size());
+            m_nextCandidate = m_candidates.size();
+        }
+        
+        Hit* PickResult::firstHit(HitType::Type typeMask, bool ignoreOccluders, Filter& filter, float& decidingDistance) {
+            decidingDistance = std::numeric_limits<float>::max();
             if (!m_hits.empty()) {
                 if (!m_sorted)
                     sortHits();
@@ -76,6 +108,7 @@ namespace TrenchBroom {
                     unsigned int i = 0;
                     while (i < m_hits.size()) {
                         if (m_hits[i]->pickable(filter)) {
+                            decidingDistance = m_hits[i]->distance();
                             if (m_hits[i]->hasType(typeMask))
                                 return m_hits[i];
                             break;
@@ -90,15 +123,39 @@ namespace TrenchBroom {
                                 return m_hits[i];
                     }
                 } else {
-                    for (unsigned int i = 0; i < m_hits.size(); i++)
-                        if (m_hits[i]->hasType(typeMask) && m_hits[i]->pickable(filter))
+                    for (unsigned int i = 0; i < m_hits.size(); i++) {
+                        if (m_hits[i]->hasType(typeMask) && m_hits[i]->pickable(filter)) {
+                            decidingDistance = m_hits[i]->distance();
                             return m_hits[i];
+                        }
+                    }
                 }
             }
             return NULL;
         }
+        
+        Hit* PickResult::first(HitType::Type typeMask, bool ignoreOccluders, Filter& filter) {
+            float decidingDistance;
+            Hit* hit = firstHit(typeMask, ignoreOccluders, filter, decidingDistance);
+            if (ignoreOccluders && (typeMask & HitType::ObjectHit) == 0)
+                return hit;
+            
+            // the result is final once no unpicked object can have a hit that is closer than the deciding hit; without a
+            // deciding hit, only the objects at the next distance are picked
+            while (m_nextCandidate < m_candidates.size() && decidingDistance >= m_candidates[m_nextCandidate].distance) {
+                if (decidingDistance == std::numeric_limits<float>::max())
+                    pickCandidates(m_candidates[m_nextCandidate].distance);
+                else
+                    pickCandidates(decidingDistance);
+                hit = firstHit(typeMask, ignoreOccluders, filter, decidingDistance);
+            }
+            return hit;
+        }
 
         HitList PickResult::hits(HitType::Type typeMask, Filter& filter) {
+            if ((typeMask & HitType::ObjectHit) != 0)
+                pickAllCandidates();
+            
             HitList result;
             if (!m_sorted) sortHits();
             for (unsigned int i = 0; i < m_hits.size(); i++)
@@ -111,17 +168,5 @@ namespace TrenchBroom {
             return hits(HitType::Any, filter);
         }
 
-        Picker::Picker(Octree& octree) : m_octree(octree) {}
-
-        PickResult* Picker::pick(const Rayf& ray) {
-            PickResult* pickResults = new PickResult();
-
-            MapObjectList objects = m_octree.intersect(ray);
-            for (unsigned int i = 0; i < objects.size(); i++)
-                objects[i]->pick(ray, *pickResults);
-
-            return pickResults;
-        }
-
     }
 }
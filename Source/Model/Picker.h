@@ -21,6 +21,7 @@
 #define TrenchBroom_Picker_h
 
 #include "Model/Filter.h"
+#include "Model/Octree.h"
 #include "Utility/VecMath.h"
 
 using namespace TrenchBroom::VecMath;
@@ -31,7 +32,6 @@ namespace TrenchBroom {
         class Brush;
         class Face;
         class Filter;
-        class Octree;
 
         namespace HitType {
             typedef unsigned int Type;
@@ -122,9 +122,29 @@ namespace TrenchBroom {
         private:
             HitList m_hits;
             bool m_sorted;
+            
+            // map objects are only picked when a query needs their hits
+            Rayf m_ray;
+            RayCandidateList m_candidates;
+            size_t m_nextCandidate;
+            
             void sortHits();
+            void pickCandidates(size_t first, size_t last);
+            void pickCandidates(float maxDistance);
+            void pickAllCandidates();
+            Hit* firstHit(HitType::Type typeMask, bool ignoreOccluders, Filter& filter, float& decidingDistance);
         public:
-            PickResult() : m_sorted(false) {}
+            PickResult() :
+            m_sorted(false),
+            m_nextCandidate(0) {}
+            
+            PickResult(const Rayf& ray, RayCandidateList& candidates) :
+            m_sorted(false),
+            m_ray(ray),
+            m_nextCandidate(0) {
+                m_candidates.swap(candidates);
+            }
+            
             ~PickResult();
             
             void add(Hit* hit);
@@ -137,8 +157,14 @@ namespace TrenchBroom {
         private:
             Octree& m_octree;
         public:
-            Picker(Octree& octree);
-            PickResult* pick(const Rayf& ray);
+            Picker(Octree& octree) :
+            m_octree(octree) {}
+            
+            inline PickResult* pick(const Rayf& ray) {
+                RayCandidateList candidates;
+                m_octree.intersect(ray, candidates);
+                return new PickResult(ray, candidates);
+            }
         };
     }
 }
@@ -27,10 +27,10 @@ namespace TrenchBroom {
         TextureCollectionLoader::TextureCollectionLoader(const String& path) throw (IO::IOException) :
         m_wad(path) {}
 
-        unsigned char* TextureCollectionLoader::load(const Texture& texture, const Renderer::Palette& palette, Color& averageColor) throw (IO::IOException) {
+        unsigned char* TextureCollectionLoader::load(const String& textureName, const Renderer::Palette& palette, Color& averageColor) const {
             IO::Mip* mip = NULL;
             try {
-                mip = m_wad.loadMip(texture.name(), 1);
+                mip = m_wad.loadMip(textureName, 1);
             } catch (IO::IOException&) {
                  delete mip;
                 return NULL;
@@ -38,7 +38,7 @@ namespace TrenchBroom {
 
             assert(mip != NULL);
 
-            size_t pixelCount = texture.width() * texture.height();
+            size_t pixelCount = mip->width() * mip->height();
             unsigned char* rgbImage = new unsigned char[pixelCount * 3];
             palette.indexedToRgb(mip->mip0(), rgbImage, pixelCount, averageColor);
             delete mip;
@@ -46,6 +46,25 @@ namespace TrenchBroom {
             return rgbImage;
         }
 
+        bool TextureCollectionLoader::loadAverageColor(const String& textureName, const Renderer::Palette& palette, Color& averageColor) const {
+            IO::Mip* mip = NULL;
+            try {
+                mip = m_wad.loadSmallestMip(textureName);
+            } catch (IO::IOException&) {
+                return false;
+            }
+            
+            assert(mip != NULL);
+            
+            size_t pixelCount = mip->width() * mip->height();
+            unsigned char* rgbImage = new unsigned char[pixelCount * 3];
+            palette.indexedToRgb(mip->mip0(), rgbImage, pixelCount, averageColor);
+            delete [] rgbImage;
+            delete mip;
+            
+            return true;
+        }
+
         TextureCollection::TextureCollection(const String& name, const String& path) throw (IO::IOException) :
         m_name(name),
         m_path(path) {
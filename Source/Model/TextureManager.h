@@ -68,7 +68,10 @@ namespace TrenchBroom {
             IO::Wad m_wad;
         public:
             TextureCollectionLoader(const String& path) throw (IO::IOException);
-            unsigned char* load(const Texture& texture, const Renderer::Palette& palette, Color& averageColor) throw (IO::IOException);
+            
+            // may be called from several threads at once, the average color is computed from the smallest mip level
+            unsigned char* load(const String& textureName, const Renderer::Palette& palette, Color& averageColor) const;
+            bool loadAverageColor(const String& textureName, const Renderer::Palette& palette, Color& averageColor) const;
         };
         
         class TextureCollection {
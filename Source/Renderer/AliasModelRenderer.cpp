@@ -33,6 +33,32 @@
 
 namespace TrenchBroom {
     namespace Renderer {
+        void AliasModelRenderer::buildVertexArray() {
+            assert(m_skinIndex < m_alias.skins().size());
+            assert(m_frameIndex < m_alias.frames().size());
+            
+            Model::AliasSkin& skin = *m_alias.skins()[m_skinIndex];
+            m_texture = TextureRendererPtr(new TextureRenderer(skin, 0, m_palette));
+            
+            Model::AliasSingleFrame& frame = m_alias.frame(m_frameIndex);
+            const Model::AliasFrameTriangleList& triangles = frame.triangles();
+            unsigned int vertexCount = static_cast<unsigned int>(3 * triangles.size());
+            
+            m_vertexArray = new VertexArray(m_vbo, GL_TRIANGLES, vertexCount,
+                                            Attribute::position3f(),
+                                            Attribute::texCoord02f());
+            
+            SetVboState mapVbo(m_vbo, Vbo::VboMapped);
+            for (unsigned int i = 0; i < triangles.size(); i++) {
+                Model::AliasFrameTriangle& triangle = *triangles[i];
+                for (unsigned int j = 0; j < 3; j++) {
+                    Model::AliasFrameVertex& vertex = triangle[j];
+                    m_vertexArray->addAttribute(vertex.position());
+                    m_vertexArray->addAttribute(vertex.texCoords());
+                }
+            }
+        }
+        
         AliasModelRenderer::AliasModelRenderer(const Model::Alias& alias, unsigned int frameIndex, unsigned int skinIndex, Vbo& vbo, const Palette& palette) :
         m_alias(alias),
         m_frameIndex(frameIndex),
@@ -50,31 +76,8 @@ namespace TrenchBroom {
         }
 
         void AliasModelRenderer::render(ShaderProgram& shaderProgram) {
-            if (m_vertexArray == NULL) {
-                assert(m_skinIndex < m_alias.skins().size());
-                assert(m_frameIndex < m_alias.frames().size());
-                
-                Model::AliasSkin& skin = *m_alias.skins()[m_skinIndex];
-                m_texture = TextureRendererPtr(new TextureRenderer(skin, 0, m_palette));
-
-                Model::AliasSingleFrame& frame = m_alias.frame(m_frameIndex);
-                const Model::AliasFrameTriangleList& triangles = frame.triangles();
-                unsigned int vertexCount = static_cast<unsigned int>(3 * triangles.size());
-                
-                m_vertexArray = new VertexArray(m_vbo, GL_TRIANGLES, vertexCount,
-                                                Attribute::position3f(),
-                                                Attribute::texCoord02f());
-
-                SetVboState mapVbo(m_vbo, Vbo::VboMapped);
-                for (unsigned int i = 0; i < triangles.size(); i++) {
-                    Model::AliasFrameTriangle& triangle = *triangles[i];
-                    for (unsigned int j = 0; j < 3; j++) {
-                        Model::AliasFrameVertex& vertex = triangle[j];
-                        m_vertexArray->addAttribute(vertex.position());
-                        m_vertexArray->addAttribute(vertex.texCoords());
-                    }
-                }
-            }
+            if (m_vertexArray == NULL)
+                buildVertexArray();
 
             assert(m_vertexArray != NULL);
             
@@ -85,6 +88,19 @@ namespace TrenchBroom {
             m_texture->deactivate();
         }
 
+        void AliasModelRenderer::renderInstances(ShaderProgram& shaderProgram, unsigned int instanceCount) {
+            if (m_vertexArray == NULL)
+                buildVertexArray();
+            
+            assert(m_vertexArray != NULL);
+            
+            glActiveTexture(GL_TEXTURE0);
+            m_texture->activate();
+            shaderProgram.setUniformVariable("Texture", 0);
+            m_vertexArray->renderInstances(instanceCount);
+            m_texture->deactivate();
+        }
+
         const Vec3f& AliasModelRenderer::center() const {
             return m_alias.frame(m_frameIndex).center();
         }
@@ -93,6 +93,11 @@ namespace TrenchBroom {
                 return attr;
             }
             
+            static const Attribute& texCoord14f() {
+                static const Attribute attr = Attribute(4, GL_FLOAT, TexCoord1);
+                return attr;
+            }
+            
             inline GLint size() const {
                 return m_size;
             }
@@ -341,6 +346,27 @@ namespace TrenchBroom {
                 return m_vertexCount;
             }
             
+            inline size_t vertexCapacity() const {
+                return m_vertexCapacity;
+            }
+            
+            // moves the write position to the given vertex so that previously written vertices can be replaced
+            inline void seek(size_t index) {
+                assert(m_specIndex == 0);
+                assert(index <= m_vertexCapacity);
+                
+                m_writeOffset = index * (m_vertexSize + m_padBy);
+                m_vertexCount = index;
+            }
+            
+            inline void clearVertices(size_t index, size_t count) {
+                assert(m_specIndex == 0);
+                assert(index + count <= m_vertexCount);
+                
+                const size_t stride = m_vertexSize + m_padBy;
+                m_block->clear(index * stride, count * stride);
+            }
+            
             inline void addAttribute(float value) {
                 assert(m_vertexCount < m_vertexCapacity);
                 assert(m_attributes[m_specIndex].valueType() == GL_FLOAT);
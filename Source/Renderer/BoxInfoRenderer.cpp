@@ -195,8 +195,11 @@ namespace TrenchBroom {
             Preferences::PreferenceManager& prefs = Preferences::PreferenceManager::preferences();
             const Color& textColor = prefs.getColor(Preferences::InfoOverlayTextColor);
             const Color& backgroundColor = prefs.getColor(Preferences::InfoOverlayBackgroundColor);
-            ShaderProgram& textShader = context.shaderManager().shaderProgram(Shaders::TextShader);
-            ShaderProgram& backgroundShader = context.shaderManager().shaderProgram(Shaders::TextBackgroundShader);
+            ShaderProgram& textShader = context.shaderManager().shaderProgram(Shaders::TextLabelShader);
+            ShaderProgram& backgroundShader = context.shaderManager().shaderProgram(Shaders::TextLabelBackgroundShader);
+            
+            // the label anchors depend on the camera position
+            m_textRenderer->invalidate();
             
             glDisable(GL_DEPTH_TEST);
             m_textRenderer->render(context, m_textFilter, textShader, textColor, backgroundShader, backgroundColor);
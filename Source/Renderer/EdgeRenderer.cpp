@@ -24,11 +24,13 @@
 #include "Model/Entity.h"
 #include "Model/EntityDefinition.h"
 #include "Model/Face.h"
+#include "Renderer/ElementVertexArray.h"
 #include "Renderer/RenderContext.h"
-#include "Renderer/VertexArray.h"
 #include "Renderer/Shader/ShaderManager.h"
 #include "Renderer/Shader/ShaderProgram.h"
 
+#include <algorithm>
+
 namespace TrenchBroom {
     namespace Renderer {
         unsigned int EdgeRenderer::vertexCount(const Model::BrushList& brushes, const Model::FaceList& faces) {
@@ -38,124 +40,304 @@ namespace TrenchBroom {
             
             for (brushIt = brushes.begin(), brushEnd = brushes.end(); brushIt != brushEnd; ++brushIt) {
                 const Model::Brush& brush = **brushIt;
-                vertexCount += brush.edges().size();
+                vertexCount += brush.vertices().size();
             }
             
             for (faceIt = faces.begin(), faceEnd = faces.end(); faceIt != faceEnd; ++faceIt) {
                 const Model::Face& face = **faceIt;
-                vertexCount += face.edges().size();
+                vertexCount += face.vertices().size();
             }
             
-            return 2 * vertexCount;
+            return vertexCount;
         }
         
-        void EdgeRenderer::writeEdgeData(Vbo& vbo, const Model::BrushList& brushes, const Model::FaceList& faces) {
-            m_vertexArray = new VertexArray(vbo, GL_LINES, vertexCount(brushes, faces),
-                                            Attribute::position3f());
-
-            Model::BrushList::const_iterator brushIt, brushEnd;
-            for (brushIt = brushes.begin(), brushEnd = brushes.end(); brushIt != brushEnd; ++brushIt) {
-                const Model::Brush& brush = **brushIt;
-                const Model::EdgeList& edges = brush.edges();
-                Model::EdgeList::const_iterator edgeIt, edgeEnd;
-                for (edgeIt = edges.begin(), edgeEnd = edges.end(); edgeIt != edgeEnd; ++edgeIt) {
-                    const Model::Edge& edge = **edgeIt;
-                    m_vertexArray->addAttribute(edge.start->position);
-                    m_vertexArray->addAttribute(edge.end->position);
+        const Color& EdgeRenderer::edgeColor(const Model::Brush& brush) const {
+            const Model::Entity* entity = brush.entity();
+            const Model::EntityDefinition* definition = entity != NULL ? entity->definition() : NULL;
+            return (entity != NULL && !entity->worldspawn() && definition != NULL && definition->type() == Model::EntityDefinition::BrushEntity) ? definition->color() : m_defaultColor;
+        }
+        
+        void EdgeRenderer::renderBuckets(FrustumCuller& frustumCuller) {
+            EdgeBucketMap::const_iterator it, end;
+            for (it = m_buckets.begin(), end = m_buckets.end(); it != end; ++it) {
+                const EdgeBucket& bucket = *it->second;
+                if (bucket.vertexArray != NULL && frustumCuller.visible(bucket.bounds))
+                    bucket.vertexArray->render();
+            }
+        }
+        
+        EdgeRenderer::EdgeBucket& EdgeRenderer::bucket(const Model::Brush& brush) {
+            const BBoxf& bounds = brush.bounds();
+            const CullingBucket key(bounds);
+            
+            EdgeBucketMap::iterator it = m_buckets.find(key);
+            if (it == m_buckets.end())
+                it = m_buckets.insert(EdgeBucketMap::value_type(key, new EdgeBucket(key, bounds))).first;
+            else
+                it->second->bounds.mergeWith(bounds);
+            return *it->second;
+        }
+        
+        size_t EdgeRenderer::localVertexIndex(const Model::Vertex* vertex) const {
+            VertexIndexList::const_iterator it = std::lower_bound(m_vertexIndices.begin(), m_vertexIndices.end(), VertexIndex(vertex, 0));
+            assert(it != m_vertexIndices.end() && it->first == vertex);
+            return it->second;
+        }
+        
+        ElementVertexArray* EdgeRenderer::createVertexArray(size_t vertexCapacity, size_t indexCapacity) {
+            if (m_colored)
+                return new ElementVertexArray(m_vbo, GL_LINES, vertexCapacity, indexCapacity,
+                                              Attribute::position3f(),
+                                              Attribute::color4f());
+            return new ElementVertexArray(m_vbo, GL_LINES, vertexCapacity, indexCapacity,
+                                          Attribute::position3f());
+        }
+        
+        void EdgeRenderer::writeVertices(ElementVertexArray& vertexArray, const Model::VertexList& vertices, const Color& color) {
+            Model::VertexList::const_iterator vertexIt, vertexEnd;
+            if (m_colored) {
+                for (vertexIt = vertices.begin(), vertexEnd = vertices.end(); vertexIt != vertexEnd; ++vertexIt) {
+                    vertexArray.addAttribute((*vertexIt)->position);
+                    vertexArray.addAttribute(color);
                 }
+            } else {
+                for (vertexIt = vertices.begin(), vertexEnd = vertices.end(); vertexIt != vertexEnd; ++vertexIt)
+                    vertexArray.addAttribute((*vertexIt)->position);
             }
+        }
+        
+        // writes the brush's vertices at the current position and its edges as index pairs at the given index
+        void EdgeRenderer::writeBrushEdges(ElementVertexArray& vertexArray, const Model::Brush& brush, size_t vertexIndex, size_t indexIndex) {
+            const Model::VertexList& vertices = brush.vertices();
+            writeVertices(vertexArray, vertices, m_colored ? edgeColor(brush) : m_defaultColor);
             
-            Model::FaceList::const_iterator faceIt, faceEnd;
-            for (faceIt = faces.begin(), faceEnd = faces.end(); faceIt != faceEnd; ++faceIt) {
-                const Model::Face& face = **faceIt;
-                const Model::EdgeList& edges = face.edges();
-                Model::EdgeList::const_iterator edgeIt, edgeEnd;
-                for (edgeIt = edges.begin(), edgeEnd = edges.end(); edgeIt != edgeEnd; ++edgeIt) {
-                    const Model::Edge& edge = **edgeIt;
-                    m_vertexArray->addAttribute(edge.start->position);
-                    m_vertexArray->addAttribute(edge.end->position);
+            m_vertexIndices.clear();
+            m_vertexIndices.reserve(vertices.size());
+            for (size_t i = 0; i < vertices.size(); i++)
+                m_vertexIndices.push_back(VertexIndex(vertices[i], i));
+            std::sort(m_vertexIndices.begin(), m_vertexIndices.end());
+            
+            const Model::EdgeList& edges = brush.edges();
+            for (size_t i = 0; i < edges.size(); i++) {
+                const size_t start = vertexIndex + localVertexIndex(edges[i]->start);
+                const size_t end = vertexIndex + localVertexIndex(edges[i]->end);
+                if (indexIndex < vertexArray.indexCount()) {
+                    vertexArray.setIndex(indexIndex, start);
+                    vertexArray.setIndex(indexIndex + 1, end);
+                } else {
+                    vertexArray.addIndex(start);
+                    vertexArray.addIndex(end);
                 }
+                indexIndex += 2;
             }
         }
         
-        void EdgeRenderer::writeEdgeData(Vbo& vbo, const Model::BrushList& brushes, const Model::FaceList& faces, const Color& defaultColor) {
-            m_vertexArray = new VertexArray(vbo, GL_LINES, vertexCount(brushes, faces),
-                                            Attribute::position3f(),
-                                            Attribute::color4f());
-
-            Model::BrushList::const_iterator brushIt, brushEnd;
-            for (brushIt = brushes.begin(), brushEnd = brushes.end(); brushIt != brushEnd; ++brushIt) {
-                const Model::Brush& brush = **brushIt;
-                const Model::Entity* entity = brush.entity();
-                const Model::EntityDefinition* definition = entity != NULL ? entity->definition() : NULL;
-                const Color& color = (entity != NULL && !entity->worldspawn() && definition != NULL && definition->type() == Model::EntityDefinition::BrushEntity) ? definition->color() : defaultColor;
+        EdgeRenderer::BrushSlot EdgeRenderer::writeBrush(EdgeBucket& bucket, Model::Brush* brush) {
+            const size_t vertexCount = brush->vertices().size();
+            const size_t indexCount = 2 * brush->edges().size();
+            assert(vertexCount > 0);
+            
+            FreeSlotMap::iterator freeIt = bucket.freeSlots.find(FreeSlotKey(vertexCount, indexCount));
+            if (freeIt != bucket.freeSlots.end()) {
+                const BrushSlot slot = freeIt->second;
+                bucket.freeSlots.erase(freeIt);
+                bucket.freeVertexCount -= vertexCount;
+                
+                ElementVertexArray& vertexArray = *bucket.vertexArray;
+                const size_t totalVertexCount = vertexArray.vertexCount();
+                vertexArray.seek(slot.vertexIndex);
+                writeBrushEdges(vertexArray, *brush, slot.vertexIndex, slot.indexIndex);
+                vertexArray.seek(totalVertexCount);
                 
-                const Model::EdgeList& edges = brush.edges();
-                Model::EdgeList::const_iterator edgeIt, edgeEnd;
-                for (edgeIt = edges.begin(), edgeEnd = edges.end(); edgeIt != edgeEnd; ++edgeIt) {
-                    const Model::Edge& edge = **edgeIt;
-                    m_vertexArray->addAttribute(edge.start->position);
-                    m_vertexArray->addAttribute(color);
-                    m_vertexArray->addAttribute(edge.end->position);
-                    m_vertexArray->addAttribute(color);
+                bucket.brushes[slot.brushIndex] = brush;
+                return slot;
+            }
+            
+            if (bucket.vertexArray == NULL || bucket.vertexArray->vertexCount() + vertexCount > bucket.vertexArray->vertexCapacity()) {
+                const size_t liveVertexCount = bucket.vertexArray != NULL ? bucket.vertexArray->vertexCount() - bucket.freeVertexCount : 0;
+                writeEdgeData(bucket, 2 * (liveVertexCount + vertexCount));
+                return writeBrush(bucket, brush);
+            }
+            
+            ElementVertexArray& vertexArray = *bucket.vertexArray;
+            const BrushSlot slot(&bucket, bucket.brushes.size(), vertexArray.vertexCount(), vertexCount, vertexArray.indexCount(), indexCount);
+            bucket.brushes.push_back(brush);
+            writeBrushEdges(vertexArray, *brush, slot.vertexIndex, slot.indexIndex);
+            return slot;
+        }
+        
+        void EdgeRenderer::writeFaceEdges(ElementVertexArray& vertexArray, const Model::Face& face) {
+            const Model::VertexList& vertices = face.vertices();
+            const size_t vertexIndex = vertexArray.vertexCount();
+            writeVertices(vertexArray, vertices, m_colored ? edgeColor(*face.brush()) : m_defaultColor);
+            
+            for (size_t i = 0; i < vertices.size(); i++) {
+                vertexArray.addIndex(vertexIndex + i);
+                vertexArray.addIndex(vertexIndex + (i + 1) % vertices.size());
+            }
+        }
+        
+        void EdgeRenderer::writeEdgeData(EdgeBucket& bucket, size_t vertexCapacity) {
+            Model::BrushList brushes;
+            brushes.reserve(bucket.brushes.size());
+            size_t indexCount = 0;
+            for (size_t i = 0; i < bucket.brushes.size(); i++) {
+                if (bucket.brushes[i] != NULL) {
+                    brushes.push_back(bucket.brushes[i]);
+                    indexCount += 2 * bucket.brushes[i]->edges().size();
                 }
             }
+            for (size_t i = 0; i < bucket.faces.size(); i++)
+                indexCount += 2 * bucket.faces[i]->vertices().size();
+            
+            bucket.brushes.clear();
+            bucket.brushes.reserve(brushes.size());
+            bucket.freeSlots.clear();
+            bucket.freeVertexCount = 0;
 
-            Model::FaceList::const_iterator faceIt, faceEnd;
-            for (faceIt = faces.begin(), faceEnd = faces.end(); faceIt != faceEnd; ++faceIt) {
-                const Model::Face& face = **faceIt;
-                const Model::Brush* brush = face.brush();
-                const Model::Entity* entity = brush->entity();
-                const Model::EntityDefinition* definition = entity != NULL ? entity->definition() : NULL;
-                const Color& color = (entity != NULL && !entity->worldspawn() && definition != NULL && definition->type() == Model::EntityDefinition::BrushEntity) ? definition->color() : defaultColor;
+            delete bucket.vertexArray;
+            bucket.vertexArray = NULL;
+            if (vertexCapacity == 0)
+                return;
+            
+            bucket.vertexArray = createVertexArray(vertexCapacity, indexCount);
+            
+            for (size_t i = 0; i < brushes.size(); i++) {
+                Model::Brush* brush = brushes[i];
                 
-                const Model::EdgeList& edges = face.edges();
-                Model::EdgeList::const_iterator edgeIt, edgeEnd;
-                for (edgeIt = edges.begin(), edgeEnd = edges.end(); edgeIt != edgeEnd; ++edgeIt) {
-                    const Model::Edge& edge = **edgeIt;
-                    m_vertexArray->addAttribute(edge.start->position);
-                    m_vertexArray->addAttribute(color);
-                    m_vertexArray->addAttribute(edge.end->position);
-                    m_vertexArray->addAttribute(color);
-                }
+                *m_brushSlots.find(brush) = writeBrush(bucket, brush);
+            }
+            for (size_t i = 0; i < bucket.faces.size(); i++)
+                writeFaceEdges(*bucket.vertexArray, *bucket.faces[i]);
+        }
+        
+        void EdgeRenderer::writeEdgeData(const Model::BrushList& brushes, const Model::FaceList& faces) {
+            // the vertex and index counts of every bucket
+            typedef std::map<EdgeBucket*, std::pair<size_t, size_t> > VertexCountMap;
+            
+            // find the buckets first so that their vertex arrays can be created with the exact capacity
+            std::vector<EdgeBucket*> brushBuckets;
+            std::vector<EdgeBucket*> faceBuckets;
+            brushBuckets.reserve(brushes.size());
+            faceBuckets.reserve(faces.size());
+            VertexCountMap vertexCounts;
+            
+            for (size_t i = 0; i < brushes.size(); i++) {
+                EdgeBucket& brushBucket = bucket(*brushes[i]);
+                std::pair<size_t, size_t>& counts = vertexCounts[&brushBucket];
+                counts.first += brushes[i]->vertices().size();
+                counts.second += 2 * brushes[i]->edges().size();
+                brushBuckets.push_back(&brushBucket);
+            }
+            for (size_t i = 0; i < faces.size(); i++) {
+                EdgeBucket& faceBucket = bucket(*faces[i]->brush());
+                std::pair<size_t, size_t>& counts = vertexCounts[&faceBucket];
+                counts.first += faces[i]->vertices().size();
+                counts.second += 2 * faces[i]->vertices().size();
+                faceBuckets.push_back(&faceBucket);
+            }
+            
+            VertexCountMap::const_iterator it, end;
+            for (it = vertexCounts.begin(), end = vertexCounts.end(); it != end; ++it) {
+                if (it->second.first == 0)
+                    continue;
+                it->first->vertexArray = createVertexArray(it->second.first, it->second.second);
+            }
+            
+            // the brushes are written in the given order, which is usually the order in which they were allocated
+            m_brushSlots.reserve(brushes.size());
+            for (size_t i = 0; i < brushes.size(); i++) {
+                Model::Brush* brush = brushes[i];
+                if (!brush->edges().empty())
+                    m_brushSlots.insert(brush, writeBrush(*brushBuckets[i], brush));
+            }
+            for (size_t i = 0; i < faces.size(); i++) {
+                EdgeBucket& faceBucket = *faceBuckets[i];
+                faceBucket.faces.push_back(faces[i]);
+                writeFaceEdges(*faceBucket.vertexArray, *faces[i]);
             }
         }
 
         EdgeRenderer::EdgeRenderer(Vbo& vbo, const Model::BrushList& brushes, const Model::FaceList& faces) :
-        m_vertexArray(NULL) {
-            writeEdgeData(vbo, brushes, faces);
+        m_vbo(vbo),
+        m_colored(false) {
+            writeEdgeData(brushes, faces);
         }
         
         EdgeRenderer::EdgeRenderer(Vbo& vbo, const Model::BrushList& brushes, const Model::FaceList& faces, const Color& defaultColor) :
-        m_vertexArray(NULL) {
-            writeEdgeData(vbo, brushes, faces, defaultColor);
+        m_vbo(vbo),
+        m_colored(true),
+        m_defaultColor(defaultColor) {
+            writeEdgeData(brushes, faces);
         }
 
         EdgeRenderer::~EdgeRenderer() {
-            delete m_vertexArray;
-            m_vertexArray = NULL;
+            EdgeBucketMap::iterator it, end;
+            for (it = m_buckets.begin(), end = m_buckets.end(); it != end; ++it) {
+                EdgeBucket* bucket = it->second;
+                delete bucket->vertexArray;
+                delete bucket;
+            }
+            m_buckets.clear();
+        }
+        
+        void EdgeRenderer::addBrushes(const Model::BrushList& brushes) {
+            for (size_t i = 0; i < brushes.size(); i++) {
+                Model::Brush* brush = brushes[i];
+                if (brush->edges().empty())
+                    continue;
+                
+                m_brushSlots.insert(brush, writeBrush(bucket(*brush), brush));
+            }
+        }
+        
+        void EdgeRenderer::removeBrushes(const Model::BrushList& brushes) {
+            for (size_t i = 0; i < brushes.size(); i++) {
+                BrushSlot* brushSlot = m_brushSlots.find(brushes[i]);
+                if (brushSlot == NULL)
+                    continue;
+                
+                const BrushSlot slot = *brushSlot;
+                m_brushSlots.erase(brushes[i]);
+                
+                EdgeBucket& bucket = *slot.bucket;
+                bucket.vertexArray->clearVertices(slot.vertexIndex, slot.vertexCount);
+                bucket.brushes[slot.brushIndex] = NULL;
+                bucket.freeSlots.insert(FreeSlotMap::value_type(FreeSlotKey(slot.vertexCount, slot.indexCount), slot));
+                bucket.freeVertexCount += slot.vertexCount;
+                
+                const size_t vertexCount = bucket.vertexArray->vertexCount();
+                if (bucket.freeSlots.size() == bucket.brushes.size() && bucket.faces.empty()) {
+                    m_buckets.erase(bucket.key);
+                    delete bucket.vertexArray;
+                    delete &bucket;
+                } else if (2 * bucket.freeVertexCount > vertexCount) {
+                    writeEdgeData(bucket, vertexCount - bucket.freeVertexCount);
+                }
+            }
         }
-
 
         void EdgeRenderer::render(RenderContext& context) {
-            assert(m_vertexArray != NULL);
+            if (m_buckets.empty())
+                return;
             
             ShaderManager& shaderManager = context.shaderManager();
             ShaderProgram& coloredEdgeProgram = shaderManager.shaderProgram(Shaders::ColoredEdgeShader);
             if (coloredEdgeProgram.activate()) {
-                m_vertexArray->render();
+                renderBuckets(context.frustumCuller());
                 coloredEdgeProgram.deactivate();
             }
         }
         
         void EdgeRenderer::render(RenderContext& context, const Color& color) {
-            assert(m_vertexArray != NULL);
+            if (m_buckets.empty())
+                return;
 
             ShaderManager& shaderManager = context.shaderManager();
             ShaderProgram& edgeProgram = shaderManager.shaderProgram(Shaders::EdgeShader);
             if (edgeProgram.activate()) {
                 edgeProgram.setUniformVariable("Color", color);
-                m_vertexArray->render();
+                renderBuckets(context.frustumCuller());
                 edgeProgram.deactivate();
             }
         }
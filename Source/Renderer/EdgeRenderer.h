@@ -20,28 +20,114 @@
 #ifndef __TrenchBroom__EdgeRenderer__
 #define __TrenchBroom__EdgeRenderer__
 
+#include "Model/BrushGeometryTypes.h"
 #include "Model/BrushTypes.h"
 #include "Model/FaceTypes.h"
+#include "Renderer/FrustumCuller.h"
 #include "Utility/Color.h"
+#include "Utility/LazySortedMap.h"
+
+#include <map>
+#include <vector>
 
 namespace TrenchBroom {
     namespace Renderer {
+        class ElementVertexArray;
         class RenderContext;
         class Vbo;
-        class VertexArray;
         
         class EdgeRenderer {
         protected:
-            VertexArray* m_vertexArray;
+            class EdgeBucket;
+            
+            class BrushSlot {
+            public:
+                EdgeBucket* bucket;
+                size_t brushIndex;
+                size_t vertexIndex;
+                size_t vertexCount;
+                size_t indexIndex;
+                size_t indexCount;
+                
+                BrushSlot(EdgeBucket* i_bucket, size_t i_brushIndex, size_t i_vertexIndex, size_t i_vertexCount,
+                          size_t i_indexIndex, size_t i_indexCount) :
+                bucket(i_bucket),
+                brushIndex(i_brushIndex),
+                vertexIndex(i_vertexIndex),
+                vertexCount(i_vertexCount),
+                indexIndex(i_indexIndex),
+                indexCount(i_indexCount) {}
+            };
+            
+            typedef Utility::LazySortedMap<Model::Brush*, BrushSlot> BrushSlotMap;
+            // free slots by their vertex and index counts
+            typedef std::pair<size_t, size_t> FreeSlotKey;
+            typedef std::multimap<FreeSlotKey, BrushSlot> FreeSlotMap;
+            
+            /*
+             Each culling bucket owns a vertex array which holds the vertices of its brushes and faces once and
+             connects them to edges with line indices. Removed brushes are kept as NULL entries and leave a slot of
+             degenerate lines behind which is reused by the next brush with the same numbers of vertices and edges.
+             The array is rewritten when it must grow or when more than half of it is unused. The bounds only ever
+             grow until the bucket is deleted.
+             */
+            class EdgeBucket {
+            public:
+                CullingBucket key;
+                BBoxf bounds;
+                ElementVertexArray* vertexArray;
+                Model::BrushList brushes;
+                Model::FaceList faces;
+                FreeSlotMap freeSlots;
+                size_t freeVertexCount;
+                
+                EdgeBucket(const CullingBucket& i_key, const BBoxf& i_bounds) :
+                key(i_key),
+                bounds(i_bounds),
+                vertexArray(NULL),
+                freeVertexCount(0) {}
+            };
+            
+            typedef std::map<CullingBucket, EdgeBucket*> EdgeBucketMap;
+            
+            // the local indices of a brush's vertices, sorted by vertex
+            typedef std::pair<const Model::Vertex*, size_t> VertexIndex;
+            typedef std::vector<VertexIndex> VertexIndexList;
+            
+            Vbo& m_vbo;
+            bool m_colored;
+            Color m_defaultColor;
+            EdgeBucketMap m_buckets;
+            BrushSlotMap m_brushSlots;
+            VertexIndexList m_vertexIndices;
             
             unsigned int vertexCount(const Model::BrushList& brushes, const Model::FaceList& faces);
-            void writeEdgeData(Vbo& vbo, const Model::BrushList& brushes, const Model::FaceList& faces);
-            void writeEdgeData(Vbo& vbo, const Model::BrushList& brushes, const Model::FaceList& faces, const Color& defaultColor);
+            const Color& edgeColor(const Model::Brush& brush) const;
+            EdgeBucket& bucket(const Model::Brush& brush);
+            size_t localVertexIndex(const Model::Vertex* vertex) const;
+            ElementVertexArray* createVertexArray(size_t vertexCapacity, size_t indexCapacity);
+            void writeVertices(ElementVertexArray& vertexArray, const Model::VertexList& vertices, const Color& color);
+            void writeBrushEdges(ElementVertexArray& vertexArray, const Model::Brush& brush, size_t vertexIndex, size_t indexIndex);
+            BrushSlot writeBrush(EdgeBucket& bucket, Model::Brush* brush);
+            void writeFaceEdges(ElementVertexArray& vertexArray, const Model::Face& face);
+            void writeEdgeData(EdgeBucket& bucket, size_t vertexCapacity);
+            void writeEdgeData(const Model::BrushList& brushes, const Model::FaceList& faces);
+            void renderBuckets(FrustumCuller& frustumCuller);
+            
+            // prevent copying
+            EdgeRenderer(const EdgeRenderer& other);
+            void operator= (const EdgeRenderer& other);
         public:
             EdgeRenderer(Vbo& vbo, const Model::BrushList& brushes, const Model::FaceList& faces);
             EdgeRenderer(Vbo& vbo, const Model::BrushList& brushes, const Model::FaceList& faces, const Color& defaultColor);
             ~EdgeRenderer();
 
+            /*
+             The VBO must be mapped when brushes are added or removed.
+             */
+            void addBrushes(const Model::BrushList& brushes);
+            void removeBrushes(const Model::BrushList& brushes);
+            
             void render(RenderContext& context);
             void render(RenderContext& context, const Color& color);
         };
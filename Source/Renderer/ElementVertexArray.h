@@ -0,0 +1,136 @@
+/*
+ Copyright (C) 2010-2012 Kristian Duske
+ 
+ This file is part of TrenchBroom.
+ 
+ TrenchBroom is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+ 
+ TrenchBroom is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ 
+ You should have received a copy of the GNU General Public License
+ along with TrenchBroom.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __TrenchBroom__ElementVertexArray__
+#define __TrenchBroom__ElementVertexArray__
+
+#include "Renderer/AttributeArray.h"
+
+#include <GL/glew.h>
+#include "Renderer/Vbo.h"
+
+#include <cassert>
+#include <vector>
+
+namespace TrenchBroom {
+    namespace Renderer {
+        /*
+         A vertex array whose primitives are assembled from a list of vertex indices. The indices are kept in memory
+         so that they can be changed while the VBO is mapped and are uploaded to an element buffer owned by the array
+         the next time it is rendered.
+         */
+        class ElementVertexArray : public RenderArray {
+        public:
+            typedef std::vector<GLuint> IndexList;
+        private:
+            IndexList m_indices;
+            GLuint m_indexBufferId;
+            size_t m_indexBufferCapacity;
+            bool m_indicesChanged;
+            
+            // prevent copying
+            ElementVertexArray(const ElementVertexArray& other);
+            void operator= (const ElementVertexArray& other);
+            
+            inline void uploadIndices() {
+                if (m_indexBufferId == 0)
+                    glGenBuffers(1, &m_indexBufferId);
+                glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_indexBufferId);
+                
+                const GLsizeiptr size = static_cast<GLsizeiptr>(m_indices.size() * sizeof(GLuint));
+                if (m_indices.size() > m_indexBufferCapacity) {
+                    glBufferData(GL_ELEMENT_ARRAY_BUFFER, size, &m_indices.front(), GL_DYNAMIC_DRAW);
+                    m_indexBufferCapacity = m_indices.size();
+                } else {
+                    glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, 0, size, &m_indices.front());
+                }
+                m_indicesChanged = false;
+            }
+        public:
+            ElementVertexArray(Vbo& vbo, GLenum primType, size_t vertexCapacity, size_t indexCapacity, const Attribute& attribute1, size_t padTo = 16) :
+            RenderArray(vbo, primType, vertexCapacity, attribute1, padTo),
+            m_indexBufferId(0),
+            m_indexBufferCapacity(0),
+            m_indicesChanged(false) {
+                m_indices.reserve(indexCapacity);
+            }
+            
+            ElementVertexArray(Vbo& vbo, GLenum primType, size_t vertexCapacity, size_t indexCapacity, const Attribute& attribute1, const Attribute& attribute2, size_t padTo = 16) :
+            RenderArray(vbo, primType, vertexCapacity, attribute1, attribute2, padTo),
+            m_indexBufferId(0),
+            m_indexBufferCapacity(0),
+            m_indicesChanged(false) {
+                m_indices.reserve(indexCapacity);
+            }
+            
+            ElementVertexArray(Vbo& vbo, GLenum primType, size_t vertexCapacity, size_t indexCapacity, const Attribute& attribute1, const Attribute& attribute2, const Attribute& attribute3, size_t padTo = 16) :
+            RenderArray(vbo, primType, vertexCapacity, attribute1, attribute2, attribute3, padTo),
+            m_indexBufferId(0),
+            m_indexBufferCapacity(0),
+            m_indicesChanged(false) {
+                m_indices.reserve(indexCapacity);
+            }
+            
+            ~ElementVertexArray() {
+                if (m_indexBufferId != 0) {
+                    glDeleteBuffers(1, &m_indexBufferId);
+                    m_indexBufferId = 0;
+                }
+            }
+            
+            inline size_t indexCount() const {
+                return m_indices.size();
+            }
+            
+            inline const IndexList& indices() const {
+                return m_indices;
+            }
+            
+            // the index is relative to the first vertex of this array
+            inline void addIndex(size_t vertexIndex) {
+                assert(vertexIndex < m_vertexCapacity);
+                m_indices.push_back(static_cast<GLuint>(vertexIndex));
+                m_indicesChanged = true;
+            }
+            
+            inline void setIndex(size_t index, size_t vertexIndex) {
+                assert(index < m_indices.size());
+                assert(vertexIndex < m_vertexCapacity);
+                m_indices[index] = static_cast<GLuint>(vertexIndex);
+                m_indicesChanged = true;
+            }
+            
+            inline void render() {
+                if (m_indices.empty())
+                    return;
+                
+                setup();
+                if (m_indicesChanged || m_indexBufferId == 0)
+                    uploadIndices();
+                else
+                    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_indexBufferId);
+                glDrawElements(m_primType, static_cast<GLsizei>(m_indices.size()), GL_UNSIGNED_INT, 0);
+                glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+                cleanup();
+            }
+        };
+    }
+}
+
+#endif /* defined(__TrenchBroom__ElementVertexArray__) */
@@ -22,6 +22,8 @@
 #include "Model/MapDocument.h"
 #include "Renderer/EntityModelRenderer.h"
 #include "Renderer/EntityModelRendererManager.h"
+#include "Renderer/InstancedVertexArray.h"
+#include "Renderer/PointHandleRenderer.h"
 #include "Renderer/SharedResources.h"
 #include "Renderer/Shader/ShaderManager.h"
 #include "Renderer/Shader/ShaderProgram.h"
@@ -29,9 +31,59 @@
 #include "Utility/Preferences.h"
 
 #include <cassert>
+#include <cmath>
 
 namespace TrenchBroom {
     namespace Renderer {
+        // contains the model in any orientation
+        static BBoxf modelBounds(const Model::Entity& entity, const EntityModelRenderer& renderer) {
+            const BBoxf& bounds = renderer.bounds();
+            Vec3f extent;
+            for (size_t i = 0; i < 3; i++)
+                extent[i] = std::max(std::abs(bounds.min[i]), std::abs(bounds.max[i]));
+            return BBoxf(entity.origin(), extent.length());
+        }
+        
+        EntityRenderer::EntityModelInstances::EntityModelInstances(EntityModelRenderer* i_renderer) :
+        renderer(i_renderer),
+        positions(NULL),
+        rotations(NULL) {}
+        
+        EntityRenderer::EntityModelInstances::~EntityModelInstances() {
+            delete positions;
+            positions = NULL;
+            delete rotations;
+            rotations = NULL;
+        }
+        
+        void EntityRenderer::EntityModelInstances::addEntity(Model::Entity& entity) {
+            const BBoxf entityBounds = modelBounds(entity, *renderer);
+            if (entities.empty()) {
+                bounds = entityBounds;
+                origins = BBoxf(entity.origin(), entity.origin());
+            } else {
+                bounds.mergeWith(entityBounds);
+                origins.mergeWith(entity.origin());
+            }
+            entities.push_back(&entity);
+        }
+        
+        void EntityRenderer::EntityModelInstances::createInstanceAttributes() {
+            assert(positions == NULL && rotations == NULL);
+            
+            Vec4f::List positionValues(entities.size());
+            Vec4f::List rotationValues(entities.size());
+            for (unsigned int i = 0; i < entities.size(); i++) {
+                const Model::Entity& entity = *entities[i];
+                const Quatf rotation = entity.rotation();
+                positionValues[i] = Vec4f(entity.origin(), 0.0f);
+                rotationValues[i] = Vec4f(rotation.v, rotation.s);
+            }
+            
+            positions = new InstanceAttributesVec4f("position", positionValues);
+            rotations = new InstanceAttributesVec4f("rotation", rotationValues);
+        }
+        
         EntityRenderer::EntityClassnameAnchor::EntityClassnameAnchor(Model::Entity& entity, Renderer::EntityModelRenderer* renderer) :
         m_entity(&entity),
         m_renderer(renderer) {}
@@ -144,6 +196,33 @@ namespace TrenchBroom {
             }
 
             m_modelRendererCacheValid = true;
+            m_modelInstancesValid = false;
+        }
+
+        void EntityRenderer::clearModelInstances() {
+            EntityModelInstancesMap::iterator it, end;
+            for (it = m_modelInstances.begin(), end = m_modelInstances.end(); it != end; ++it)
+                delete it->second;
+            m_modelInstances.clear();
+        }
+        
+        void EntityRenderer::validateModelInstances(RenderContext& context) {
+            clearModelInstances();
+            
+            EntityModelRenderers::iterator it, end;
+            for (it = m_modelRenderers.begin(), end = m_modelRenderers.end(); it != end; ++it) {
+                Model::Entity* entity = it->first;
+                if (!context.filter().entityVisible(*entity))
+                    continue;
+                
+                EntityModelRenderer* renderer = it->second.renderer;
+                EntityModelInstancesMap::iterator instancesIt = m_modelInstances.lower_bound(renderer);
+                if (instancesIt == m_modelInstances.end() || instancesIt->first != renderer)
+                    instancesIt = m_modelInstances.insert(instancesIt, EntityModelInstancesMap::value_type(renderer, new EntityModelInstances(renderer)));
+                instancesIt->second->addEntity(*entity);
+            }
+            
+            m_modelInstancesValid = true;
         }
 
         void EntityRenderer::renderBounds(RenderContext& context) {
@@ -181,8 +260,8 @@ namespace TrenchBroom {
                 return;
 
             ShaderManager& shaderManager = m_document.sharedResources().shaderManager();
-            ShaderProgram& textProgram = shaderManager.shaderProgram(Shaders::TextShader);
-            ShaderProgram& textBackgroundProgram = shaderManager.shaderProgram(Shaders::TextBackgroundShader);
+            ShaderProgram& textProgram = shaderManager.shaderProgram(Shaders::TextLabelShader);
+            ShaderProgram& textBackgroundProgram = shaderManager.shaderProgram(Shaders::TextLabelBackgroundShader);
 
             EntityClassnameFilter classnameFilter;
             if (m_renderOccludedClassnames) {
@@ -199,15 +278,82 @@ namespace TrenchBroom {
 
         }
 
+        bool EntityRenderer::modelInstancesVisible(RenderContext& context, const EntityModelInstances& instances) const {
+            if (m_modelRenderDistance > 0.0f) {
+                const Vec3f& cameraPosition = context.camera().position();
+                Vec3f closestOrigin;
+                for (size_t i = 0; i < 3; i++)
+                    closestOrigin[i] = std::max(instances.origins.min[i], std::min(instances.origins.max[i], cameraPosition[i]));
+                if ((closestOrigin - cameraPosition).lengthSquared() > m_modelRenderDistance * m_modelRenderDistance)
+                    return false;
+            }
+            return context.frustumCuller().visible(instances.bounds);
+        }
+        
+        void EntityRenderer::renderModelInstances(RenderContext& context, ShaderProgram& program) {
+            program.setUniformVariable("CameraPosition", context.camera().position());
+            program.setUniformVariable("MaximumDistance", m_modelRenderDistance);
+            
+            EntityModelInstancesMap::iterator it, end;
+            for (it = m_modelInstances.begin(), end = m_modelInstances.end(); it != end; ++it) {
+                EntityModelInstances& instances = *it->second;
+                if (!modelInstancesVisible(context, instances))
+                    continue;
+                
+                if (instances.positions == NULL)
+                    instances.createInstanceAttributes();
+                
+                glActiveTexture(GL_TEXTURE1);
+                instances.positions->setup();
+                program.setUniformVariable(instances.positions->name(), 1);
+                program.setUniformVariable(instances.positions->textureSizeName(), instances.positions->textureSize());
+                
+                glActiveTexture(GL_TEXTURE2);
+                instances.rotations->setup();
+                program.setUniformVariable(instances.rotations->name(), 2);
+                program.setUniformVariable(instances.rotations->textureSizeName(), instances.rotations->textureSize());
+                
+                instances.renderer->renderInstances(program, static_cast<unsigned int>(instances.entities.size()));
+                
+                glActiveTexture(GL_TEXTURE2);
+                instances.rotations->cleanup();
+                glActiveTexture(GL_TEXTURE1);
+                instances.positions->cleanup();
+                glActiveTexture(GL_TEXTURE0);
+            }
+        }
+        
+        void EntityRenderer::renderModelsSeparately(RenderContext& context, ShaderProgram& program) {
+            const Vec3f& cameraPosition = context.camera().position();
+            const float maximumDistance2 = m_modelRenderDistance * m_modelRenderDistance;
+            
+            EntityModelInstancesMap::iterator it, end;
+            for (it = m_modelInstances.begin(), end = m_modelInstances.end(); it != end; ++it) {
+                EntityModelInstances& instances = *it->second;
+                if (!modelInstancesVisible(context, instances))
+                    continue;
+                
+                EntityModelRenderer* renderer = instances.renderer;
+                for (unsigned int i = 0; i < instances.entities.size(); i++) {
+                    Model::Entity* entity = instances.entities[i];
+                    if (maximumDistance2 > 0.0f && (entity->origin() - cameraPosition).lengthSquared() > maximumDistance2)
+                        continue;
+                    if (context.frustumCuller().visible(modelBounds(*entity, *renderer)))
+                        renderer->render(program, context.transformation(), *entity);
+                }
+            }
+        }
+        
         void EntityRenderer::renderModels(RenderContext& context) {
-            if (m_modelRenderers.empty())
+            if (m_modelInstances.empty())
                 return;
 
             Preferences::PreferenceManager& prefs = Preferences::PreferenceManager::preferences();
             EntityModelRendererManager& modelRendererManager = m_document.sharedResources().modelRendererManager();
 
+            const bool instancing = PointHandleRenderer::instancingSupported();
             ShaderManager& shaderManager = m_document.sharedResources().shaderManager();
-            ShaderProgram& entityModelProgram = shaderManager.shaderProgram(Shaders::EntityModelShader);
+            ShaderProgram& entityModelProgram = shaderManager.shaderProgram(instancing ? Shaders::InstancedEntityModelShader : Shaders::EntityModelShader);
 
             if (entityModelProgram.activate()) {
                 modelRendererManager.activate();
@@ -216,14 +362,10 @@ namespace TrenchBroom {
                 entityModelProgram.setUniformVariable("TintColor", m_tintColor);
                 entityModelProgram.setUniformVariable("GrayScale", m_grayscale);
 
-                EntityModelRenderers::iterator it, end;
-                for (it = m_modelRenderers.begin(), end = m_modelRenderers.end(); it != end; ++it) {
-                    Model::Entity* entity = it->first;
-                    if (context.filter().entityVisible(*entity)) {
-                        EntityModelRenderer* renderer = it->second.renderer;
-                        renderer->render(entityModelProgram, context.transformation(), *entity);
-                    }
-                }
+                if (instancing)
+                    renderModelInstances(context, entityModelProgram);
+                else
+                    renderModelsSeparately(context, entityModelProgram);
 
                 modelRendererManager.deactivate();
                 entityModelProgram.deactivate();
@@ -236,6 +378,8 @@ namespace TrenchBroom {
         m_boundsVertexArray(NULL),
         m_boundsValid(true),
         m_modelRendererCacheValid(true),
+        m_modelInstancesValid(true),
+        m_modelRenderDistance(0.0f),
         m_classnameRenderer(NULL),
         m_classnameColor(1.0f, 1.0f, 1.0f, 1.0f),
         m_classnameBackgroundColor(0.0f, 0.0f, 0.0f, 0.6f),
@@ -258,6 +402,7 @@ namespace TrenchBroom {
         }
 
         EntityRenderer::~EntityRenderer() {
+            clearModelInstances();
             delete m_boundsVertexArray;
             m_boundsVertexArray = NULL;
             delete m_classnameRenderer;
@@ -288,6 +433,7 @@ namespace TrenchBroom {
 
             m_entities.insert(&entity);
             m_boundsValid = false;
+            m_modelInstancesValid = false;
         }
 
         void EntityRenderer::addEntities(const Model::EntityList& entities) {
@@ -312,14 +458,18 @@ namespace TrenchBroom {
 
             m_entities.insert(entities.begin(), entities.end());
             m_boundsValid = false;
+            m_modelInstancesValid = false;
         }
 
         void EntityRenderer::invalidateBounds() {
             m_boundsValid = false;
+            m_modelInstancesValid = false;
+            m_classnameRenderer->invalidate();
         }
 
         void EntityRenderer::invalidateModels() {
             m_modelRendererCacheValid = false;
+            m_modelInstancesValid = false;
         }
 
         void EntityRenderer::clear() {
@@ -327,6 +477,8 @@ namespace TrenchBroom {
             m_boundsValid = false;
             m_modelRenderers.clear();
             m_modelRendererCacheValid = true;
+            clearModelInstances();
+            m_modelInstancesValid = true;
             m_classnameRenderer->clear();
         }
 
@@ -335,6 +487,7 @@ namespace TrenchBroom {
             m_classnameRenderer->removeString(&entity);
             m_entities.erase(&entity);
             m_boundsValid = false;
+            m_modelInstancesValid = false;
         }
 
         void EntityRenderer::removeEntities(const Model::EntityList& entities) {
@@ -348,6 +501,7 @@ namespace TrenchBroom {
                 m_entities.erase(entity);
             }
             m_boundsValid = false;
+            m_modelInstancesValid = false;
         }
 
         void EntityRenderer::render(RenderContext& context) {
@@ -355,6 +509,8 @@ namespace TrenchBroom {
                 validateBounds(context);
             if (!m_modelRendererCacheValid)
                 validateModels(context);
+            if (!m_modelInstancesValid)
+                validateModelInstances(context);
 
             if (context.viewOptions().showEntityModels())
                 renderModels(context);
@@ -39,6 +39,8 @@ namespace TrenchBroom {
     
     namespace Renderer {
         class EntityModelRenderer;
+        class InstanceAttributes;
+        class ShaderProgram;
         class Vbo;
         class VertexArray;
         
@@ -56,6 +58,26 @@ namespace TrenchBroom {
                 classname(i_classname) {}
             };
             
+            class EntityModelInstances {
+            public:
+                EntityModelRenderer* renderer;
+                Model::EntityList entities;
+                BBoxf bounds;
+                BBoxf origins;
+                InstanceAttributes* positions;
+                InstanceAttributes* rotations;
+                
+                EntityModelInstances(EntityModelRenderer* i_renderer);
+                ~EntityModelInstances();
+                
+                void addEntity(Model::Entity& entity);
+                void createInstanceAttributes();
+            private:
+                // prevent copying
+                EntityModelInstances(const EntityModelInstances& other);
+                void operator= (const EntityModelInstances& other);
+            };
+            
             class EntityClassnameAnchor : public Text::TextAnchor {
             private:
                 Model::Entity* m_entity;
@@ -69,6 +91,7 @@ namespace TrenchBroom {
             
             typedef Model::Entity* EntityKey;
             typedef std::map<EntityKey, CachedEntityModelRenderer> EntityModelRenderers;
+            typedef std::map<EntityModelRenderer*, EntityModelInstances*> EntityModelInstancesMap;
             typedef Text::TextRenderer<EntityKey> EntityClassnameRenderer;
             
             class EntityClassnameFilter : public EntityClassnameRenderer::TextRendererFilter {
@@ -84,6 +107,9 @@ namespace TrenchBroom {
             bool m_boundsValid;
             EntityModelRenderers m_modelRenderers;
             bool m_modelRendererCacheValid;
+            EntityModelInstancesMap m_modelInstances;
+            bool m_modelInstancesValid;
+            float m_modelRenderDistance;
             EntityClassnameRenderer* m_classnameRenderer;
             
             Color m_classnameColor;
@@ -103,9 +129,14 @@ namespace TrenchBroom {
             void writeBounds(RenderContext& context, const Model::EntityList& entities);
             void validateBounds(RenderContext& context);
             void validateModels(RenderContext& context);
+            void clearModelInstances();
+            void validateModelInstances(RenderContext& context);
             
             void renderBounds(RenderContext& context);
             void renderClassnames(RenderContext& context);
+            bool modelInstancesVisible(RenderContext& context, const EntityModelInstances& instances) const;
+            void renderModelInstances(RenderContext& context, ShaderProgram& program);
+            void renderModelsSeparately(RenderContext& context, ShaderProgram& program);
             void renderModels(RenderContext& context);
             void renderFigures(RenderContext& context);
 
@@ -118,6 +149,11 @@ namespace TrenchBroom {
             
             void setClassnameFadeDistance(float classnameFadeDistance);
             
+            // models farther away from the camera than this are not rendered, 0 disables the culling
+            inline void setModelRenderDistance(float modelRenderDistance) {
+                m_modelRenderDistance = modelRenderDistance;
+            }
+            
             inline void setClassnameColor(const Color& classnameColor, const Color& classnameBackgroundColor) {
                 m_classnameColor = classnameColor;
                 m_classnameBackgroundColor = classnameBackgroundColor;
@@ -19,13 +19,14 @@
 
 #include "FaceRenderer.h"
 
+#include "Model/Brush.h"
 #include "Model/Face.h"
+#include "Renderer/ElementVertexArray.h"
 #include "Renderer/RenderContext.h"
 #include "Renderer/Shader/ShaderManager.h"
 #include "Renderer/Shader/ShaderProgram.h"
 #include "Renderer/TextureRenderer.h"
 #include "Renderer/TextureRendererManager.h"
-#include "Renderer/VertexArray.h"
 #include "Utility/Grid.h"
 #include "Utility/Preferences.h"
 #include "Utility/VecMath.h"
@@ -36,38 +37,145 @@ namespace TrenchBroom {
     namespace Renderer {
         String FaceRenderer::AlphaBlendedTextures[] = {"clip", "hint", /*"skip",*/ "hintskip", "trigger"};
 
-        void FaceRenderer::writeFaceData(Vbo& vbo, TextureRendererManager& textureRendererManager, const Sorter& faceSorter) {
+        static inline size_t fanIndexCount(size_t vertexCount) {
+            return 3 * (vertexCount - 2);
+        }
+        
+        static inline ElementVertexArray* createVertexArray(Vbo& vbo, size_t vertexCapacity, size_t indexCapacity) {
+            return new ElementVertexArray(vbo, GL_TRIANGLES, vertexCapacity, indexCapacity,
+                                          Attribute::position3f(),
+                                          Attribute::normal3f(),
+                                          Attribute::texCoord02f(),
+                                          0);
+        }
+
+        FaceRenderer::FaceSlot FaceRenderer::writeFace(TextureFaces& textureFaces, Model::Face* face) {
+            const FaceVertex::List& vertices = face->cachedVertices();
+            ElementVertexArray& vertexArray = *textureFaces.vertexArray;
+            
+            FreeSlotMap::iterator freeIt = textureFaces.freeSlots.find(vertices.size());
+            if (freeIt != textureFaces.freeSlots.end()) {
+                const FreeSlot freeSlot = freeIt->second;
+                textureFaces.freeSlots.erase(freeIt);
+                textureFaces.freeVertexCount -= vertices.size();
+                
+                const size_t vertexCount = vertexArray.vertexCount();
+                vertexArray.seek(freeSlot.vertexIndex);
+                vertexArray.addAttributes(vertices);
+                vertexArray.seek(vertexCount);
+                
+                textureFaces.faces[freeSlot.faceIndex] = face;
+                return FaceSlot(&textureFaces, freeSlot.faceIndex, freeSlot.vertexIndex, vertices.size());
+            }
+            
+            if (vertexArray.vertexCount() + vertices.size() > vertexArray.vertexCapacity()) {
+                rewriteFaces(textureFaces, 2 * (vertexArray.vertexCount() - textureFaces.freeVertexCount + vertices.size()));
+                return writeFace(textureFaces, face);
+            }
+            
+            const size_t vertexIndex = vertexArray.vertexCount();
+            const FaceSlot slot(&textureFaces, textureFaces.faces.size(), vertexIndex, vertices.size());
+            textureFaces.faces.push_back(face);
+            vertexArray.addAttributes(vertices);
+            for (size_t i = 1; i < vertices.size() - 1; i++) {
+                vertexArray.addIndex(vertexIndex);
+                vertexArray.addIndex(vertexIndex + i);
+                vertexArray.addIndex(vertexIndex + i + 1);
+            }
+            return slot;
+        }
+        
+        void FaceRenderer::rewriteFaces(TextureFaces& textureFaces, size_t vertexCapacity) {
+            Model::FaceList faces;
+            faces.reserve(textureFaces.faces.size());
+            size_t indexCount = 0;
+            for (size_t i = 0; i < textureFaces.faces.size(); i++) {
+                if (textureFaces.faces[i] != NULL) {
+                    faces.push_back(textureFaces.faces[i]);
+                    indexCount += fanIndexCount(textureFaces.faces[i]->vertices().size());
+                }
+            }
+            
+            // the vertices are written again from the faces' caches, so the old block can be released first
+            delete textureFaces.vertexArray;
+            textureFaces.vertexArray = createVertexArray(m_vbo, vertexCapacity, indexCount);
+            textureFaces.faces.clear();
+            textureFaces.faces.reserve(faces.size());
+            textureFaces.freeSlots.clear();
+            textureFaces.freeVertexCount = 0;
+            
+            for (size_t i = 0; i < faces.size(); i++) {
+                const FaceSlot slot = writeFace(textureFaces, faces[i]);
+                *m_faceSlots.find(faces[i]) = slot;
+            }
+        }
+        
+        void FaceRenderer::writeFaceData(const Sorter& faceSorter) {
             const FaceCollectionMap& faceCollectionMap = faceSorter.collections();
             if (faceCollectionMap.empty())
                 return;
             
+            // the vertex and index counts of newly created texture faces
+            typedef std::map<TextureFaces*, std::pair<size_t, size_t> > VertexCountMap;
+            std::vector<TextureFaces*> faceGroups;
+            
             FaceCollectionMap::const_iterator it, end;
             for (it = faceCollectionMap.begin(), end = faceCollectionMap.end(); it != end; ++it) {
                 Model::Texture* texture = it->first;
-                TextureRenderer* textureRenderer = texture != NULL ? &textureRendererManager.renderer(texture) : NULL;
                 const FaceCollection& faceCollection = it->second;
                 const Model::FaceList& faces = faceCollection.polygons();
-                const size_t vertexCount = 3 * faceCollection.vertexCount() - 6 * faces.size();
-                VertexArray* vertexArray = new VertexArray(vbo, GL_TRIANGLES, vertexCount,
-                                                           Attribute::position3f(),
-                                                           Attribute::normal3f(),
-                                                           Attribute::texCoord02f(),
-                                                           0);
                 
+                // find the texture faces for every face first so that new ones can be created with the exact capacity
+                VertexCountMap newVertexCounts;
+                faceGroups.clear();
+                faceGroups.reserve(faces.size());
+                
+                const Model::Brush* brush = NULL;
+                TextureFaces* textureFaces = NULL;
+                std::pair<size_t, size_t>* newVertexCount = NULL;
                 for (size_t i = 0; i < faces.size(); i++) {
                     Model::Face* face = faces[i];
-                    vertexArray->addAttributes(face->cachedVertices());
+                    if (face->brush() != brush) {
+                        brush = face->brush();
+                        const BBoxf& bounds = brush->bounds();
+                        const CullingBucket bucket(bounds);
+                        
+                        if (textureFaces == NULL || !(textureFaces->bucket == bucket)) {
+                            const TextureFacesKey key(texture, bucket);
+                            TextureFacesMap::iterator textureIt = m_textureFaces.find(key);
+                            if (textureIt == m_textureFaces.end()) {
+                                TextureRenderer* textureRenderer = texture != NULL ? &m_textureRendererManager.renderer(texture) : NULL;
+                                const bool transparent = texture != NULL && alphaBlend(texture->name());
+                                textureFaces = new TextureFaces(texture, bucket, bounds, textureRenderer, transparent);
+                                m_textureFaces.insert(TextureFacesMap::value_type(key, textureFaces));
+                            } else {
+                                textureFaces = textureIt->second;
+                            }
+                            newVertexCount = textureFaces->vertexArray == NULL ? &newVertexCounts[textureFaces] : NULL;
+                        }
+                        textureFaces->bounds.mergeWith(bounds);
+                    }
+                    
+                    if (newVertexCount != NULL) {
+                        newVertexCount->first += face->vertices().size();
+                        newVertexCount->second += fanIndexCount(face->vertices().size());
+                    }
+                    faceGroups.push_back(textureFaces);
                 }
                 
-                if (texture != NULL && alphaBlend(texture->name()))
-                    m_transparentVertexArrays.push_back(TextureVertexArray(textureRenderer, vertexArray));
-                else
-                    m_vertexArrays.push_back(TextureVertexArray(textureRenderer, vertexArray));
+                VertexCountMap::const_iterator countIt, countEnd;
+                for (countIt = newVertexCounts.begin(), countEnd = newVertexCounts.end(); countIt != countEnd; ++countIt)
+                    countIt->first->vertexArray = createVertexArray(m_vbo, countIt->second.first, countIt->second.second);
+                
+                for (size_t i = 0; i < faces.size(); i++) {
+                    Model::Face* face = faces[i];
+                    m_faceSlots.insert(face, writeFace(*faceGroups[i], face));
+                }
             }
         }
 
         void FaceRenderer::render(RenderContext& context, bool grayScale, const Color* tintColor) {
-            if (m_vertexArrays.empty() && m_transparentVertexArrays.empty())
+            if (m_textureFaces.empty())
                 return;
             
             Preferences::PreferenceManager& prefs = Preferences::PreferenceManager::preferences();
@@ -95,47 +203,94 @@ namespace TrenchBroom {
                 faceProgram.setUniformVariable("ShadeFaces", context.viewOptions().shadeFaces() );
                 faceProgram.setUniformVariable("UseFog", context.viewOptions().useFog() );
                 
-                renderOpaqueFaces(faceProgram, applyTexture);
+                renderFaces(false, faceProgram, applyTexture, context.frustumCuller());
                 glDepthMask(GL_FALSE);
                 faceProgram.setUniformVariable("Alpha", prefs.getFloat(Preferences::TransparentFaceAlpha));
-                renderTransparentFaces(faceProgram, applyTexture);
+                renderFaces(true, faceProgram, applyTexture, context.frustumCuller());
                 glDepthMask(GL_TRUE);
 
                 faceProgram.deactivate();
             }
         }
 
-        void FaceRenderer::renderOpaqueFaces(ShaderProgram& shader, const bool applyTexture) {
-            renderFaces(m_vertexArrays, shader, applyTexture);
-        }
-        
-        void FaceRenderer::renderTransparentFaces(ShaderProgram& shader, const bool applyTexture) {
-            renderFaces(m_transparentVertexArrays, shader, applyTexture);
-        }
-
-        void FaceRenderer::renderFaces(const TextureVertexArrayList& vertexArrays, ShaderProgram& shader, const bool applyTexture) {
-            for (size_t i = 0; i < vertexArrays.size(); i++) {
-                const TextureVertexArray& textureVertexArray = vertexArrays[i];
-                if (textureVertexArray.texture != NULL) {
-                    textureVertexArray.texture->activate();
-                    shader.setUniformVariable("ApplyTexture", applyTexture);
-                    shader.setUniformVariable("FaceTexture", 0);
-                    shader.setUniformVariable("Color", textureVertexArray.texture->averageColor());
-                } else {
-                    shader.setUniformVariable("ApplyTexture", false);
-                    shader.setUniformVariable("Color", m_faceColor);
-                }
+        void FaceRenderer::renderFaces(bool transparent, ShaderProgram& shader, const bool applyTexture, FrustumCuller& frustumCuller) {
+            const TextureFaces* previous = NULL;
+            
+            TextureFacesMap::const_iterator it, end;
+            for (it = m_textureFaces.begin(), end = m_textureFaces.end(); it != end; ++it) {
+                const TextureFaces& textureFaces = *it->second;
+                if (textureFaces.transparent != transparent || !frustumCuller.visible(textureFaces.bounds))
+                    continue;
                 
-                textureVertexArray.vertexArray->render();
+                if (previous == NULL || previous->texture != textureFaces.texture) {
+                    if (previous != NULL && previous->textureRenderer != NULL)
+                        previous->textureRenderer->deactivate();
+                    
+                    if (textureFaces.textureRenderer != NULL) {
+                        textureFaces.textureRenderer->activate();
+                        shader.setUniformVariable("ApplyTexture", applyTexture);
+                        shader.setUniformVariable("FaceTexture", 0);
+                        shader.setUniformVariable("Color", textureFaces.textureRenderer->averageColor());
+                    } else {
+                        shader.setUniformVariable("ApplyTexture", false);
+                        shader.setUniformVariable("Color", m_faceColor);
+                    }
+                }
                 
-                if (textureVertexArray.texture != NULL)
-                    textureVertexArray.texture->deactivate();
+                textureFaces.vertexArray->render();
+                previous = &textureFaces;
             }
+            
+            if (previous != NULL && previous->textureRenderer != NULL)
+                previous->textureRenderer->deactivate();
         }
 
         FaceRenderer::FaceRenderer(Vbo& vbo, TextureRendererManager& textureRendererManager, const Sorter& faceSorter, const Color& faceColor) :
+        m_vbo(vbo),
+        m_textureRendererManager(textureRendererManager),
         m_faceColor(faceColor) {
-            writeFaceData(vbo, textureRendererManager, faceSorter);
+            writeFaceData(faceSorter);
+        }
+        
+        FaceRenderer::~FaceRenderer() {
+            TextureFacesMap::iterator it, end;
+            for (it = m_textureFaces.begin(), end = m_textureFaces.end(); it != end; ++it) {
+                TextureFaces* textureFaces = it->second;
+                delete textureFaces->vertexArray;
+                delete textureFaces;
+            }
+            m_textureFaces.clear();
+            m_faceSlots.clear();
+        }
+        
+        void FaceRenderer::addFaces(const Sorter& faceSorter) {
+            writeFaceData(faceSorter);
+        }
+        
+        void FaceRenderer::removeFaces(const Model::FaceList& faces) {
+            for (size_t i = 0; i < faces.size(); i++) {
+                FaceSlot* faceSlot = m_faceSlots.find(faces[i]);
+                if (faceSlot == NULL)
+                    continue;
+                
+                const FaceSlot slot = *faceSlot;
+                m_faceSlots.erase(faces[i]);
+                
+                TextureFaces& textureFaces = *slot.textureFaces;
+                textureFaces.vertexArray->clearVertices(slot.vertexIndex, slot.vertexCount);
+                textureFaces.faces[slot.faceIndex] = NULL;
+                textureFaces.freeSlots.insert(FreeSlotMap::value_type(slot.vertexCount, FreeSlot(slot.faceIndex, slot.vertexIndex)));
+                textureFaces.freeVertexCount += slot.vertexCount;
+                
+                const size_t vertexCount = textureFaces.vertexArray->vertexCount();
+                if (textureFaces.freeSlots.size() == textureFaces.faces.size()) {
+                    m_textureFaces.erase(TextureFacesKey(textureFaces.texture, textureFaces.bucket));
+                    delete textureFaces.vertexArray;
+                    delete &textureFaces;
+                } else if (2 * textureFaces.freeVertexCount > vertexCount) {
+                    rewriteFaces(textureFaces, vertexCount - textureFaces.freeVertexCount);
+                }
+            }
         }
         
         void FaceRenderer::render(RenderContext& context, bool grayScale) {
@@ -20,9 +20,14 @@
 #ifndef __TrenchBroom__FaceRenderer__
 #define __TrenchBroom__FaceRenderer__
 
+#include "Model/FaceTypes.h"
+#include "Renderer/FrustumCuller.h"
 #include "Renderer/TexturedPolygonSorter.h"
-#include "Renderer/TextureVertexArray.h"
 #include "Utility/Color.h"
+#include "Utility/LazySortedMap.h"
+#include "Utility/String.h"
+
+#include <map>
 
 namespace TrenchBroom {
     namespace Model {
@@ -32,7 +37,10 @@ namespace TrenchBroom {
     
     namespace Renderer {
         class RenderContext;
+        class ShaderProgram;
+        class TextureRenderer;
         class TextureRendererManager;
+        class ElementVertexArray;
         class Vbo;
         
         class FaceRenderer {
@@ -42,9 +50,73 @@ namespace TrenchBroom {
             typedef Sorter::PolygonCollection FaceCollection;
             typedef Sorter::PolygonCollectionMap FaceCollectionMap;
 
+            class FreeSlot {
+            public:
+                size_t faceIndex;
+                size_t vertexIndex;
+                
+                FreeSlot(size_t i_faceIndex, size_t i_vertexIndex) :
+                faceIndex(i_faceIndex),
+                vertexIndex(i_vertexIndex) {}
+            };
+            
+            // free slots by their vertex count
+            typedef std::multimap<size_t, FreeSlot> FreeSlotMap;
+            
+            /*
+             Each texture owns a vertex array per culling bucket in which the polygons of its faces are stored back
+             to back and triangulated by index fans. Removed faces leave a slot of degenerate triangles behind which is
+             reused by the next face with the same number of vertices, whose fan indices are the same. The array is
+             rewritten when it must grow or when more than half of it is unused. The bounds only ever grow until the
+             texture faces are deleted.
+             */
+            class TextureFaces {
+            public:
+                Model::Texture* texture;
+                CullingBucket bucket;
+                BBoxf bounds;
+                TextureRenderer* textureRenderer;
+                ElementVertexArray* vertexArray;
+                Model::FaceList faces;
+                FreeSlotMap freeSlots;
+                size_t freeVertexCount;
+                bool transparent;
+                
+                TextureFaces(Model::Texture* i_texture, const CullingBucket& i_bucket, const BBoxf& i_bounds,
+                             TextureRenderer* i_textureRenderer, bool i_transparent) :
+                texture(i_texture),
+                bucket(i_bucket),
+                bounds(i_bounds),
+                textureRenderer(i_textureRenderer),
+                vertexArray(NULL),
+                freeVertexCount(0),
+                transparent(i_transparent) {}
+            };
+            
+            class FaceSlot {
+            public:
+                TextureFaces* textureFaces;
+                size_t faceIndex;
+                size_t vertexIndex;
+                size_t vertexCount;
+                
+                FaceSlot(TextureFaces* i_textureFaces, size_t i_faceIndex, size_t i_vertexIndex, size_t i_vertexCount) :
+                textureFaces(i_textureFaces),
+                faceIndex(i_faceIndex),
+                vertexIndex(i_vertexIndex),
+                vertexCount(i_vertexCount) {}
+            };
+            
+            // ordered by texture first so that the buckets of a texture are rendered without switching textures
+            typedef std::pair<Model::Texture*, CullingBucket> TextureFacesKey;
+            typedef std::map<TextureFacesKey, TextureFaces*> TextureFacesMap;
+            typedef Utility::LazySortedMap<Model::Face*, FaceSlot> FaceSlotMap;
+            
+            Vbo& m_vbo;
+            TextureRendererManager& m_textureRendererManager;
             Color m_faceColor;
-            TextureVertexArrayList m_vertexArrays;
-            TextureVertexArrayList m_transparentVertexArrays;
+            TextureFacesMap m_textureFaces;
+            FaceSlotMap m_faceSlots;
             
             static String AlphaBlendedTextures[];
             
@@ -59,13 +131,24 @@ namespace TrenchBroom {
                 return false;
             }
             
-            void writeFaceData(Vbo& vbo, TextureRendererManager& textureRendererManager, const Sorter& faceSorter);
+            FaceSlot writeFace(TextureFaces& textureFaces, Model::Face* face);
+            void rewriteFaces(TextureFaces& textureFaces, size_t vertexCapacity);
+            void writeFaceData(const Sorter& faceSorter);
             void render(RenderContext& context, bool grayScale, const Color* tintColor);
-            void renderOpaqueFaces(ShaderProgram& shader, const bool applyTexture);
-            void renderTransparentFaces(ShaderProgram& shader, const bool applyTexture);
-            void renderFaces(const TextureVertexArrayList& vertexArrays, ShaderProgram& shader, const bool applyTexture);
+            void renderFaces(bool transparent, ShaderProgram& shader, const bool applyTexture, FrustumCuller& frustumCuller);
+            
+            // prevent copying
+            FaceRenderer(const FaceRenderer& other);
+            void operator= (const FaceRenderer& other);
         public:
             FaceRenderer(Vbo& vbo, TextureRendererManager& textureRendererManager, const Sorter& faceSorter, const Color& faceColor);
+            ~FaceRenderer();
+            
+            /*
+             The VBO must be mapped when faces are added or removed.
+             */
+            void addFaces(const Sorter& faceSorter);
+            void removeFaces(const Model::FaceList& faces);
             
             void render(RenderContext& context, bool grayScale);
             void render(RenderContext& context, bool grayScale, const Color& tintColor);
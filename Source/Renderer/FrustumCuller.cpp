@@ -0,0 +1,32 @@
+/*
+ Copyright (C) 2010-2012 Kristian Duske
+ 
+ This file is part of TrenchBroom.
+ 
+ TrenchBroom is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+ 
+ TrenchBroom is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ 
+ You should have received a copy of the GNU General Public License
+ along with TrenchBroom.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "FrustumCuller.h"
+
+#include "Renderer/Camera.h"
+
+namespace TrenchBroom {
+    namespace Renderer {
+        FrustumCuller::FrustumCuller(const Camera& camera) :
+        m_drawnCount(0),
+        m_culledCount(0) {
+            camera.frustumPlanes(m_planes[0], m_planes[1], m_planes[2], m_planes[3]);
+        }
+    }
+}
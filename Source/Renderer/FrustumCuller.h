@@ -0,0 +1,122 @@
+/*
+ Copyright (C) 2010-2012 Kristian Duske
+ 
+ This file is part of TrenchBroom.
+ 
+ TrenchBroom is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+ 
+ TrenchBroom is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ 
+ You should have received a copy of the GNU General Public License
+ along with TrenchBroom.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __TrenchBroom__FrustumCuller__
+#define __TrenchBroom__FrustumCuller__
+
+#include "Utility/VecMath.h"
+
+#include <cmath>
+
+using namespace TrenchBroom::VecMath;
+
+namespace TrenchBroom {
+    namespace Renderer {
+        class Camera;
+        
+        /*
+         Render data is grouped into buckets which are culled as a whole. An object belongs to the bucket of the grid
+         cell containing the center of its bounds. The cells are as large as the octree nodes which are 2048 units
+         wide. A bucket's bounds are the union of its objects' bounds, so objects which cross a cell border are not
+         culled too early.
+         */
+        class CullingBucket {
+        public:
+            static const int CellSize = 2048;
+            
+            int x;
+            int y;
+            int z;
+            
+            CullingBucket(const BBoxf& bounds) {
+                const Vec3f center = bounds.center();
+                x = static_cast<int>(std::floor(center.x() / CellSize));
+                y = static_cast<int>(std::floor(center.y() / CellSize));
+                z = static_cast<int>(std::floor(center.z() / CellSize));
+            }
+            
+            inline bool operator== (const CullingBucket& other) const {
+                return x == other.x && y == other.y && z == other.z;
+            }
+            
+            inline bool operator< (const CullingBucket& other) const {
+                if (x != other.x)
+                    return x < other.x;
+                if (y != other.y)
+                    return y < other.y;
+                return z < other.z;
+            }
+        };
+        
+        /*
+         Tests bounds against the side planes of the view frustum and counts how many were drawn and culled. The
+         normals of the planes point out of the frustum.
+         */
+        class FrustumCuller {
+        private:
+            Planef m_planes[4];
+            size_t m_drawnCount;
+            size_t m_culledCount;
+        public:
+            FrustumCuller(const Camera& camera);
+            
+            FrustumCuller(const Planef& top, const Planef& right, const Planef& bottom, const Planef& left) :
+            m_drawnCount(0),
+            m_culledCount(0) {
+                m_planes[0] = top;
+                m_planes[1] = right;
+                m_planes[2] = bottom;
+                m_planes[3] = left;
+            }
+            
+            inline bool intersects(const BBoxf& bounds) const {
+                for (size_t i = 0; i < 4; i++) {
+                    const Planef& plane = m_planes[i];
+                    
+                    // the corner of the bounds which lies furthest inside the plane
+                    const Vec3f corner(plane.normal.x() >= 0.0f ? bounds.min.x() : bounds.max.x(),
+                                       plane.normal.y() >= 0.0f ? bounds.min.y() : bounds.max.y(),
+                                       plane.normal.z() >= 0.0f ? bounds.min.z() : bounds.max.z());
+                    if (plane.pointDistance(corner) > 0.0f)
+                        return false;
+                }
+                return true;
+            }
+            
+            inline bool visible(const BBoxf& bounds) {
+                if (intersects(bounds)) {
+                    m_drawnCount++;
+                    return true;
+                }
+                m_culledCount++;
+                return false;
+            }
+            
+            inline size_t drawnCount() const {
+                return m_drawnCount;
+            }
+            
+            inline size_t culledCount() const {
+                return m_culledCount;
+            }
+        };
+    }
+}
+
+#endif /* defined(__TrenchBroom__FrustumCuller__) */
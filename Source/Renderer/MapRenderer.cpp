@@ -66,12 +66,86 @@ namespace TrenchBroom {
         static const int EdgeVertexSize = VertexSize;
         static const int EntityBoundsVertexSize = ColorSize + VertexSize;
 
+        static void collectBrushes(const Model::EntityList& entities, Model::BrushSet& result) {
+            for (size_t i = 0; i < entities.size(); i++) {
+                const Model::BrushList& brushes = entities[i]->brushes();
+                result.insert(brushes.begin(), brushes.end());
+            }
+        }
+        
+        bool MapRenderer::unselectedBrush(RenderContext& context, const Model::Brush& brush) const {
+            const Model::Entity& entity = *brush.entity();
+            return (context.filter().brushVisible(brush) &&
+                    !entity.selected() && !brush.selected() &&
+                    !entity.locked() && !brush.locked());
+        }
+        
+        void MapRenderer::updateGeometryData(RenderContext& context) {
+            assert(m_geometryDataValid);
+            
+            Model::BrushList removedBrushes;
+            Model::BrushList addedBrushes;
+            Model::FaceList removedFaces;
+            FaceSorter addedFaceSorter;
+            
+            Model::BrushSet::const_iterator brushIt, brushEnd;
+            for (brushIt = m_invalidBrushes.begin(), brushEnd = m_invalidBrushes.end(); brushIt != brushEnd; ++brushIt) {
+                Model::Brush* brush = *brushIt;
+                const bool unselected = unselectedBrush(context, *brush);
+                
+                removedBrushes.push_back(brush);
+                if (unselected)
+                    addedBrushes.push_back(brush);
+                
+                const Model::FaceList& faces = brush->faces();
+                for (size_t i = 0; i < faces.size(); i++) {
+                    Model::Face* face = faces[i];
+                    removedFaces.push_back(face);
+                    if (unselected && !face->selected())
+                        addedFaceSorter.addPolygon(face->texture(), face, face->vertices().size());
+                }
+            }
+            
+            Model::FaceSet::const_iterator faceIt, faceEnd;
+            for (faceIt = m_invalidFaces.begin(), faceEnd = m_invalidFaces.end(); faceIt != faceEnd; ++faceIt) {
+                Model::Face* face = *faceIt;
+                Model::Brush* brush = face->brush();
+                if (m_invalidBrushes.count(brush) > 0)
+                    continue;
+                
+                removedFaces.push_back(face);
+                if (!face->selected() && unselectedBrush(context, *brush))
+                    addedFaceSorter.addPolygon(face->texture(), face, face->vertices().size());
+            }
+            
+            m_invalidBrushes.clear();
+            m_invalidFaces.clear();
+            
+            m_faceVbo->activate();
+            m_faceVbo->map();
+            m_faceRenderer->removeFaces(removedFaces);
+            m_faceRenderer->addFaces(addedFaceSorter);
+            m_faceVbo->unmap();
+            m_faceVbo->deactivate();
+            
+            if (!removedBrushes.empty()) {
+                m_edgeVbo->activate();
+                m_edgeVbo->map();
+                m_edgeRenderer->removeBrushes(removedBrushes);
+                m_edgeRenderer->addBrushes(addedBrushes);
+                m_edgeVbo->unmap();
+                m_edgeVbo->deactivate();
+            }
+        }
+        
         void MapRenderer::rebuildGeometryData(RenderContext& context) {
             if (!m_geometryDataValid) {
                 delete m_faceRenderer;
                 m_faceRenderer = NULL;
                 delete m_edgeRenderer;
                 m_edgeRenderer = NULL;
+                m_invalidBrushes.clear();
+                m_invalidFaces.clear();
             }
             if (!m_selectedGeometryDataValid) {
                 delete m_selectedFaceRenderer;
@@ -86,6 +160,34 @@ namespace TrenchBroom {
                 m_lockedEdgeRenderer = NULL;
             }
             
+            // unless the unselected geometry must be rebuilt, only the selected and locked objects are visited
+            Model::BrushList brushes;
+            if (!m_geometryDataValid) {
+                const Model::EntityList& entities = m_document.map().entities();
+                for (size_t i = 0; i < entities.size(); i++) {
+                    const Model::BrushList& entityBrushes = entities[i]->brushes();
+                    brushes.insert(brushes.end(), entityBrushes.begin(), entityBrushes.end());
+                }
+                m_geometryBrushCount = brushes.size();
+            } else {
+                const Model::EditStateManager& editStateManager = m_document.editStateManager();
+                Model::BrushSet brushSet;
+                if (!m_selectedGeometryDataValid) {
+                    collectBrushes(editStateManager.selectedEntities(), brushSet);
+                    const Model::BrushList& selectedBrushes = editStateManager.selectedBrushes();
+                    brushSet.insert(selectedBrushes.begin(), selectedBrushes.end());
+                    const Model::FaceList& selectedFaces = editStateManager.selectedFaces();
+                    for (size_t i = 0; i < selectedFaces.size(); i++)
+                        brushSet.insert(selectedFaces[i]->brush());
+                }
+                if (!m_lockedGeometryDataValid) {
+                    collectBrushes(editStateManager.lockedEntities(), brushSet);
+                    const Model::BrushList& lockedBrushes = editStateManager.lockedBrushes();
+                    brushSet.insert(lockedBrushes.begin(), lockedBrushes.end());
+                }
+                brushes.insert(brushes.end(), brushSet.begin(), brushSet.end());
+            }
+            
             FaceSorter unselectedFaceSorter;
             FaceSorter selectedFaceSorter;
             FaceSorter lockedFaceSorter;
@@ -97,44 +199,40 @@ namespace TrenchBroom {
             Model::FaceList partiallySelectedBrushFaces;
             
             // collect all visible faces and brushes
-            const Model::EntityList& entities = m_document.map().entities();
-            for (size_t i = 0; i < entities.size(); i++) {
-                Model::Entity* entity = entities[i];
-                const Model::BrushList& brushes = entity->brushes();
-                for (size_t j = 0; j < brushes.size(); j++) {
-                    Model::Brush* brush = brushes[j];
-                    if (context.filter().brushVisible(*brush)) {
-                        if (entity->selected() || brush->selected()) {
-                            selectedBrushes.push_back(brush);
-                        } else if (entity->locked() || brush->locked()) {
-                            lockedBrushes.push_back(brush);
-                        } else {
-                            if (entity->worldspawn())
-                                unselectedWorldBrushes.push_back(brush);
-                            else
-                                unselectedEntityBrushes.push_back(brush);
-                            if (brush->partiallySelected()) {
-                                const Model::FaceList& faces = brush->faces();
-                                for (size_t k = 0; k < faces.size(); k++) {
-                                    Model::Face* face = faces[k];
-                                    if (face->selected()) {
-                                        partiallySelectedBrushFaces.push_back(face);
-                                    }
+            for (size_t i = 0; i < brushes.size(); i++) {
+                Model::Brush* brush = brushes[i];
+                Model::Entity* entity = brush->entity();
+                if (context.filter().brushVisible(*brush)) {
+                    if (entity->selected() || brush->selected()) {
+                        selectedBrushes.push_back(brush);
+                    } else if (entity->locked() || brush->locked()) {
+                        lockedBrushes.push_back(brush);
+                    } else {
+                        if (entity->worldspawn())
+                            unselectedWorldBrushes.push_back(brush);
+                        else
+                            unselectedEntityBrushes.push_back(brush);
+                        if (brush->partiallySelected()) {
+                            const Model::FaceList& faces = brush->faces();
+                            for (size_t k = 0; k < faces.size(); k++) {
+                                Model::Face* face = faces[k];
+                                if (face->selected()) {
+                                    partiallySelectedBrushFaces.push_back(face);
                                 }
                             }
                         }
-                        
-                        const Model::FaceList& faces = brush->faces();
-                        for (size_t k = 0; k < faces.size(); k++) {
-                            Model::Face* face = faces[k];
-                            Model::Texture* texture = face->texture();
-                            if (entity->selected() || brush->selected() || face->selected())
-                                selectedFaceSorter.addPolygon(texture, face, face->vertices().size());
-                            else if (entity->locked() || brush->locked())
-                                lockedFaceSorter.addPolygon(texture, face, face->vertices().size());
-                            else
-                                unselectedFaceSorter.addPolygon(texture, face, face->vertices().size());
-                        }
+                    }
+                    
+                    const Model::FaceList& faces = brush->faces();
+                    for (size_t k = 0; k < faces.size(); k++) {
+                        Model::Face* face = faces[k];
+                        Model::Texture* texture = face->texture();
+                        if (entity->selected() || brush->selected() || face->selected())
+                            selectedFaceSorter.addPolygon(texture, face, face->vertices().size());
+                        else if (entity->locked() || brush->locked())
+                            lockedFaceSorter.addPolygon(texture, face, face->vertices().size());
+                        else if (!m_geometryDataValid)
+                            unselectedFaceSorter.addPolygon(texture, face, face->vertices().size());
                     }
                 }
             }
@@ -143,21 +241,22 @@ namespace TrenchBroom {
             Model::BrushList unselectedBrushes(unselectedWorldBrushes);
             unselectedBrushes.insert(unselectedBrushes.end(), unselectedEntityBrushes.begin(), unselectedEntityBrushes.end());
 
-            // write face triangles
+            // write face polygons
             m_faceVbo->activate();
             m_faceVbo->map();
             
-            // make sure that the VBO is sufficiently large
-            size_t totalFaceVertexCount = unselectedFaceSorter.vertexCount() + selectedFaceSorter.vertexCount() + lockedFaceSorter.vertexCount();
-            size_t totalPolygonCount = unselectedFaceSorter.polygonCount() + selectedFaceSorter.polygonCount() + lockedFaceSorter.polygonCount();
-            size_t totalTriangleVertexCount = 3 * totalFaceVertexCount - 6 * totalPolygonCount;
-            m_faceVbo->ensureFreeCapacity(static_cast<unsigned int>(totalTriangleVertexCount) * FaceVertexSize);
+            // make sure that the VBO is sufficiently large; packing moves all blocks, so it is avoided when the
+            // unselected geometry is kept
+            if (!m_geometryDataValid) {
+                size_t totalFaceVertexCount = unselectedFaceSorter.vertexCount() + selectedFaceSorter.vertexCount() + lockedFaceSorter.vertexCount();
+                m_faceVbo->ensureFreeCapacity(static_cast<unsigned int>(totalFaceVertexCount) * FaceVertexSize);
+            }
             
             Preferences::PreferenceManager& prefs = Preferences::PreferenceManager::preferences();
             TextureRendererManager& textureRendererManager = m_document.sharedResources().textureRendererManager();
             const Color& faceColor = prefs.getColor(Preferences::FaceColor);
 
-            if (!m_geometryDataValid && !unselectedFaceSorter.empty()) {
+            if (!m_geometryDataValid) {
                 assert(m_faceRenderer == NULL);
                 m_faceRenderer = new FaceRenderer(*m_faceVbo, textureRendererManager, unselectedFaceSorter, faceColor);
             }
@@ -181,7 +280,7 @@ namespace TrenchBroom {
             
             const Color& edgeColor = prefs.getColor(Preferences::EdgeColor);
 
-            if (!m_geometryDataValid && !unselectedBrushes.empty()) {
+            if (!m_geometryDataValid) {
                 assert(m_edgeRenderer == NULL);
                 m_edgeRenderer = new EdgeRenderer(*m_edgeVbo, unselectedBrushes, Model::EmptyFaceList, edgeColor);
             }
@@ -205,8 +304,13 @@ namespace TrenchBroom {
         }
         
         void MapRenderer::validate(RenderContext& context) {
+            // patching the unselected geometry brush by brush is slower than rebuilding it once many brushes changed
+            if (10 * m_invalidBrushes.size() > m_geometryBrushCount)
+                m_geometryDataValid = false;
             if (!m_geometryDataValid || !m_selectedGeometryDataValid || !m_lockedGeometryDataValid)
                 rebuildGeometryData(context);
+            if (!m_invalidBrushes.empty() || !m_invalidFaces.empty())
+                updateGeometryData(context);
         }
         
         void MapRenderer::invalidateDecorators() {
@@ -281,7 +385,15 @@ namespace TrenchBroom {
             if (changeSet.brushStateChangedFrom(Model::EditState::Default) ||
                 changeSet.brushStateChangedTo(Model::EditState::Default) ||
                 changeSet.faceSelectionChanged()) {
-                m_geometryDataValid = false;
+                const Model::BrushList& fromDefault = changeSet.brushesFrom(Model::EditState::Default);
+                const Model::BrushList& toDefault = changeSet.brushesTo(Model::EditState::Default);
+                m_invalidBrushes.insert(fromDefault.begin(), fromDefault.end());
+                m_invalidBrushes.insert(toDefault.begin(), toDefault.end());
+                
+                const Model::FaceList& selectedFaces = changeSet.faces(false);
+                const Model::FaceList& deselectedFaces = changeSet.faces(true);
+                m_invalidFaces.insert(selectedFaces.begin(), selectedFaces.end());
+                m_invalidFaces.insert(deselectedFaces.begin(), deselectedFaces.end());
                 invalidateDecorators();
             }
             
@@ -424,7 +536,10 @@ namespace TrenchBroom {
         m_rendering(false),
         m_geometryDataValid(false),
         m_selectedGeometryDataValid(false),
-        m_lockedGeometryDataValid(false) {
+        m_lockedGeometryDataValid(false),
+        m_geometryBrushCount(0),
+        m_drawnCount(0),
+        m_culledCount(0) {
             Preferences::PreferenceManager& prefs = Preferences::PreferenceManager::preferences();
 
             m_faceVbo = new Vbo(GL_ARRAY_BUFFER, 0xFFFF);
@@ -435,6 +550,7 @@ namespace TrenchBroom {
             m_entityRenderer = new EntityRenderer(*m_entityVbo, m_document);
             m_entityRenderer->setClassnameFadeDistance(prefs.getFloat(Preferences::InfoOverlayFadeDistance));
             m_entityRenderer->setClassnameColor(prefs.getColor(Preferences::InfoOverlayTextColor), prefs.getColor(Preferences::InfoOverlayBackgroundColor));
+            m_entityRenderer->setModelRenderDistance(prefs.getFloat(Preferences::EntityModelRenderDistance));
             
             m_selectedEntityRenderer = new EntityRenderer(*m_entityVbo, m_document);
             m_selectedEntityRenderer->setClassnameFadeDistance(prefs.getFloat(Preferences::SelectedInfoOverlayFadeDistance));
@@ -450,6 +566,7 @@ namespace TrenchBroom {
             m_lockedEntityRenderer->setBoundsColor(prefs.getColor(Preferences::LockedEntityBoundsColor));
             m_lockedEntityRenderer->setTintColor(prefs.getColor(Preferences::LockedEntityColor));
             m_lockedEntityRenderer->setGrayscale(true);
+            m_lockedEntityRenderer->setModelRenderDistance(prefs.getFloat(Preferences::EntityModelRenderDistance));
             
             m_entityDecorators.push_back(new EntityRotationDecorator(document, prefs.getColor(Preferences::EntityRotationDecoratorFillColor), prefs.getColor(Preferences::EntityRotationDecoratorOutlineColor)));
 				// TODO : give own color preferences
@@ -514,6 +631,12 @@ namespace TrenchBroom {
                     const Controller::PreferenceChangeEvent& preferenceChangeEvent = static_cast<const Controller::PreferenceChangeEvent&>(command);
                     if (preferenceChangeEvent.isPreferenceChanged(Preferences::QuakePath))
                         invalidateEntityModelRendererCache();
+                    if (preferenceChangeEvent.isPreferenceChanged(Preferences::EntityModelRenderDistance)) {
+                        Preferences::PreferenceManager& prefs = Preferences::PreferenceManager::preferences();
+                        const float modelRenderDistance = prefs.getFloat(Preferences::EntityModelRenderDistance);
+                        m_entityRenderer->setModelRenderDistance(modelRenderDistance);
+                        m_lockedEntityRenderer->setModelRenderDistance(modelRenderDistance);
+                    }
                     break;
                 }
                 case Controller::Command::SetFaceAttributes:
@@ -617,6 +740,8 @@ namespace TrenchBroom {
             if (m_pointTraceRenderer != NULL)
                 m_pointTraceRenderer->render(*m_utilityVbo, context);
             
+            m_drawnCount = context.frustumCuller().drawnCount();
+            m_culledCount = context.frustumCuller().culledCount();
             m_rendering = false;
         }
     }
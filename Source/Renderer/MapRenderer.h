@@ -24,6 +24,7 @@
 #include "Model/BrushTypes.h"
 #include "Model/EntityTypes.h"
 #include "Model/Face.h"
+#include "Model/FaceTypes.h"
 #include "Model/TextureTypes.h"
 #include "Renderer/EntityDecorator.h"
 #include "Renderer/Figure.h"
@@ -102,6 +103,17 @@ namespace TrenchBroom {
             bool m_selectedGeometryDataValid;
             bool m_lockedGeometryDataValid;
             
+            // brushes and faces that may have entered or left the unselected geometry since it was last updated
+            Model::BrushSet m_invalidBrushes;
+            Model::FaceSet m_invalidFaces;
+            size_t m_geometryBrushCount;
+            
+            // instrumentation, the number of vertex arrays and entity models drawn and culled in the last frame
+            size_t m_drawnCount;
+            size_t m_culledCount;
+            
+            bool unselectedBrush(RenderContext& context, const Model::Brush& brush) const;
+            void updateGeometryData(RenderContext& context);
             void rebuildGeometryData(RenderContext& context);
             
             void validate(RenderContext& context);
@@ -141,6 +153,14 @@ namespace TrenchBroom {
             void removePointTrace();
             
             void render(RenderContext& context);
+            
+            inline size_t drawnCount() const {
+                return m_drawnCount;
+            }
+            
+            inline size_t culledCount() const {
+                return m_culledCount;
+            }
         };
     }
 }
@@ -23,8 +23,66 @@
 #include <cstring>
 #include <fstream>
 
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define TB_PALETTE_SSE2
+#include <emmintrin.h>
+#endif
+
 namespace TrenchBroom {
     namespace Renderer {
+        typedef unsigned char PaletteTable[256][4];
+        
+        static inline int loadColor(const PaletteTable& table, const unsigned char index) {
+            int color;
+            memcpy(&color, table[index], 4);
+            return color;
+        }
+        
+        // converts pixelCount - 1 pixels, the last pixel is left to the caller because every pixel writes four bytes
+        static size_t convertPixels(const PaletteTable& table, const unsigned char* indexedImage, unsigned char* rgbImage, size_t pixelCount) {
+            if (pixelCount == 0)
+                return 0;
+            
+            size_t i = 0;
+#if defined(TB_PALETTE_SSE2)
+            // gather the padded colors of 16 pixels and pack them into 48 bytes, the fourth byte of every padded color is 0
+            const __m128i lowColors = _mm_setr_epi32(0x00FFFFFF, 0, 0x00FFFFFF, 0);
+            const __m128i highColors = _mm_setr_epi32(static_cast<int>(0xFF000000), 0x0000FFFF, static_cast<int>(0xFF000000), 0x0000FFFF);
+            for (; i + 16 < pixelCount; i += 16) {
+                const unsigned char* indices = indexedImage + i;
+                __m128i colors[4];
+                for (size_t j = 0; j < 4; j++) {
+                    const __m128i c0 = _mm_cvtsi32_si128(loadColor(table, indices[4 * j + 0]));
+                    const __m128i c1 = _mm_cvtsi32_si128(loadColor(table, indices[4 * j + 1]));
+                    const __m128i c2 = _mm_cvtsi32_si128(loadColor(table, indices[4 * j + 2]));
+                    const __m128i c3 = _mm_cvtsi32_si128(loadColor(table, indices[4 * j + 3]));
+                    const __m128i padded = _mm_unpacklo_epi64(_mm_unpacklo_epi32(c0, c1), _mm_unpacklo_epi32(c2, c3));
+                    
+                    // pack two colors into six bytes per quadword, then move the upper six bytes next to the lower ones
+                    const __m128i pairs = _mm_or_si128(_mm_and_si128(padded, lowColors), _mm_and_si128(_mm_srli_epi64(padded, 8), highColors));
+                    colors[j] = _mm_or_si128(_mm_move_epi64(pairs), _mm_slli_si128(_mm_srli_si128(pairs, 8), 6));
+                }
+                
+                __m128i* out = reinterpret_cast<__m128i*>(rgbImage + 3 * i);
+                _mm_storeu_si128(out + 0, _mm_or_si128(colors[0], _mm_slli_si128(colors[1], 12)));
+                _mm_storeu_si128(out + 1, _mm_or_si128(_mm_srli_si128(colors[1], 4), _mm_slli_si128(colors[2], 8)));
+                _mm_storeu_si128(out + 2, _mm_or_si128(_mm_srli_si128(colors[2], 8), _mm_slli_si128(colors[3], 4)));
+            }
+#endif
+            // the fourth byte of every pixel is overwritten by the next pixel
+            for (; i + 1 < pixelCount; i++)
+                memcpy(rgbImage + 3 * i, table[indexedImage[i]], 4);
+            return i;
+        }
+        
+        void Palette::buildTable() {
+            for (size_t i = 0; i < 256; i++) {
+                for (size_t j = 0; j < 3; j++)
+                    m_table[i][j] = 3 * i + j < m_size ? m_data[3 * i + j] : 0;
+                m_table[i][3] = 0;
+            }
+        }
+        
         Palette::Palette(const String& path) {
             std::ifstream stream(path.c_str(), std::ios::binary | std::ios::in);
             assert(stream.is_open());
@@ -36,6 +94,8 @@ namespace TrenchBroom {
 
             stream.read(reinterpret_cast<char*>(m_data), static_cast<std::streamsize>(m_size));
             stream.close();
+            
+            buildTable();
         }
 
         Palette::Palette(const Palette& other) :
@@ -43,15 +103,53 @@ namespace TrenchBroom {
         m_size(other.m_size) {
             m_data = new unsigned char[m_size];
             memcpy(m_data, other.m_data, m_size);
+            memcpy(m_table, other.m_table, sizeof(m_table));
         }
 
         void Palette::operator= (Palette other) {
             std::swap(m_data, other.m_data);
             std::swap(m_size, other.m_size);
+            memcpy(m_table, other.m_table, sizeof(m_table));
         }
 
         Palette::~Palette() {
             delete[] m_data;
         }
+        
+        void Palette::indexedToRgb(const unsigned char* indexedImage, unsigned char* rgbImage, size_t pixelCount, Color& averageColor) const {
+            const size_t converted = convertPixels(m_table, indexedImage, rgbImage, pixelCount);
+            for (size_t i = converted; i < pixelCount; i++) {
+                assert(3 * static_cast<size_t>(indexedImage[i]) + 2 < m_size);
+                memcpy(rgbImage + 3 * i, m_table[indexedImage[i]], 3);
+            }
+            
+            // the channel sums are exact integers, so they are the same as if they were accumulated per pixel
+            size_t histogram[4][256];
+            std::fill(&histogram[0][0], &histogram[0][0] + 4 * 256, 0);
+            size_t i = 0;
+            for (; i + 4 <= pixelCount; i += 4) {
+                histogram[0][indexedImage[i + 0]]++;
+                histogram[1][indexedImage[i + 1]]++;
+                histogram[2][indexedImage[i + 2]]++;
+                histogram[3][indexedImage[i + 3]]++;
+            }
+            for (; i < pixelCount; i++)
+                histogram[0][indexedImage[i]]++;
+            
+            double avg[3];
+            avg[0] = avg[1] = avg[2] = 0;
+            for (i = 0; i < 256; i++) {
+                const size_t count = histogram[0][i] + histogram[1][i] + histogram[2][i] + histogram[3][i];
+                if (count == 0)
+                    continue;
+                assert(3 * i + 2 < m_size);
+                for (size_t j = 0; j < 3; j++)
+                    avg[j] += static_cast<double>(count * m_table[i][j]);
+            }
+            
+            for (i = 0; i < 3; i++)
+                averageColor[i] = static_cast<float>(avg[i] / pixelCount / 0xFF);
+            averageColor[3] = 1.0f;
+        }
     }
 }
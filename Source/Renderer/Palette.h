@@ -31,6 +31,11 @@ namespace TrenchBroom {
         private:
             unsigned char* m_data;
             size_t m_size;
+            
+            // the palette colors padded to four bytes, so that the conversion can copy a whole word per pixel
+            unsigned char m_table[256][4];
+            
+            void buildTable();
         public:
             Palette(const String& path);
             Palette(const Palette& other);
@@ -38,23 +43,7 @@ namespace TrenchBroom {
             
             void operator= (Palette other);
             
-            inline void indexedToRgb(const unsigned char* indexedImage, unsigned char* rgbImage, size_t pixelCount, Color& averageColor) const {
-                double avg[3];
-                avg[0] = avg[1] = avg[2] = 0;
-                for (unsigned int i = 0; i < pixelCount; i++) {
-                    unsigned int index = indexedImage[i];
-                    assert(index < m_size);
-                    for (unsigned int j = 0; j < 3; j++) {
-                        unsigned char c = m_data[index * 3 + j];
-                        rgbImage[i * 3 + j] = c;
-                        avg[j] += static_cast<double>(c);
-                    }
-                }
-
-                for (unsigned int i = 0; i < 3; i++)
-                    averageColor[i] = static_cast<float>(avg[i] / pixelCount / 0xFF);
-                averageColor[3] = 1.0f;
-            }
+            void indexedToRgb(const unsigned char* indexedImage, unsigned char* rgbImage, size_t pixelCount, Color& averageColor) const;
         };
     }
 }
@@ -20,6 +20,7 @@
 #ifndef __TrenchBroom__RenderContext__
 #define __TrenchBroom__RenderContext__
 
+#include "Renderer/FrustumCuller.h"
 #include "Renderer/Transformation.h"
 
 namespace TrenchBroom {
@@ -49,6 +50,7 @@ namespace TrenchBroom {
             Camera& m_camera;
             Model::Filter& m_filter;
             Transformation m_transformation;
+            FrustumCuller m_frustumCuller;
             ShaderManager& m_shaderManager;
             Utility::Grid& m_grid;
             View::ViewOptions& m_viewOptions;
@@ -59,6 +61,7 @@ namespace TrenchBroom {
             m_camera(camera),
             m_filter(filter),
             m_transformation(m_camera.projectionMatrix(), m_camera.viewMatrix()),
+            m_frustumCuller(m_camera),
             m_shaderManager(shaderManager),
             m_grid(grid),
             m_viewOptions(viewOptions),
@@ -85,6 +88,10 @@ namespace TrenchBroom {
                 return m_transformation;
             }
 
+            inline FrustumCuller& frustumCuller() {
+                return m_frustumCuller;
+            }
+
             inline View::ViewOptions& viewOptions() const {
                 return m_viewOptions;
             }
@@ -61,9 +61,12 @@ namespace TrenchBroom {
             extern const ShaderConfig ColoredEdgeShader;
             extern const ShaderConfig EdgeShader;
             extern const ShaderConfig EntityModelShader;
+            extern const ShaderConfig InstancedEntityModelShader;
             extern const ShaderConfig FaceShader;
             extern const ShaderConfig TextShader;
             extern const ShaderConfig TextBackgroundShader;
+            extern const ShaderConfig TextLabelShader;
+            extern const ShaderConfig TextLabelBackgroundShader;
             extern const ShaderConfig TextureBrowserShader;
             extern const ShaderConfig TextureBrowserBorderShader;
             extern const ShaderConfig BrowserGroupShader;
@@ -186,7 +186,7 @@ namespace TrenchBroom {
             
             m_modelRendererManager = new EntityModelRendererManager(console);
             m_shaderManager = new ShaderManager(console);
-            m_textureRendererManager = new TextureRendererManager(textureManager);
+            m_textureRendererManager = new TextureRendererManager(textureManager, console);
             m_fontManager = new Text::FontManager(console);
             
             SetPosition(wxPoint(-10, -10));
@@ -74,15 +74,13 @@ namespace TrenchBroom {
             public:
                 virtual ~TextAnchor() {}
 
-                inline const Vec3f offset(const Camera& camera, const Vec2f& size) const {
+                // the offset of the lower left corner of a text of the given size from its projected anchor position
+                inline const Vec2f offset(const Vec2f& size) const {
                     const Vec2f halfSize = size / 2.0f;
                     const Vec2f factors = alignmentFactors();
-                    Vec3f offset = camera.project(basePosition());
-                    for (size_t i = 0; i < 2; i++) {
-                        offset[i] += factors[i] * size[i];
-                        offset[i] -= halfSize[i];
-                        offset[i] = Math<float>::round(offset[i]);
-                    }
+                    Vec2f offset;
+                    for (size_t i = 0; i < 2; i++)
+                        offset[i] = factors[i] * size[i] - halfSize[i];
                     return offset;
                 }
 
@@ -137,20 +135,20 @@ namespace TrenchBroom {
             protected:
                 class TextEntry {
                 private:
-                    Vec2f::List m_vertices;
+                    TexturedFont::QuadsPtr m_vertices;
                     Vec2f m_size;
                     TextAnchor::Ptr m_textAnchor;
                 public:
-                    TextEntry(const Vec2f::List& vertices, const Vec2f& size, TextAnchor::Ptr textAnchor) :
+                    TextEntry(TexturedFont::QuadsPtr vertices, const Vec2f& size, TextAnchor::Ptr textAnchor) :
                     m_vertices(vertices),
                     m_size(size),
                     m_textAnchor(textAnchor) {}
                     
                     inline const Vec2f::List& vertices() const {
-                        return m_vertices;
+                        return *m_vertices;
                     }
 
-                    inline void update(const Vec2f::List& vertices, const Vec2f& size) {
+                    inline void update(TexturedFont::QuadsPtr vertices, const Vec2f& size) {
                         m_vertices = vertices;
                         m_size = size;
                     }
@@ -164,9 +162,27 @@ namespace TrenchBroom {
                     }
                 };
 
+                // the location of an uploaded string in the vertex arrays
+                class CellEntry {
+                public:
+                    Key key;
+                    Vec3f position;
+                    GLint textIndex;
+                    GLsizei textCount;
+                    GLint rectIndex;
+                    
+                    CellEntry(const Key& i_key, const Vec3f& i_position, GLint i_textIndex, GLsizei i_textCount, GLint i_rectIndex) :
+                    key(i_key),
+                    position(i_position),
+                    textIndex(i_textIndex),
+                    textCount(i_textCount),
+                    rectIndex(i_rectIndex) {}
+                };
+                
                 typedef std::map<Key, TextEntry, Comparator> TextMap;
                 typedef std::pair<Key, TextEntry> TextMapItem;
-                typedef std::vector<TextEntry> EntryList;
+                typedef std::vector<CellEntry> CellEntryList;
+                typedef std::map<Vec3f, CellEntryList, Vec3f::LexicographicOrder> Grid;
 
                 TexturedFont& m_font;
                 float m_fadeDistance;
@@ -175,31 +191,140 @@ namespace TrenchBroom {
 
                 TextMap m_entries;
                 Vbo* m_vbo;
-
-                inline void addString(Key key, const Vec2f::List& vertices, const Vec2f& size, TextAnchor::Ptr anchor) {
+                VertexArray* m_textArray;
+                VertexArray* m_rectArray;
+                GLsizei m_rectVertexCount;
+                bool m_valid;
+                
+                // the uploaded strings by their anchor position, the cell size is the cutoff distance
+                Grid m_grid;
+                float m_cellSize;
+                
+                VertexArray::IndexArray m_textIndices;
+                VertexArray::CountArray m_textCounts;
+                VertexArray::IndexArray m_rectIndices;
+                VertexArray::CountArray m_rectCounts;
+
+                inline void addString(Key key, TexturedFont::QuadsPtr vertices, const Vec2f& size, TextAnchor::Ptr anchor) {
                     removeString(key);
                     m_entries.insert(TextMapItem(key, TextEntry(vertices, size, anchor)));
+                    m_valid = false;
                 }
-
-                EntryList visibleEntries(RenderContext& context, const TextRendererFilter& filter) {
-                    float cutoff = (m_fadeDistance + 100) * (m_fadeDistance + 100);
-                    EntryList result;
-
-                    typename TextMap::iterator it, end;
+                
+                inline float cutoffDistance() const {
+                    return m_fadeDistance + 100.0f;
+                }
+                
+                inline const Vec3f cell(const Vec3f& position) const {
+                    Vec3f cell;
+                    for (size_t i = 0; i < 3; i++)
+                        cell[i] = std::floor(position[i] / m_cellSize);
+                    return cell;
+                }
+                
+                void validate() {
+                    delete m_textArray;
+                    m_textArray = NULL;
+                    delete m_rectArray;
+                    m_rectArray = NULL;
+                    m_grid.clear();
+                    m_cellSize = cutoffDistance();
+                    m_valid = true;
+                    
+                    if (m_entries.empty())
+                        return;
+                    
+                    if (m_vbo == NULL)
+                        m_vbo = new Vbo(GL_ARRAY_BUFFER, 0xFFFF);
+                    
+                    size_t textVertexCount = 0;
+                    typename TextMap::const_iterator it, end;
+                    for (it = m_entries.begin(), end = m_entries.end(); it != end; ++it)
+                        textVertexCount += it->second.vertices().size() / 2;
+                    
+                    // 16 triangles (for a rounded rect with 3 triangles per corner: 3 * 4 + 4 = 16)
+                    m_rectVertexCount = 3 * 16;
+                    const size_t rectVertexCount = static_cast<size_t>(m_rectVertexCount) * m_entries.size();
+                    
+                    SetVboState mapVbo(*m_vbo, Vbo::VboMapped);
+                    m_textArray = new VertexArray(*m_vbo, GL_QUADS, static_cast<unsigned int>(textVertexCount),
+                                                  Attribute::position3f(),
+                                                  Attribute::texCoord02f(),
+                                                  Attribute::texCoord14f());
+                    m_rectArray = new VertexArray(*m_vbo, GL_TRIANGLES, static_cast<unsigned int>(rectVertexCount),
+                                                  Attribute::position3f(),
+                                                  Attribute::texCoord14f());
+                    
+                    Vec2f::List rectVertices;
+                    rectVertices.reserve(static_cast<size_t>(m_rectVertexCount));
+                    
                     for (it = m_entries.begin(), end = m_entries.end(); it != end; ++it) {
-                        Key key = it->first;
-                        if (filter.stringVisible(context, key)) {
-                            const TextEntry& entry = it->second;
-                            const TextAnchor& anchor = entry.textAnchor();
-                            const Vec3f position = anchor.position();
-
-                            float dist2 = context.camera().squaredDistanceTo(position);
-                            if (dist2 <= cutoff)
-                                result.push_back(entry);
+                        const TextEntry& entry = it->second;
+                        const Vec2f size = entry.size().rounded();
+                        const TextAnchor& anchor = entry.textAnchor();
+                        const Vec3f position = anchor.position();
+                        const Vec2f offset = anchor.offset(size);
+                        
+                        const GLint textIndex = static_cast<GLint>(m_textArray->vertexCount());
+                        const Vec2f::List& textVertices = entry.vertices();
+                        for (size_t j = 0; j < textVertices.size() / 2; j++) {
+                            const Vec2f& vertex = textVertices[2 * j];
+                            const Vec2f& texCoords = textVertices[2 * j + 1];
+                            
+                            m_textArray->addAttribute(position);
+                            m_textArray->addAttribute(texCoords);
+                            m_textArray->addAttribute(Vec4f(offset.x(), offset.y(), vertex.x(), vertex.y()));
+                        }
+                        
+                        const GLint rectIndex = static_cast<GLint>(m_rectArray->vertexCount());
+                        rectVertices.clear();
+                        roundedRect(size.x() + 2.0f * m_hInset, size.y() + 2.0f * m_vInset, 3.0f, 3, rectVertices);
+                        assert(rectVertices.size() == static_cast<size_t>(m_rectVertexCount));
+                        for (size_t j = 0; j < rectVertices.size(); j++) {
+                            const Vec2f& vertex = rectVertices[j];
+                            m_rectArray->addAttribute(position);
+                            m_rectArray->addAttribute(Vec4f(offset.x(), offset.y(), vertex.x() + size.x() / 2.0f, vertex.y() + size.y() / 2.0f));
+                        }
+                        
+                        const GLsizei textCount = static_cast<GLsizei>(textVertices.size() / 2);
+                        m_grid[cell(position)].push_back(CellEntry(it->first, position, textIndex, textCount, rectIndex));
+                    }
+                }
+                
+                void gatherVisibleStrings(RenderContext& context, const TextRendererFilter& filter) {
+                    m_textIndices.clear();
+                    m_textCounts.clear();
+                    m_rectIndices.clear();
+                    m_rectCounts.clear();
+                    
+                    const float cutoff = cutoffDistance();
+                    const float cutoff2 = cutoff * cutoff;
+                    const Vec3f& cameraPosition = context.camera().position();
+                    const Vec3f minCell = cell(cameraPosition - Vec3f(cutoff, cutoff, cutoff));
+                    const Vec3f maxCell = cell(cameraPosition + Vec3f(cutoff, cutoff, cutoff));
+                    
+                    Vec3f current;
+                    for (current[0] = minCell.x(); current[0] <= maxCell.x(); current[0] += 1.0f) {
+                        for (current[1] = minCell.y(); current[1] <= maxCell.y(); current[1] += 1.0f) {
+                            for (current[2] = minCell.z(); current[2] <= maxCell.z(); current[2] += 1.0f) {
+                                typename Grid::const_iterator cellIt = m_grid.find(current);
+                                if (cellIt == m_grid.end())
+                                    continue;
+                                
+                                const CellEntryList& cellEntries = cellIt->second;
+                                for (size_t i = 0; i < cellEntries.size(); i++) {
+                                    const CellEntry& cellEntry = cellEntries[i];
+                                    if ((cellEntry.position - cameraPosition).lengthSquared() <= cutoff2 &&
+                                        filter.stringVisible(context, cellEntry.key)) {
+                                        m_textIndices.push_back(cellEntry.textIndex);
+                                        m_textCounts.push_back(cellEntry.textCount);
+                                        m_rectIndices.push_back(cellEntry.rectIndex);
+                                        m_rectCounts.push_back(m_rectVertexCount);
+                                    }
+                                }
+                            }
                         }
                     }
-
-                    return result;
                 }
             public:
                 TextRenderer(TexturedFont& font) :
@@ -207,24 +332,32 @@ namespace TrenchBroom {
                 m_fadeDistance(100.0f),
                 m_hInset(4.0f),
                 m_vInset(4.0f),
-                m_vbo(NULL) {}
+                m_vbo(NULL),
+                m_textArray(NULL),
+                m_rectArray(NULL),
+                m_rectVertexCount(0),
+                m_valid(true),
+                m_cellSize(0.0f) {}
 
                 ~TextRenderer() {
                     clear();
+                    delete m_textArray;
+                    m_textArray = NULL;
+                    delete m_rectArray;
+                    m_rectArray = NULL;
                     delete m_vbo;
                     m_vbo = NULL;
                 }
 
                 inline void addString(Key key, const String& string, TextAnchor::Ptr anchor) {
-                    const Vec2f::List vertices = m_font.quads(string, true);
-                    const Vec2f size = m_font.measure(string);
-                    addString(key, vertices, size, anchor);
+                    addString(key, m_font.sharedQuads(string, true), m_font.measure(string), anchor);
                 }
 
                 inline void removeString(Key key)  {
                     typename TextMap::iterator it = m_entries.find(key);
                     if (it != m_entries.end()) {
                         m_entries.erase(it);
+                        m_valid = false;
                     }
                 }
 
@@ -232,7 +365,8 @@ namespace TrenchBroom {
                     typename TextMap::iterator it = m_entries.find(key);
                     if (it != m_entries.end()) {
                         TextEntry& entry = it->second;
-                        entry.setVertices(m_font.quads(string, true));
+                        entry.update(m_font.sharedQuads(string, true), m_font.measure(string));
+                        m_valid = false;
                     }
                 }
 
@@ -242,6 +376,7 @@ namespace TrenchBroom {
                         TextEntry& entry = it->second;
                         destination.addString(key, entry.vertices(), entry.textAnchor());
                         m_entries.erase(it);
+                        m_valid = false;
                     }
                 }
 
@@ -251,87 +386,52 @@ namespace TrenchBroom {
 
                 inline void clear()  {
                     m_entries.clear();
+                    m_valid = false;
+                }
+                
+                // must be called when the anchor positions or alignments have changed
+                inline void invalidate() {
+                    m_valid = false;
                 }
 
                 inline void setFadeDistance(float fadeDistance)  {
                     m_fadeDistance = fadeDistance;
+                    m_valid = false;
                 }
 
                 void render(RenderContext& context, const TextRendererFilter& filter, ShaderProgram& textProgram, const Color& textColor, ShaderProgram& backgroundProgram, const Color& backgroundColor) {
                     if (m_entries.empty())
                         return;
 
-                    EntryList entries = visibleEntries(context, filter);
-                    if (entries.empty())
+                    if (!m_valid)
+                        validate();
+                    
+                    gatherVisibleStrings(context, filter);
+                    if (m_textIndices.empty())
                         return;
 
-                    if (m_vbo == NULL)
-                        m_vbo = new Vbo(GL_ARRAY_BUFFER, 0xFFFF);
-
-                    size_t textVertexCount = 0;
-                    for (size_t i = 0; i < entries.size(); i++) {
-                        const TextEntry& entry = entries[i];
-                        textVertexCount += entry.vertices().size() / 2;
-                    }
-
-                    VertexArray textArray(*m_vbo, GL_QUADS, static_cast<unsigned int>(textVertexCount),
-                                          Attribute::position3f(),
-                                          Attribute::texCoord02f());
-
-                    size_t rectVertexCount = 3 * 16 * entries.size(); // 16 triangles (for a rounded rect with 3 triangles per corner: 3 * 4 + 4 = 16)
-                    VertexArray rectArray(*m_vbo, GL_TRIANGLES, static_cast<unsigned int>(rectVertexCount),
-                                          Attribute::position3f());
-
-                    SetVboState mapVbo(*m_vbo, Vbo::VboMapped);
-                    for (size_t i = 0; i < entries.size(); i++) {
-                        const TextEntry& entry = entries[i];
-                        const Vec2f& size = entry.size().rounded();
-                        const TextAnchor& anchor = entry.textAnchor();
-                        const Vec3f offset = anchor.offset(context.camera(), size);
-
-                        const Vec2f::List& textVertices = entry.vertices();
-                        for (size_t j = 0; j < textVertices.size() / 2; j++) {
-                            const Vec2f& vertex = textVertices[2 * j];
-                            const Vec2f& texCoords = textVertices[2 * j + 1];
-
-                            textArray.addAttribute(Vec3f(vertex.x() + offset.x(), vertex.y() + offset.y(), -offset.z()));
-                            textArray.addAttribute(texCoords);
-                        }
-
-                        Vec2f::List rectVertices;
-                        rectVertices.reserve(3 * 16);
-                        roundedRect(size.x() + 2.0f * m_hInset, size.y() + 2.0f * m_vInset, 3.0f, 3, rectVertices);
-                        for (size_t j = 0; j < rectVertices.size(); j++) {
-                            const Vec2f& vertex = rectVertices[j];
-                            rectArray.addAttribute(Vec3f(vertex.x() + offset.x() + size.x() / 2.0f, vertex.y() + offset.y() + size.y() / 2.0f, -offset.z()));
-                        }
-                    }
-
                     const Camera::Viewport& viewport = context.camera().viewport();
-
-                    const Mat4f projection = orthoMatrix(0.0f, 1.0f,
-                                                         static_cast<float>(viewport.x),
-                                                         static_cast<float>(viewport.height),
-                                                         static_cast<float>(viewport.width),
-                                                         static_cast<float>(viewport.y));
-                    const Mat4f view = viewMatrix(Vec3f::NegZ, Vec3f::PosY);
-
-                    ApplyTransformation ortho(context.transformation(), projection, view);
-
+                    const Vec4f viewportVec(static_cast<float>(viewport.x),
+                                            static_cast<float>(viewport.y),
+                                            static_cast<float>(viewport.width),
+                                            static_cast<float>(viewport.height));
+                    
                     SetVboState activateVbo(*m_vbo, Vbo::VboActive);
                     glDepthMask(GL_FALSE);
 
                     if (backgroundProgram.activate()) {
+                        backgroundProgram.setUniformVariable("Viewport", viewportVec);
                         backgroundProgram.setUniformVariable("Color", backgroundColor);
-                        rectArray.render();
+                        m_rectArray->render(m_rectIndices, m_rectCounts);
                         backgroundProgram.deactivate();
                     }
 
                     if (textProgram.activate()) {
+                        textProgram.setUniformVariable("Viewport", viewportVec);
                         textProgram.setUniformVariable("Color", textColor);
                         textProgram.setUniformVariable("Texture", 0);
                         m_font.activate();
-                        textArray.render();
+                        m_textArray->render(m_textIndices, m_textCounts);
                         m_font.deactivate();
                         textProgram.deactivate();
                     }
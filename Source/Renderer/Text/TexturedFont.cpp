@@ -28,6 +28,7 @@ namespace TrenchBroom {
     namespace Renderer {
         namespace Text {
             TexturedFont::TexturedFont(FT_Face face, const unsigned char minChar, const unsigned char maxChar) :
+            m_stringCache(StringCacheCapacity),
             m_minChar(minChar),
             m_maxChar(maxChar),
             m_lineHeight(0),
@@ -97,11 +98,7 @@ namespace TrenchBroom {
                 m_bitmap = NULL;
             }
 
-            Vec2f::List TexturedFont::quads(const String& string, bool clockwise, const Vec2f& offset) {
-                Vec2f::List result;
-
-                int x = static_cast<int>(Math<float>::round(offset.x()));
-                int y = static_cast<int>(Math<float>::round(offset.y()));
+            void TexturedFont::layoutQuads(const String& string, bool clockwise, int x, int y, Vec2f::List& result) const {
                 for (size_t i = 0; i < string.length(); i++) {
                     char c = string[i];
                     if (c == '\n') {
@@ -119,11 +116,9 @@ namespace TrenchBroom {
 
                     x += glyph.a;
                 }
-
-                return result;
             }
 
-            Vec2f TexturedFont::measure(const String& string) {
+            Vec2f TexturedFont::layoutSize(const String& string) const {
                 Vec2f result;
 
                 int x = 0;
@@ -149,6 +144,49 @@ namespace TrenchBroom {
                 return result;
             }
 
+            TexturedFont::StringLayout& TexturedFont::stringLayout(const String& string) {
+                StringLayout* layout = m_stringCache.find(string);
+                if (layout != NULL)
+                    return *layout;
+                return m_stringCache.insert(string, StringLayout(layoutSize(string)));
+            }
+
+            Vec2f::List TexturedFont::quads(const String& string, bool clockwise, const Vec2f& offset) {
+                const int x = static_cast<int>(Math<float>::round(offset.x()));
+                const int y = static_cast<int>(Math<float>::round(offset.y()));
+                
+                // the lines following a line break start at x = 0, so the cached quads can only be moved horizontally
+                // if there is a single line
+                if (x != 0 && string.find('\n') != String::npos) {
+                    Vec2f::List result;
+                    layoutQuads(string, clockwise, x, y, result);
+                    return result;
+                }
+                
+                Vec2f::List result = *sharedQuads(string, clockwise);
+                if (x != 0 || y != 0) {
+                    const Vec2f translation(static_cast<float>(x), static_cast<float>(y));
+                    for (size_t i = 0; i < result.size(); i += 2)
+                        result[i] += translation;
+                }
+                return result;
+            }
+
+            TexturedFont::QuadsPtr TexturedFont::sharedQuads(const String& string, bool clockwise) {
+                StringLayout& layout = stringLayout(string);
+                QuadsPtr& quads = clockwise ? layout.clockwiseQuads : layout.counterClockwiseQuads;
+                if (quads.get() == NULL) {
+                    Vec2f::List* vertices = new Vec2f::List();
+                    layoutQuads(string, clockwise, 0, 0, *vertices);
+                    quads = QuadsPtr(vertices);
+                }
+                return quads;
+            }
+
+            Vec2f TexturedFont::measure(const String& string) {
+                return stringLayout(string).size;
+            }
+
             void TexturedFont::activate() {
                 if (m_textureId == 0) {
                     assert(m_bitmap != NULL);
@@ -23,6 +23,8 @@
 #include "GL/glew.h"
 #include "Renderer/Text/FontDescriptor.h"
 #include "Utility/FreeType.h"
+#include "Utility/LRUCache.h"
+#include "Utility/SharedPointer.h"
 #include "Utility/String.h"
 #include "Utility/VecMath.h"
 
@@ -36,8 +38,11 @@ namespace TrenchBroom {
             class TextureBitmap;
 
             class TexturedFont {
+            public:
+                typedef std::tr1::shared_ptr<const Vec2f::List> QuadsPtr;
             private:
                 static const int Border = 3;
+                static const size_t StringCacheCapacity = 8192;
 
                 struct Char {
                     int x, y, w, h, a;
@@ -90,6 +95,20 @@ namespace TrenchBroom {
                 typedef std::vector<Char> CharList;
                 CharList m_chars;
 
+                // the laid out strings at offset 0, every orientation is created on demand
+                class StringLayout {
+                public:
+                    Vec2f size;
+                    QuadsPtr clockwiseQuads;
+                    QuadsPtr counterClockwiseQuads;
+                    
+                    StringLayout(const Vec2f& i_size) :
+                    size(i_size) {}
+                };
+
+                typedef Utility::LRUCache<String, StringLayout> StringCache;
+                StringCache m_stringCache;
+
                 unsigned char m_minChar;
                 unsigned char m_maxChar;
                 int m_lineHeight;
@@ -97,11 +116,16 @@ namespace TrenchBroom {
                 GLuint m_textureId;
                 int m_textureLength;
                 TextureBitmap* m_bitmap;
+                
+                void layoutQuads(const String& string, bool clockwise, int x, int y, Vec2f::List& result) const;
+                Vec2f layoutSize(const String& string) const;
+                StringLayout& stringLayout(const String& string);
             public:
                 TexturedFont(FT_Face face, const unsigned char minChar = ' ', const unsigned char maxChar = '~');
                 ~TexturedFont();
 
                 Vec2f::List quads(const String& string, bool clockwise, const Vec2f& offset = Vec2f());
+                QuadsPtr sharedQuads(const String& string, bool clockwise);
                 Vec2f measure(const String& string);
 
                 void activate();
@@ -0,0 +1,173 @@
+/*
+ Copyright (C) 2010-2012 Kristian Duske
+ 
+ This file is part of TrenchBroom.
+ 
+ TrenchBroom is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+ 
+ TrenchBroom is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ 
+ You should have received a copy of the GNU General Public License
+ along with TrenchBroom.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "TextureDecoder.h"
+
+#include "Model/TextureManager.h"
+#include "Utility/WorkerPool.h"
+
+#include <wx/app.h>
+#include <wx/stopwatch.h>
+
+#include <algorithm>
+#include <cassert>
+
+namespace TrenchBroom {
+    namespace Renderer {
+        class TextureDecoder::Worker : public wxThread {
+        private:
+            TextureDecoder& m_decoder;
+        protected:
+            ExitCode Entry() {
+                Job* job = NULL;
+                while (m_decoder.nextJob(job)) {
+                    job->decode();
+                    m_decoder.finishJob(job);
+                }
+                return 0;
+            }
+        public:
+            Worker(TextureDecoder& decoder) :
+            wxThread(wxTHREAD_JOINABLE),
+            m_decoder(decoder) {}
+        };
+        
+        template <typename Container>
+        static void deleteJobs(Container& jobs, const TextureRendererCollection& collection) {
+            typename Container::iterator it = jobs.begin();
+            while (it != jobs.end()) {
+                if (&(*it)->collection == &collection) {
+                    delete *it;
+                    it = jobs.erase(it);
+                } else {
+                    ++it;
+                }
+            }
+        }
+        
+        static bool containsJob(const TextureDecoder::JobList& jobs, const TextureRendererCollection& collection) {
+            for (size_t i = 0; i < jobs.size(); i++)
+                if (&jobs[i]->collection == &collection)
+                    return true;
+            return false;
+        }
+        
+        void TextureDecoder::Job::decode() {
+            wxStopWatch watch;
+            rgbImage = loader.load(textureName, palette, averageColor);
+            decodeTime = watch.TimeInMicro().ToDouble() / 1000.0;
+        }
+        
+        void TextureDecoder::startWorkers() {
+            // leave one core to the main thread
+            const size_t workerCount = std::max(static_cast<size_t>(1), Utility::WorkerPool::workerCount() - 1);
+            for (size_t i = 0; i < workerCount; i++) {
+                Worker* worker = new Worker(*this);
+                if (worker->Create() == wxTHREAD_NO_ERROR && worker->Run() == wxTHREAD_NO_ERROR) {
+                    m_workers.push_back(worker);
+                } else {
+                    delete worker;
+                    break;
+                }
+            }
+        }
+        
+        bool TextureDecoder::nextJob(Job*& job) {
+            wxMutexLocker lock(m_mutex);
+            while (m_queuedJobs.empty() && !m_exiting)
+                m_condition.Wait();
+            if (m_exiting)
+                return false;
+            
+            job = m_queuedJobs.front();
+            m_queuedJobs.pop_front();
+            m_runningJobs.push_back(job);
+            return true;
+        }
+        
+        void TextureDecoder::finishJob(Job* job) {
+            bool notify = false;
+            {
+                wxMutexLocker lock(m_mutex);
+                JobList::iterator it = std::find(m_runningJobs.begin(), m_runningJobs.end(), job);
+                if (it != m_runningJobs.end())
+                    m_runningJobs.erase(it);
+                notify = m_finishedJobs.empty();
+                m_finishedJobs.push_back(job);
+                m_condition.Broadcast();
+            }
+            
+            if (notify && wxTheApp != NULL)
+                wxTheApp->QueueEvent(new ExecutableEvent(m_notifier));
+        }
+        
+        TextureDecoder::TextureDecoder(ExecutableEvent::Executable::Ptr notifier) :
+        m_condition(m_mutex),
+        m_notifier(notifier),
+        m_exiting(false) {}
+        
+        TextureDecoder::~TextureDecoder() {
+            {
+                wxMutexLocker lock(m_mutex);
+                m_exiting = true;
+                m_condition.Broadcast();
+            }
+            
+            for (size_t i = 0; i < m_workers.size(); i++) {
+                m_workers[i]->Wait();
+                delete m_workers[i];
+            }
+            m_workers.clear();
+            
+            while (!m_queuedJobs.empty()) delete m_queuedJobs.back(), m_queuedJobs.pop_back();
+            while (!m_runningJobs.empty()) delete m_runningJobs.back(), m_runningJobs.pop_back();
+            while (!m_finishedJobs.empty()) delete m_finishedJobs.back(), m_finishedJobs.pop_back();
+        }
+        
+        void TextureDecoder::enqueue(Job* job) {
+            if (m_workers.empty())
+                startWorkers();
+            
+            // if no thread could be started, the job is done right away
+            if (m_workers.empty()) {
+                job->decode();
+                finishJob(job);
+                return;
+            }
+            
+            wxMutexLocker lock(m_mutex);
+            m_queuedJobs.push_back(job);
+            m_condition.Broadcast();
+        }
+        
+        void TextureDecoder::cancel(const TextureRendererCollection& collection) {
+            wxMutexLocker lock(m_mutex);
+            deleteJobs(m_queuedJobs, collection);
+            while (containsJob(m_runningJobs, collection))
+                m_condition.Wait();
+            deleteJobs(m_finishedJobs, collection);
+        }
+        
+        void TextureDecoder::takeFinishedJobs(JobList& jobs) {
+            wxMutexLocker lock(m_mutex);
+            jobs.insert(jobs.end(), m_finishedJobs.begin(), m_finishedJobs.end());
+            m_finishedJobs.clear();
+        }
+    }
+}
@@ -0,0 +1,116 @@
+/*
+ Copyright (C) 2010-2012 Kristian Duske
+ 
+ This file is part of TrenchBroom.
+ 
+ TrenchBroom is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+ 
+ TrenchBroom is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ 
+ You should have received a copy of the GNU General Public License
+ along with TrenchBroom.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __TrenchBroom__TextureDecoder__
+#define __TrenchBroom__TextureDecoder__
+
+#include "Utility/Color.h"
+#include "Utility/ExecutableEvent.h"
+#include "Utility/String.h"
+
+#include <wx/thread.h>
+
+#include <deque>
+#include <vector>
+
+namespace TrenchBroom {
+    namespace Model {
+        class TextureCollectionLoader;
+    }
+    
+    namespace Renderer {
+        class Palette;
+        class TextureRenderer;
+        class TextureRendererCollection;
+        
+        /*
+         Decodes textures on background threads. The finished jobs must be taken by the main thread, which is notified
+         by queueing the given executable whenever a job finishes and no other finished job is waiting.
+         */
+        class TextureDecoder {
+        public:
+            class Job {
+            public:
+                TextureRendererCollection& collection;
+                TextureRenderer& textureRenderer;
+                const Model::TextureCollectionLoader& loader;
+                const Palette& palette;
+                const String textureName;
+                const unsigned int width;
+                const unsigned int height;
+                
+                // set by decode, the image is NULL if the texture could not be loaded
+                unsigned char* rgbImage;
+                Color averageColor;
+                double decodeTime;
+                
+                Job(TextureRendererCollection& i_collection, TextureRenderer& i_textureRenderer, const Model::TextureCollectionLoader& i_loader, const Palette& i_palette, const String& i_textureName, unsigned int i_width, unsigned int i_height) :
+                collection(i_collection),
+                textureRenderer(i_textureRenderer),
+                loader(i_loader),
+                palette(i_palette),
+                textureName(i_textureName),
+                width(i_width),
+                height(i_height),
+                rgbImage(NULL),
+                decodeTime(0.0) {}
+                
+                ~Job() {
+                    delete [] rgbImage;
+                }
+                
+                void decode();
+            };
+            
+            typedef std::vector<Job*> JobList;
+        private:
+            class Worker;
+            friend class Worker;
+            typedef std::vector<Worker*> WorkerList;
+            
+            wxMutex m_mutex;
+            wxCondition m_condition;
+            std::deque<Job*> m_queuedJobs;
+            JobList m_runningJobs;
+            JobList m_finishedJobs;
+            WorkerList m_workers;
+            ExecutableEvent::Executable::Ptr m_notifier;
+            bool m_exiting;
+            
+            void startWorkers();
+            bool nextJob(Job*& job);
+            void finishJob(Job* job);
+            
+            // prevent copying
+            TextureDecoder(const TextureDecoder& other);
+            void operator= (const TextureDecoder& other);
+        public:
+            TextureDecoder(ExecutableEvent::Executable::Ptr notifier);
+            ~TextureDecoder();
+            
+            void enqueue(Job* job);
+            
+            // deletes the queued and finished jobs of the given collection and waits until its running jobs are finished
+            void cancel(const TextureRendererCollection& collection);
+            void takeFinishedJobs(JobList& jobs);
+        };
+    }
+}
+
+#endif /* defined(__TrenchBroom__TextureDecoder__) */
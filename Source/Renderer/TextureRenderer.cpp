@@ -43,6 +43,15 @@ namespace TrenchBroom {
             init(rgbImage, width, height);
         }
         
+        TextureRenderer::TextureRenderer(const Color& averageColor) :
+        m_averageColor(averageColor) {
+            init(1, 1);
+            m_textureBuffer = new unsigned char[4];
+            for (int i = 0; i < 3; i++)
+                m_textureBuffer[i] = static_cast<unsigned char>(averageColor[i] * 0xFF);
+            m_textureBuffer[3] = 0;
+        }
+        
         TextureRenderer::TextureRenderer(const Model::AliasSkin& skin, unsigned int skinIndex, const Palette& palette) {
             init(skin.width(), skin.height());
             m_textureBuffer = new unsigned char[m_width * m_height * 3];
@@ -69,22 +78,33 @@ namespace TrenchBroom {
                 delete [] m_textureBuffer;
         }
 
+        void TextureRenderer::setImage(unsigned char* rgbImage, const Color& averageColor, unsigned int width, unsigned int height) {
+            if (m_textureBuffer != NULL)
+                delete [] m_textureBuffer;
+            m_textureBuffer = rgbImage;
+            m_averageColor = averageColor;
+            m_width = width;
+            m_height = height;
+        }
+        
         void TextureRenderer::activate() {
-            if (m_textureId == 0) {
-                if (m_textureBuffer != NULL) {
+            if (m_textureBuffer != NULL) {
+                if (m_textureId == 0) {
                     glGenTextures(1, &m_textureId);
                     glBindTexture(GL_TEXTURE_2D, m_textureId);
                     glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
                     glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
                     glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
                     glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-                    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, static_cast<GLsizei>(m_width), static_cast<GLsizei>(m_height), 0, GL_RGB, GL_UNSIGNED_BYTE, m_textureBuffer);
-                    delete [] m_textureBuffer;
-                    m_textureBuffer = NULL;
+                } else {
+                    glBindTexture(GL_TEXTURE_2D, m_textureId);
                 }
+                glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, static_cast<GLsizei>(m_width), static_cast<GLsizei>(m_height), 0, GL_RGB, GL_UNSIGNED_BYTE, m_textureBuffer);
+                delete [] m_textureBuffer;
+                m_textureBuffer = NULL;
+            } else {
+                glBindTexture(GL_TEXTURE_2D, m_textureId);
             }
-            
-            glBindTexture(GL_TEXTURE_2D, m_textureId);
         }
         
         void TextureRenderer::deactivate() {
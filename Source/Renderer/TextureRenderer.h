@@ -52,6 +52,7 @@ namespace TrenchBroom {
             void operator= (const TextureRenderer& other);
         public:
             TextureRenderer(unsigned char* rgbImage, const Color& averageColor, unsigned int width, unsigned int height);
+            TextureRenderer(const Color& averageColor);
             TextureRenderer(const Model::AliasSkin& skin, unsigned int skinIndex, const Palette& palette);
             TextureRenderer(const Model::BspTexture& texture, const Palette& palette);
             TextureRenderer();
@@ -61,6 +62,9 @@ namespace TrenchBroom {
                 return m_averageColor;
             }
             
+            // replaces the image, the new image is uploaded when the texture is activated the next time
+            void setImage(unsigned char* rgbImage, const Color& averageColor, unsigned int width, unsigned int height);
+            
             void activate();
             void deactivate();
         };
@@ -22,57 +22,96 @@
 #include "Model/Texture.h"
 #include "Model/TextureManager.h"
 #include "Renderer/TextureRenderer.h"
+#include "Utility/Console.h"
 #include "Utility/Map.h"
 
+#include <wx/toplevel.h>
+
 #include <cassert>
 #include <exception>
 
 namespace TrenchBroom {
     namespace Renderer {
-        TextureRendererCollection::TextureRendererCollection(Model::TextureCollection& textureCollection, const Palette& palette) {
-            typedef std::pair<TextureRendererMap::iterator, bool> InsertResult;
-
-            Color averageColor;
-            Model::TextureCollection::LoaderPtr loader = textureCollection.loader();
-
-            const Model::TextureList& textures = textureCollection.textures();
-            for (unsigned int i = 0; i < textures.size(); i++) {
-                Model::Texture& texture = *textures[i];
-                unsigned char* textureImage = loader->load(texture, palette, averageColor);
-                if (textureImage != NULL) {
-                    TextureRenderer* textureRenderer = new TextureRenderer(textureImage, averageColor, texture.width(), texture.height());
-                    InsertResult result = m_textures.insert(TextureRendererEntry(&texture, textureRenderer));
-                    assert(result.second);
-                }
-            }
-        }
+        TextureRendererCollection::TextureRendererCollection(Model::TextureCollection& textureCollection, const Palette& palette, TextureDecoder& decoder, Utility::Console& console) :
+        m_name(textureCollection.name()),
+        m_loader(textureCollection.loader()),
+        m_palette(palette),
+        m_decoder(decoder),
+        m_console(console),
+        m_pendingCount(0),
+        m_decodedCount(0),
+        m_decodeTime(0.0) {}
         
-        TextureRenderer* TextureRendererCollection::renderer(Model::Texture& texture) const {
-            TextureRendererMap::const_iterator it = m_textures.find(&texture);
-            if (it == m_textures.end())
-                return NULL;
-            return it->second;
-        }
-
         TextureRendererCollection::~TextureRendererCollection() {
+            m_decoder.cancel(*this);
+            
             TextureRendererMap::iterator it, end;
             for (it = m_textures.begin(), end = m_textures.end(); it != end; ++it)
                 delete it->second;
             m_textures.clear();
         }
 
+        TextureRenderer* TextureRendererCollection::renderer(Model::Texture& texture) {
+            TextureRendererMap::const_iterator it = m_textures.find(&texture);
+            if (it != m_textures.end())
+                return it->second;
+            
+            // textures which are missing from the wad are remembered as NULL
+            TextureRenderer* textureRenderer = NULL;
+            Color averageColor;
+            if (m_loader->loadAverageColor(texture.name(), m_palette, averageColor)) {
+                textureRenderer = new TextureRenderer(averageColor);
+                m_decoder.enqueue(new TextureDecoder::Job(*this, *textureRenderer, *m_loader, m_palette, texture.name(), texture.width(), texture.height()));
+                m_pendingCount++;
+            }
+            
+            m_textures.insert(TextureRendererEntry(&texture, textureRenderer));
+            return textureRenderer;
+        }
+        
+        void TextureRendererCollection::textureDecoded(TextureDecoder::Job& job) {
+            if (job.rgbImage != NULL) {
+                job.textureRenderer.setImage(job.rgbImage, job.averageColor, job.width, job.height);
+                job.rgbImage = NULL;
+            }
+            
+            m_decodedCount++;
+            m_decodeTime += job.decodeTime;
+            
+            assert(m_pendingCount > 0);
+            if (--m_pendingCount == 0)
+                m_console.info("Decoded %u textures from %s in %f milliseconds", static_cast<unsigned int>(m_decodedCount), m_name.c_str(), m_decodeTime);
+        }
+        
+        void DecodedTextureHandler::execute() {
+            if (m_manager == NULL || !m_manager->handleDecodedTextures())
+                return;
+            
+            wxWindowList::compatibility_iterator node = wxTopLevelWindows.GetFirst();
+            while (node != NULL) {
+                node->GetData()->Refresh();
+                node = node->GetNext();
+            }
+        }
+
         void TextureRendererManager::clear() {
             Utility::deleteAll(m_textureCollections);
         }
 
-        TextureRendererManager::TextureRendererManager(Model::TextureManager& textureManager) :
+        TextureRendererManager::TextureRendererManager(Model::TextureManager& textureManager, Utility::Console& console) :
         m_textureManager(textureManager),
+        m_console(console),
         m_dummyTexture(new TextureRenderer()),
         m_palette(NULL),
+        m_decodedTextureHandler(new DecodedTextureHandler(*this)),
+        m_decoder(new TextureDecoder(m_decodedTextureHandler)),
         m_valid(true) {}
         
         TextureRendererManager::~TextureRendererManager() {
             clear();
+            m_decodedTextureHandler->detach();
+            delete m_decoder;
+            m_decoder = NULL;
             delete m_dummyTexture;
             m_dummyTexture = NULL;
         }
@@ -92,7 +131,7 @@ namespace TrenchBroom {
             TextureRendererCollection* rendererCollection = NULL;
             TextureRendererCollectionMap::iterator it = m_textureCollections.find(&collection);
             if (it == m_textureCollections.end()) {
-                rendererCollection = new TextureRendererCollection(collection, *m_palette);
+                rendererCollection = new TextureRendererCollection(collection, *m_palette, *m_decoder, m_console);
                 m_textureCollections[&collection] = rendererCollection;
             } else {
                 rendererCollection = it->second;
@@ -107,5 +146,18 @@ namespace TrenchBroom {
 
             return *textureRenderer;
         }
+        
+        bool TextureRendererManager::handleDecodedTextures() {
+            TextureDecoder::JobList jobs;
+            m_decoder->takeFinishedJobs(jobs);
+            
+            for (size_t i = 0; i < jobs.size(); i++) {
+                TextureDecoder::Job* job = jobs[i];
+                job->collection.textureDecoded(*job);
+                delete job;
+            }
+            
+            return !jobs.empty();
+        }
     }
 }
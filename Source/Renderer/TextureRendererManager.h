@@ -21,6 +21,12 @@
 #define __TrenchBroom__TextureRendererManager__
 
 #include "Model/Texture.h"
+#include "Model/TextureManager.h"
+#include "Renderer/Palette.h"
+#include "Renderer/TextureDecoder.h"
+#include "Utility/ExecutableEvent.h"
+#include "Utility/SharedPointer.h"
+#include "Utility/String.h"
 
 #include <map>
 
@@ -31,21 +37,56 @@ namespace TrenchBroom {
         class TextureManager;
     }
     
+    namespace Utility {
+        class Console;
+    }
+    
     namespace Renderer {
-        class Palette;
         class TextureRenderer;
+        class TextureRendererManager;
         
+        /*
+         Creates the texture renderers when they are first requested. They show the average color of their texture
+         until the texture has been decoded in the background.
+         */
         class TextureRendererCollection {
         protected:
             typedef std::map<Model::Texture*, TextureRenderer*> TextureRendererMap;
             typedef std::pair<Model::Texture*, TextureRenderer*> TextureRendererEntry;
             
+            String m_name;
+            Model::TextureCollection::LoaderPtr m_loader;
+            Palette m_palette;
+            TextureDecoder& m_decoder;
+            Utility::Console& m_console;
             TextureRendererMap m_textures;
+            
+            size_t m_pendingCount;
+            size_t m_decodedCount;
+            double m_decodeTime;
         public:
-            TextureRendererCollection(Model::TextureCollection& textureCollection, const Palette& palette);
+            TextureRendererCollection(Model::TextureCollection& textureCollection, const Palette& palette, TextureDecoder& decoder, Utility::Console& console);
             ~TextureRendererCollection();
             
-            TextureRenderer* renderer(Model::Texture& texture) const;
+            TextureRenderer* renderer(Model::Texture& texture);
+            void textureDecoded(TextureDecoder::Job& job);
+        };
+        
+        // passes the decoded textures to their renderers on the main thread and repaints all windows
+        class DecodedTextureHandler : public ExecutableEvent::Executable {
+        public:
+            typedef std::tr1::shared_ptr<DecodedTextureHandler> Ptr;
+        private:
+            TextureRendererManager* m_manager;
+        protected:
+            void execute();
+        public:
+            DecodedTextureHandler(TextureRendererManager& manager) :
+            m_manager(&manager) {}
+            
+            inline void detach() {
+                m_manager = NULL;
+            }
         };
         
         class TextureRendererManager {
@@ -54,14 +95,17 @@ namespace TrenchBroom {
             typedef std::pair<Model::TextureCollection*, TextureRendererCollection*> TextureRendererCollectionEntry;
             
             Model::TextureManager& m_textureManager;
+            Utility::Console& m_console;
             TextureRenderer* m_dummyTexture;
             Palette* m_palette;
+            DecodedTextureHandler::Ptr m_decodedTextureHandler;
+            TextureDecoder* m_decoder;
             TextureRendererCollectionMap m_textureCollections;
             bool m_valid;
 
             void clear();
         public:
-            TextureRendererManager(Model::TextureManager& textureManager);
+            TextureRendererManager(Model::TextureManager& textureManager, Utility::Console& console);
             ~TextureRendererManager();
             
             inline void setPalette(Palette& palette) {
@@ -73,6 +117,9 @@ namespace TrenchBroom {
             
             TextureRenderer& renderer(Model::Texture* texture);
             
+            // passes the textures decoded since the last call to their renderers, returns false if there were none
+            bool handleDecodedTextures();
+            
             inline void invalidate() {
                 m_valid = false;
             }
@@ -140,6 +140,7 @@ namespace TrenchBroom {
                 VboBlock* block = new VboBlock(*this, m_last->address() + m_last->capacity(), addedCapacity);
                 block->insertBetween(m_last, NULL);
                 insertFreeBlock(*block);
+                m_last = block;
             }
             
             if (m_vboId != 0) {
@@ -164,6 +165,7 @@ namespace TrenchBroom {
                 for (it = memBlocks.begin(), end = memBlocks.end(); it != end; ++it) {
                     const MemBlock& memBlock = *it;
                     memcpy(m_buffer + memBlock.start, temp + offset, memBlock.length);
+                    offset += memBlock.length;
                 }
                 
                 delete [] temp;
@@ -216,8 +218,11 @@ namespace TrenchBroom {
             memmove(m_buffer + block.address(), m_buffer + address, size);
             
             if (last != NULL) {
+                // the free list is ordered by address, too, so the block must leave it before it is moved
+                removeFreeBlock(*last);
                 last->m_address -= block.capacity();
-                resizeBlock(*last, last->capacity() + block.capacity());
+                last->m_capacity += block.capacity();
+                insertFreeBlock(*last);
             } else {
                 VboBlock* newBlock = new VboBlock(*this, previous->address() + previous->capacity(), block.capacity());
                 insertFreeBlock(*newBlock);
@@ -198,6 +198,12 @@ namespace TrenchBroom {
                 return offset + length;
             }
 
+            inline size_t clear(size_t offset, size_t length) {
+                assert(offset + length <= m_capacity);
+                memset(m_vbo.m_buffer + m_address + offset, 0, length);
+                return offset + length;
+            }
+
             inline size_t writeByte(unsigned char b, size_t offset) {
                 assert(offset < m_capacity);
                 m_vbo.m_buffer[m_address + offset] = b;
@@ -35,6 +35,9 @@ namespace TrenchBroom {
         class VertexArray : public RenderArray {
         protected:
         public:
+            typedef std::vector<GLint> IndexArray;
+            typedef std::vector<GLsizei> CountArray;
+            
             VertexArray(Vbo& vbo, GLenum primType, size_t vertexCapacity, const Attribute& attribute1, size_t padTo = 16) :
             RenderArray(vbo, primType, vertexCapacity, attribute1, padTo) {}
             
@@ -62,6 +65,23 @@ namespace TrenchBroom {
                 glDrawArrays(m_primType, 0, static_cast<GLsizei>(m_vertexCount));
                 cleanup();
             }
+            
+            inline void render(const IndexArray& indices, const CountArray& counts) {
+                assert(indices.size() == counts.size());
+                if (indices.empty())
+                    return;
+                
+                setup();
+                glMultiDrawArrays(m_primType, &indices[0], &counts[0], static_cast<GLsizei>(indices.size()));
+                cleanup();
+            }
+            
+            // requires ARB_draw_instanced
+            inline void renderInstances(unsigned int instanceCount) {
+                setup();
+                glDrawArraysInstancedARB(m_primType, 0, static_cast<GLsizei>(m_vertexCount), static_cast<GLsizei>(instanceCount));
+                cleanup();
+            }
         };
     }
 }
@@ -20,70 +20,167 @@
 #ifndef TrenchBroom_Allocator_h
 #define TrenchBroom_Allocator_h
 
+#include "Utility/SpinLock.h"
+#include "Utility/ThreadLocal.h"
+
 #include <cassert>
+#include <cstdlib>
+#include <cstring>
 #include <iostream>
 #include <limits>
+#include <new>
 #include <stack>
 #include <vector>
 
+#if defined _MSC_VER
+#include <malloc.h>
+#endif
+
 // Undefine this to prevent false positives when looking for memory leaks.
 #define _ENABLE_ALLOCATOR 1
 
 namespace TrenchBroom {
     namespace Utility {
+        template <size_t Size, size_t Candidate = 1, bool Found = (Candidate >= Size)>
+        struct PowerOfTwoAbove {
+            static const size_t Value = PowerOfTwoAbove<Size, 2 * Candidate>::Value;
+        };
+
+        template <size_t Size, size_t Candidate>
+        struct PowerOfTwoAbove<Size, Candidate, true> {
+            static const size_t Value = Candidate;
+        };
+
         template <class T, size_t PoolSize = 64, size_t BlocksPerChunk = 256>
         class Allocator {
+        public:
+            class Arena;
         private:
+            class Chunk;
+            typedef std::vector<Chunk*> ChunkList;
+            typedef std::stack<T*> Pool;
+            typedef ThreadLocalPointer<Arena> CurrentArena;
+
+            /*
+             * Chunks are aligned to their size, so the chunk that owns a block is found by masking the block's address.
+             * Each chunk also remembers its position in the list that contains it so that it can be moved between the
+             * lists in constant time.
+             */
             class Chunk {
-            private:
-                unsigned char m_firstFreeBlock;
-                unsigned char m_numFreeBlocks;
-                unsigned char m_blocks[BlocksPerChunk * sizeof(T)];
             public:
+                static const size_t HeaderSize = 64;
+                static const size_t Size = PowerOfTwoAbove<HeaderSize + BlocksPerChunk * sizeof(T)>::Value;
+                static const size_t Capacity = (Size - HeaderSize) / sizeof(T);
+            private:
+                typedef unsigned short BlockIndex;
+
+                ChunkList* m_list;
+                size_t m_listIndex;
+                Arena* m_arena;
+                BlockIndex m_firstFreeBlock;
+                BlockIndex m_numFreeBlocks;
+
+                inline unsigned char* blocks() {
+                    return reinterpret_cast<unsigned char*>(this) + HeaderSize;
+                }
+
                 Chunk() :
+                m_list(NULL),
+                m_listIndex(0),
+                m_arena(NULL),
                 m_firstFreeBlock(0),
-                m_numFreeBlocks(BlocksPerChunk - 1) {
-                    for (size_t i = 0; i < BlocksPerChunk - 1; i++)
-                        m_blocks[i * sizeof(T)] = static_cast<unsigned char>(i + 1);
+                m_numFreeBlocks(static_cast<BlockIndex>(Capacity)) {
+                    assert(sizeof(Chunk) <= HeaderSize);
+                    assert(Capacity <= std::numeric_limits<BlockIndex>::max());
+                    assert(sizeof(T) >= sizeof(BlockIndex));
+
+                    for (size_t i = 0; i < Capacity; i++) {
+                        const BlockIndex next = static_cast<BlockIndex>(i + 1);
+                        std::memcpy(blocks() + i * sizeof(T), &next, sizeof(BlockIndex));
+                    }
+                }
+            public:
+                static Chunk* create() {
+                    void* memory = NULL;
+#if defined _MSC_VER
+                    memory = _aligned_malloc(Size, Size);
+#else
+                    if (posix_memalign(&memory, Size, Size) != 0)
+                        memory = NULL;
+#endif
+                    if (memory == NULL)
+                        throw std::bad_alloc();
+                    return new (memory) Chunk();
+                }
+
+                static void destroy(Chunk* chunk) {
+                    chunk->~Chunk();
+#if defined _MSC_VER
+                    _aligned_free(chunk);
+#else
+                    free(chunk);
+#endif
+                }
+
+                static inline Chunk* owner(const T* t) {
+                    return reinterpret_cast<Chunk*>(reinterpret_cast<size_t>(t) & ~(Size - 1));
                 }
 
-                inline bool contains(const T* t) const {
-                    const unsigned char* block = reinterpret_cast<const unsigned char*>(t);
-                    if (block < m_blocks)
-                        return false;
-                    size_t offset = static_cast<size_t>(block - m_blocks);
-                    return offset < (BlocksPerChunk - 1) * sizeof(T);
+                inline ChunkList* list() const {
+                    return m_list;
+                }
+
+                inline Arena* arena() const {
+                    return m_arena;
+                }
+
+                inline void setArena(Arena* arena) {
+                    m_arena = arena;
+                }
+
+                inline void moveTo(ChunkList* list) {
+                    if (m_list != NULL) {
+                        Chunk* last = m_list->back();
+                        (*m_list)[m_listIndex] = last;
+                        last->m_listIndex = m_listIndex;
+                        m_list->pop_back();
+                    }
+
+                    m_list = list;
+                    if (m_list != NULL) {
+                        m_listIndex = m_list->size();
+                        m_list->push_back(this);
+                    }
                 }
 
                 inline T* allocate() {
-                    if (m_numFreeBlocks == 0)
-                        return NULL;
+                    assert(m_numFreeBlocks > 0);
 
-                    unsigned char* block = m_blocks + m_firstFreeBlock * sizeof(T);
-                    m_firstFreeBlock = *block;
+                    unsigned char* block = blocks() + m_firstFreeBlock * sizeof(T);
+                    std::memcpy(&m_firstFreeBlock, block, sizeof(BlockIndex));
                     m_numFreeBlocks--;
                     return reinterpret_cast<T*>(block);
                 };
 
                 inline void deallocate(T* t) {
-                    assert(m_numFreeBlocks < BlocksPerChunk - 1);
-                    assert(contains(t));
+                    assert(m_numFreeBlocks < Capacity);
+                    assert(owner(t) == this);
 
                     unsigned char* block = reinterpret_cast<unsigned char*>(t);
-                    assert(block >= m_blocks);
-                    size_t offset = static_cast<size_t>(block - m_blocks);
+                    assert(block >= blocks());
+                    size_t offset = static_cast<size_t>(block - blocks());
                     assert(offset % sizeof(T) == 0);
 
                     size_t index = offset / sizeof(T);
-                    assert(index < BlocksPerChunk);
+                    assert(index < Capacity);
 
-                    *block = m_firstFreeBlock;
-                    m_firstFreeBlock = static_cast<unsigned char>(index);
+                    std::memcpy(block, &m_firstFreeBlock, sizeof(BlockIndex));
+                    m_firstFreeBlock = static_cast<BlockIndex>(index);
                     m_numFreeBlocks++;
                 }
 
                 inline bool empty() const {
-                    return m_numFreeBlocks == BlocksPerChunk - 1;
+                    return m_numFreeBlocks == Capacity;
                 }
 
                 inline bool full() const {
@@ -91,8 +188,8 @@ namespace TrenchBroom {
                 }
             };
 
-            typedef std::vector<Chunk*> ChunkList;
-            typedef std::stack<T*> Pool;
+            // brush geometry is built on worker threads while a map is loaded
+            static SpinLock s_lock;
 
             static inline Pool& pool() {
                 static Pool p;
@@ -109,15 +206,129 @@ namespace TrenchBroom {
                 return chunks;
             }
 
-            static inline ChunkList emptyChunks() {
+            static inline ChunkList& emptyChunks() {
                 static ChunkList chunks;
                 return chunks;
             }
+
+            static Chunk* acquireChunk() {
+                {
+                    SpinLock::Guard guard(s_lock);
+                    if (!emptyChunks().empty()) {
+                        Chunk* chunk = emptyChunks().back();
+                        chunk->moveTo(NULL);
+                        return chunk;
+                    }
+                }
+                return Chunk::create();
+            }
+
+            // must be called with the lock held
+            static void releaseEmptyChunk(Chunk* chunk) {
+                if (emptyChunks().size() < 2) {
+                    chunk->moveTo(&emptyChunks());
+                } else {
+                    chunk->moveTo(NULL);
+                    Chunk::destroy(chunk);
+                }
+            }
         public:
+            /*
+             * While an arena is active, the blocks allocated on the thread that began it come from chunks that only this
+             * thread uses, so allocating and freeing them does not take the lock. Such blocks must be freed on the same
+             * thread or after the arena has ended. When it ends, the arena returns its empty chunks and hands the others
+             * over to the shared lists, so the blocks that are still alive remain valid. Arenas can be nested.
+             */
+            class Arena {
+            private:
+                Arena* m_previous;
+                ChunkList m_fullChunks;
+                ChunkList m_mixedChunks;
+            public:
+                Arena(Arena* previous) :
+                m_previous(previous) {}
+
+                ~Arena() {
+                    SpinLock::Guard guard(s_lock);
+                    while (!m_fullChunks.empty()) {
+                        Chunk* chunk = m_fullChunks.back();
+                        chunk->setArena(NULL);
+                        chunk->moveTo(&fullChunks());
+                    }
+                    while (!m_mixedChunks.empty()) {
+                        Chunk* chunk = m_mixedChunks.back();
+                        chunk->setArena(NULL);
+                        if (chunk->empty())
+                            releaseEmptyChunk(chunk);
+                        else
+                            chunk->moveTo(&mixedChunks());
+                    }
+                }
+
+                inline Arena* previous() const {
+                    return m_previous;
+                }
+
+                inline T* allocate() {
+                    Chunk* chunk = NULL;
+                    if (!m_mixedChunks.empty()) {
+                        chunk = m_mixedChunks.back();
+                    } else {
+                        chunk = acquireChunk();
+                        chunk->setArena(this);
+                        chunk->moveTo(&m_mixedChunks);
+                    }
+
+                    T* block = chunk->allocate();
+                    if (chunk->full())
+                        chunk->moveTo(&m_fullChunks);
+                    return block;
+                }
+
+                inline void deallocate(Chunk* chunk, T* t) {
+                    assert(chunk->arena() == this);
+                    chunk->deallocate(t);
+                    if (chunk->list() == &m_fullChunks)
+                        chunk->moveTo(&m_mixedChunks);
+                }
+            };
+
+            class ArenaScope {
+            public:
+                ArenaScope() {
+                    beginArena();
+                }
+
+                ~ArenaScope() {
+                    endArena();
+                }
+            };
+
+            static void beginArena() {
+#ifdef _ENABLE_ALLOCATOR
+                CurrentArena::set(new Arena(CurrentArena::get()));
+#endif
+            }
+
+            static void endArena() {
+#ifdef _ENABLE_ALLOCATOR
+                Arena* arena = CurrentArena::get();
+                assert(arena != NULL);
+                CurrentArena::set(arena->previous());
+                delete arena;
+#endif
+            }
+
 #ifdef _ENABLE_ALLOCATOR
             inline void* operator new(size_t size) {
                 assert(size == sizeof(T));
 
+                Arena* arena = CurrentArena::get();
+                if (arena != NULL)
+                    return arena->allocate();
+
+                SpinLock::Guard guard(s_lock);
+
                 if (!pool().empty()) {
                     T* t = pool().top();
                     pool().pop();
@@ -125,82 +336,57 @@ namespace TrenchBroom {
                 }
 
                 Chunk* chunk = NULL;
-                if (mixedChunks().empty()) {
-                    if (!emptyChunks().empty()) {
-                        chunk = emptyChunks().back();
-                        emptyChunks().pop_back();
-                    } else {
-                        chunk = new Chunk();
-                    }
-                } else {
+                if (!mixedChunks().empty()) {
                     chunk = mixedChunks().back();
-                    mixedChunks().pop_back();
+                } else if (!emptyChunks().empty()) {
+                    chunk = emptyChunks().back();
+                    chunk->moveTo(&mixedChunks());
+                } else {
+                    chunk = Chunk::create();
+                    chunk->moveTo(&mixedChunks());
                 }
 
-                assert(!chunk->full());
                 T* block = chunk->allocate();
-
                 if (chunk->full())
-                    fullChunks().push_back(chunk);
-                else
-                    mixedChunks().push_back(chunk);
+                    chunk->moveTo(&fullChunks());
                 return block;
             }
 
             inline void operator delete(void* block) {
+                if (block == NULL)
+                    return;
+
                 T* t = reinterpret_cast<T*>(block);
+                Chunk* chunk = Chunk::owner(t);
 
-                size_t poolSize = PoolSize;
-                if (poolSize > 0 && pool().size() < poolSize) {
-                    pool().push(t);
+                Arena* arena = chunk->arena();
+                if (arena != NULL) {
+                    arena->deallocate(chunk, t);
                     return;
                 }
 
-                typename ChunkList::reverse_iterator fullIt, fullEnd, mixedIt, mixedEnd;
-                fullIt = fullChunks().rbegin();
-                fullEnd = fullChunks().rend();
-                mixedIt = mixedChunks().rbegin();
-                mixedEnd = mixedChunks().rend();
+                SpinLock::Guard guard(s_lock);
 
-                Chunk* chunk = NULL;
-                while (fullIt < fullEnd || mixedIt < mixedEnd) {
-                    if (fullIt < fullEnd) {
-                        Chunk* fullChunk = *fullIt;
-                        if (fullChunk->contains(t)) {
-                            chunk = fullChunk;
-                            break;
-                        }
-                        ++fullIt;
-                    }
-                    if (mixedIt < mixedEnd) {
-                        Chunk* mixedChunk = *mixedIt;
-                        if (mixedChunk->contains(t)) {
-                            chunk = mixedChunk;
-                            break;
-                        }
-                        ++mixedIt;
-                    }
+                size_t poolSize = PoolSize;
+                if (poolSize > 0 && pool().size() < poolSize) {
+                    pool().push(t);
+                    return;
                 }
 
-                assert(chunk != NULL);
-
-                if (chunk->full()) {
-                    fullChunks().erase((fullIt + 1).base());
-                    mixedChunks().push_back(chunk);
-                }
+                assert(chunk->list() == &fullChunks() || chunk->list() == &mixedChunks());
 
                 chunk->deallocate(t);
-
                 if (chunk->empty()) {
-                    mixedChunks().erase((mixedIt + 1).base());
-                    if (emptyChunks().size() < 2)
-                        emptyChunks().push_back(chunk);
-                    else
-                        delete chunk;
+                    releaseEmptyChunk(chunk);
+                } else if (chunk->list() == &fullChunks()) {
+                    chunk->moveTo(&mixedChunks());
                 }
             }
 #endif
         };
+
+        template <class T, size_t PoolSize, size_t BlocksPerChunk>
+        SpinLock Allocator<T, PoolSize, BlocksPerChunk>::s_lock;
     }
 }
 
@@ -0,0 +1,56 @@
+/*
+ Copyright (C) 2010-2012 Kristian Duske
+ 
+ This file is part of TrenchBroom.
+ 
+ TrenchBroom is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+ 
+ TrenchBroom is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ 
+ You should have received a copy of the GNU General Public License
+ along with TrenchBroom.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef TrenchBroom_Atomic_h
+#define TrenchBroom_Atomic_h
+
+#if defined _MSC_VER
+#include <intrin.h>
+#pragma intrinsic(_InterlockedIncrement)
+#pragma intrinsic(_InterlockedDecrement)
+#endif
+
+namespace TrenchBroom {
+    namespace Utility {
+        /*
+         * Increments the given value atomically and returns the incremented value. Used for the id counters of map
+         * objects and faces, which are created on worker threads while a map is loaded.
+         */
+        inline long atomicIncrement(volatile long& value) {
+#if defined _MSC_VER
+            return _InterlockedIncrement(&value);
+#else
+            return __sync_add_and_fetch(&value, 1);
+#endif
+        }
+        
+        /*
+         * Decrements the given value atomically and returns the decremented value.
+         */
+        inline long atomicDecrement(volatile long& value) {
+#if defined _MSC_VER
+            return _InterlockedDecrement(&value);
+#else
+            return __sync_sub_and_fetch(&value, 1);
+#endif
+        }
+    }
+}
+
+#endif
@@ -19,9 +19,19 @@
 
 #include "CommandProcessor.h"
 
+#include "Utility/Console.h"
+#include "Utility/Preferences.h"
+
 #include <algorithm>
 #include <cassert>
 
+using namespace TrenchBroom;
+
+size_t SizedCommand::memorySize(const wxCommand* command) {
+    const SizedCommand* sizedCommand = dynamic_cast<const SizedCommand*>(command);
+    return sizedCommand != NULL ? sizedCommand->memorySize() : 0;
+}
+
 CompoundCommand::CompoundCommand(const wxString& name) :
 wxCommand(true, name) {}
 
@@ -70,9 +80,68 @@ bool CompoundCommand::Undo() {
     return true;
 }
 
+size_t CompoundCommand::memorySize() const {
+    size_t size = sizeof(CompoundCommand) + m_commands.capacity() * sizeof(wxCommand*);
+    CommandList::const_iterator it, end;
+    for (it = m_commands.begin(), end = m_commands.end(); it != end; ++it)
+        size += SizedCommand::memorySize(*it);
+    return size;
+}
+
+void CommandProcessor::limitMemorySize() {
+    Preferences::PreferenceManager& prefs = Preferences::PreferenceManager::preferences();
+    const int limitInMegabytes = prefs.getInt(Preferences::UndoMemoryLimit);
+    const size_t limit = limitInMegabytes > 0 ? static_cast<size_t>(limitInMegabytes) * 1024 * 1024 : 0;
+    
+    size_t size = memorySize();
+    size_t discardedCount = 0;
+    if (limit > 0) {
+        // the oldest commands are discarded first, but never the current one, which was just stored
+        while (size > limit && m_commands.GetCount() > 1) {
+            wxList::compatibility_iterator first = m_commands.GetFirst();
+            wxCommand* command = static_cast<wxCommand*>(first->GetData());
+            if (command == GetCurrentCommand())
+                break;
+            
+            size -= SizedCommand::memorySize(command);
+            if (command == m_block)
+                m_block = NULL;
+            m_commands.Erase(first);
+            delete command;
+            discardedCount++;
+        }
+    }
+    
+    if (m_console != NULL) {
+        // report every time the history grows by another quarter of the limit, or by 64 MB if there is no limit
+        const size_t reportStep = limit > 0 ? limit / 4 : 64 * 1024 * 1024;
+        if (size / reportStep > m_reportedMemorySize / reportStep)
+            m_console->info("Undo history uses %.1f MB in %u steps", static_cast<double>(size) / (1024.0 * 1024.0), static_cast<unsigned int>(m_commands.GetCount()));
+        if (discardedCount > 0 && !m_discarding)
+            m_console->info("Undo history reached its limit of %i MB, discarding the oldest steps", limitInMegabytes);
+    }
+    
+    m_reportedMemorySize = size;
+    m_discarding = discardedCount > 0;
+}
+
 CommandProcessor::CommandProcessor(int maxCommandLevel) :
 wxCommandProcessor(maxCommandLevel),
-m_block(NULL) {}
+m_block(NULL),
+m_console(NULL),
+m_reportedMemorySize(0),
+m_discarding(false) {}
+
+void CommandProcessor::setConsole(Utility::Console* console) {
+    m_console = console;
+}
+
+size_t CommandProcessor::memorySize() const {
+    size_t size = 0;
+    for (wxList::compatibility_iterator node = m_commands.GetFirst(); node; node = node->GetNext())
+        size += SizedCommand::memorySize(static_cast<wxCommand*>(node->GetData()));
+    return size;
+}
 
 void CommandProcessor::BeginGroup(wxCommandProcessor* wxCommandProc, const wxString& name) {
     CommandProcessor* commandProc = static_cast<CommandProcessor*>(wxCommandProc);
@@ -132,7 +201,7 @@ void CommandProcessor::EndGroup() {
         delete group;
     } else {
         if (m_groupStack.empty())
-            wxCommandProcessor::Store(group);
+            Store(group);
         else
             m_groupStack.top()->addCommand(group);
     }
@@ -154,6 +223,11 @@ void CommandProcessor::DiscardGroup() {
     delete group;
 }
 
+void CommandProcessor::Store(wxCommand* command) {
+    wxCommandProcessor::Store(command);
+    limitMemorySize();
+}
+
 bool CommandProcessor::Submit(wxCommand* command, bool storeIt) {
     if (m_groupStack.empty())
         return wxCommandProcessor::Submit(command, storeIt);
@@ -22,12 +22,34 @@
 
 #include <wx/cmdproc.h>
 
+#include <cstddef>
 #include <stack>
 #include <vector>
 
+namespace TrenchBroom {
+    namespace Utility {
+        class Console;
+    }
+}
+
 typedef std::vector<wxCommand*> CommandList;
 
-class CompoundCommand : public wxCommand {
+/*
+ * Implemented by commands that keep undo information, so that the command processor can limit the memory used by the
+ * command history.
+ */
+class SizedCommand {
+public:
+    virtual ~SizedCommand() {}
+    
+    // the number of bytes held by this command
+    virtual size_t memorySize() const = 0;
+    
+    // returns 0 for commands that do not implement this interface
+    static size_t memorySize(const wxCommand* command);
+};
+
+class CompoundCommand : public wxCommand, public SizedCommand {
 protected:
     CommandList m_commands;
 public:
@@ -41,6 +63,8 @@ public:
     
     bool Do();
     bool Undo();
+    
+    size_t memorySize() const;
 };
 
 class CommandProcessor : public wxCommandProcessor {
@@ -49,8 +73,16 @@ protected:
 
     GroupStack m_groupStack;
     wxCommand* m_block;
+    TrenchBroom::Utility::Console* m_console;
+    size_t m_reportedMemorySize;
+    bool m_discarding;
+    
+    void limitMemorySize();
 public:
     CommandProcessor(int maxCommandLevel = -1);
+    
+    void setConsole(TrenchBroom::Utility::Console* console);
+    size_t memorySize() const;
 
     static void BeginGroup(wxCommandProcessor* wxCommandProc, const wxString& name);
     static void EndGroup(wxCommandProcessor* wxCommandProc);
@@ -68,6 +100,7 @@ public:
     void RollbackGroup();
     void DiscardGroup();
     bool Submit(wxCommand* command, bool storeIt = true);
+    void Store(wxCommand* command);
 };
 
 #endif /* defined(__TrenchBroom__CommandProcessor__) */
@@ -87,9 +87,20 @@ namespace TrenchBroom {
             }
         }
 
+        void Console::flushTo(Console& console) {
+            for (unsigned int i = 0; i < m_buffer.size(); i++)
+                console.log(m_buffer[i]);
+            m_buffer.clear();
+        }
+
         void Console::log(const LogMessage& message) {
             if (message.string().empty())
                 return;
+            
+            if (m_collectOnly) {
+                m_buffer.push_back(message);
+                return;
+            }
 
             logToDebug(message);
             logToFile(message);
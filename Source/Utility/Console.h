@@ -77,15 +77,24 @@ namespace TrenchBroom {
             LogMessageList m_buffer;
             
             wxTextCtrl* m_textCtrl;
+            bool m_collectOnly;
             
             void logToDebug(const LogMessage& message);
             void logToConsole(const LogMessage& message);
             void logToFile(const LogMessage& message);
         public:
-            Console() : m_textCtrl(NULL) {}
+            Console(bool collectOnly = false) :
+            m_textCtrl(NULL),
+            m_collectOnly(collectOnly) {}
             
             void setTextCtrl(wxTextCtrl* textCtrl);
             
+            /**
+             * Logs the messages collected by this console to the given console. Consoles that only collect messages
+             * are used on worker threads, which must not touch the log file or the text control.
+             */
+            void flushTo(Console& console);
+            
             void log(const LogMessage& message);
             
             void debug(const String& message);
@@ -19,6 +19,7 @@
 
 #include "DocManager.h"
 
+#include "Model/MapDocument.h"
 #include "Utility/CommandProcessor.h"
 
 IMPLEMENT_DYNAMIC_CLASS(DocManager, wxDocManager)
@@ -35,6 +36,11 @@ wxDocument* DocManager::CreateDocument(const wxString& pathOrig, long flags) {
         newProcessor->SetRedoAccelerator(oldProcessor->GetRedoAccelerator());
         newProcessor->SetUndoAccelerator(oldProcessor->GetUndoAccelerator());
         newProcessor->SetMenuStrings();
+        
+        TrenchBroom::Model::MapDocument* mapDocument = wxDynamicCast(document, TrenchBroom::Model::MapDocument);
+        if (mapDocument != NULL)
+            newProcessor->setConsole(&mapDocument->console());
+        
         document->SetCommandProcessor(newProcessor);
         delete oldProcessor;
         
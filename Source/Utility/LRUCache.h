@@ -0,0 +1,113 @@
+/*
+ Copyright (C) 2010-2012 Kristian Duske
+ 
+ This file is part of TrenchBroom.
+ 
+ TrenchBroom is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+ 
+ TrenchBroom is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ 
+ You should have received a copy of the GNU General Public License
+ along with TrenchBroom.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef TrenchBroom_LRUCache_h
+#define TrenchBroom_LRUCache_h
+
+#include <cassert>
+#include <functional>
+#include <list>
+#include <map>
+
+namespace TrenchBroom {
+    namespace Utility {
+        /*
+         A map with a fixed capacity. When an insertion exceeds the capacity, the least recently used entry is evicted.
+         Both find and insert mark the entry as the most recently used one. The pointers returned by find are
+         invalidated by the next call to insert.
+         */
+        template <typename Key, typename Value, typename Compare = std::less<Key> >
+        class LRUCache {
+        private:
+            typedef std::list<Key> KeyList;
+            
+            class Entry {
+            public:
+                Value value;
+                typename KeyList::iterator usage;
+                
+                Entry(const Value& i_value, typename KeyList::iterator i_usage) :
+                value(i_value),
+                usage(i_usage) {}
+            };
+            
+            typedef std::map<Key, Entry, Compare> EntryMap;
+            
+            size_t m_capacity;
+            EntryMap m_entries;
+            KeyList m_usage; // most recently used first
+            
+            inline void touch(Entry& entry) {
+                if (entry.usage != m_usage.begin())
+                    m_usage.splice(m_usage.begin(), m_usage, entry.usage);
+            }
+        public:
+            LRUCache(size_t capacity) :
+            m_capacity(capacity) {
+                assert(m_capacity > 0);
+            }
+            
+            inline size_t size() const {
+                return m_entries.size();
+            }
+            
+            inline size_t capacity() const {
+                return m_capacity;
+            }
+            
+            inline Value* find(const Key& key) {
+                typename EntryMap::iterator it = m_entries.find(key);
+                if (it == m_entries.end())
+                    return NULL;
+                touch(it->second);
+                return &it->second.value;
+            }
+            
+            inline Value& insert(const Key& key, const Value& value) {
+                typename EntryMap::iterator it = m_entries.lower_bound(key);
+                if (it != m_entries.end() && !m_entries.key_comp()(key, it->first)) {
+                    it->second.value = value;
+                    touch(it->second);
+                    return it->second.value;
+                }
+                
+                if (m_entries.size() == m_capacity) {
+                    const Key& leastRecentlyUsed = m_usage.back();
+                    typename EntryMap::iterator evictIt = m_entries.find(leastRecentlyUsed);
+                    assert(evictIt != m_entries.end());
+                    if (evictIt == it)
+                        ++it;
+                    m_entries.erase(evictIt);
+                    m_usage.pop_back();
+                }
+                
+                m_usage.push_front(key);
+                it = m_entries.insert(it, typename EntryMap::value_type(key, Entry(value, m_usage.begin())));
+                return it->second.value;
+            }
+            
+            inline void clear() {
+                m_entries.clear();
+                m_usage.clear();
+            }
+        };
+    }
+}
+
+#endif
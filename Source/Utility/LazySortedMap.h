@@ -0,0 +1,170 @@
+/*
+ Copyright (C) 2010-2012 Kristian Duske
+ 
+ This file is part of TrenchBroom.
+ 
+ TrenchBroom is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+ 
+ TrenchBroom is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ 
+ You should have received a copy of the GNU General Public License
+ along with TrenchBroom.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef TrenchBroom_LazySortedMap_h
+#define TrenchBroom_LazySortedMap_h
+
+#include <algorithm>
+#include <cassert>
+#include <utility>
+#include <vector>
+
+namespace TrenchBroom {
+    namespace Utility {
+        /*
+         A map backed by a vector which is cheap to fill in bulk. New entries are appended and only sorted into place
+         when a lookup finds too many of them, so inserting many entries costs one sort instead of many tree node
+         allocations. Erased entries that are already sorted are only marked as erased and dropped by the next sort,
+         which happens once too many of them have accumulated. The pointers returned by find are invalidated by the
+         next call to insert, erase or find.
+         */
+        template <typename Key, typename Value>
+        class LazySortedMap {
+        private:
+            class Entry {
+            public:
+                Key key;
+                Value value;
+                bool erased;
+                
+                Entry(const Key& i_key, const Value& i_value) :
+                key(i_key),
+                value(i_value),
+                erased(false) {}
+            };
+            
+            typedef std::vector<Entry> EntryList;
+            
+            class CompareKeys {
+            public:
+                inline bool operator()(const Entry& lhs, const Entry& rhs) const {
+                    return lhs.key < rhs.key;
+                }
+                
+                inline bool operator()(const Entry& lhs, const Key& rhs) const {
+                    return lhs.key < rhs;
+                }
+            };
+            
+            class IsErased {
+            public:
+                inline bool operator()(const Entry& entry) const {
+                    return entry.erased;
+                }
+            };
+            
+            static const size_t MaxUnsortedEntries = 64;
+            
+            EntryList m_entries;
+            size_t m_sortedCount;
+            size_t m_erasedCount;
+            
+            inline typename EntryList::iterator sortedEnd() {
+                return m_entries.begin() + static_cast<typename EntryList::difference_type>(m_sortedCount);
+            }
+            
+            inline void sortEntries() {
+                if (m_erasedCount > 0) {
+                    // the sorted range stays sorted when the erased entries are removed
+                    typename EntryList::iterator end = std::remove_if(m_entries.begin(), sortedEnd(), IsErased());
+                    const size_t newSortedCount = static_cast<size_t>(end - m_entries.begin());
+                    m_entries.erase(end, sortedEnd());
+                    m_sortedCount = newSortedCount;
+                    m_erasedCount = 0;
+                }
+                
+                std::sort(sortedEnd(), m_entries.end(), CompareKeys());
+                std::inplace_merge(m_entries.begin(), sortedEnd(), m_entries.end(), CompareKeys());
+                m_sortedCount = m_entries.size();
+            }
+            
+            // returns the live entry with the given key or NULL
+            inline Entry* findEntry(const Key& key) {
+                typename EntryList::iterator it = std::lower_bound(m_entries.begin(), sortedEnd(), key, CompareKeys());
+                if (it != sortedEnd() && it->key == key && !it->erased)
+                    return &*it;
+                
+                for (it = sortedEnd(); it != m_entries.end(); ++it)
+                    if (it->key == key)
+                        return &*it;
+                return NULL;
+            }
+        public:
+            LazySortedMap() :
+            m_sortedCount(0),
+            m_erasedCount(0) {}
+            
+            inline bool empty() const {
+                return size() == 0;
+            }
+            
+            inline size_t size() const {
+                return m_entries.size() - m_erasedCount;
+            }
+            
+            inline void reserve(size_t capacity) {
+                m_entries.reserve(capacity);
+            }
+            
+            inline void clear() {
+                m_entries.clear();
+                m_sortedCount = 0;
+                m_erasedCount = 0;
+            }
+            
+            /*
+             The key must not be contained in the map already.
+             */
+            inline void insert(const Key& key, const Value& value) {
+                m_entries.push_back(Entry(key, value));
+            }
+            
+            inline Value* find(const Key& key) {
+                if (m_entries.size() - m_sortedCount > MaxUnsortedEntries)
+                    sortEntries();
+                
+                Entry* entry = findEntry(key);
+                return entry != NULL ? &entry->value : NULL;
+            }
+            
+            /*
+             Returns false if the key is not contained in the map.
+             */
+            inline bool erase(const Key& key) {
+                Entry* entry = findEntry(key);
+                if (entry == NULL)
+                    return false;
+                
+                if (static_cast<size_t>(entry - &m_entries.front()) >= m_sortedCount) {
+                    // unsorted entries can be replaced by the last one
+                    *entry = m_entries.back();
+                    m_entries.pop_back();
+                } else {
+                    entry->erased = true;
+                    m_erasedCount++;
+                    if (2 * m_erasedCount > m_sortedCount)
+                        sortEntries();
+                }
+                return true;
+            }
+        };
+    }
+}
+
+#endif
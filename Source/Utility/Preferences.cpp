@@ -40,6 +40,7 @@ namespace TrenchBroom {
 
         const Preference<float> InfoOverlayFadeDistance = Preference<float>(                    "Renderer/Info overlay fade distance",                          400.0f);
         const Preference<float> SelectedInfoOverlayFadeDistance = Preference<float>(            "Renderer/Selected info overlay fade distance",                 400.0f);
+        const Preference<float> EntityModelRenderDistance = Preference<float>(                  "Renderer/Entity model render distance",                        0.0f);
         const Preference<int>   RendererFontSize = Preference<int>(                             "Renderer/Font size",                                           13);
         const Preference<float> RendererBrightness = Preference<float>(                         "Renderer/Brightness",                                          1.0f);
         const Preference<float> GridAlpha = Preference<float>(                                  "Renderer/Grid Alpha",                                          0.25f);
@@ -139,6 +140,8 @@ namespace TrenchBroom {
         const Preference<int>   TextureBrowserFontSize = Preference<int>(                       "Texture browser/Font size",                                    12);
         const Preference<int>   EntityBrowserFontSize = Preference<int>(                        "Entity browser/Font size",                                     12);
         const Preference<float> TextureBrowserIconSize = Preference<float>(                     "Texture browser/Icon size",                                    1.0f);
+        const Preference<int>   UndoMemoryLimit = Preference<int>(                              "General/Undo memory limit",                                    512); // in megabytes, 0 means no limit
+        const Preference<float> OctreeLooseness = Preference<float>(                            "General/Octree looseness",                                     1.5f); // 1 disables loose octree nodes
 
 #if defined _WIN32
         const Preference<float> CameraMoveSpeed = Preference<float>(                            "Controls/Camera/Move speed",                                   0.3f);
@@ -447,6 +450,8 @@ namespace TrenchBroom {
             viewMenu->addActionItem(KeyboardShortcut(View::CommandIds::Menu::ViewSwitchToEntityTab, '1', KeyboardShortcut::SCAny, "Switch to Entity Inspector"));
             viewMenu->addActionItem(KeyboardShortcut(View::CommandIds::Menu::ViewSwitchToFaceTab, '2', KeyboardShortcut::SCAny, "Switch to Face Inspector"));
             viewMenu->addActionItem(KeyboardShortcut(View::CommandIds::Menu::ViewSwitchToViewTab, '3', KeyboardShortcut::SCAny, "Switch to View Inspector"));
+            viewMenu->addSeparator();
+            viewMenu->addActionItem(KeyboardShortcut(View::CommandIds::Menu::ViewPrintOctreeStatistics, KeyboardShortcut::SCAny, "Print Octree Statistics"));
             return menus;
         }
 
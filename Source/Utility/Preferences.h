@@ -257,6 +257,7 @@ namespace TrenchBroom {
 
         extern const Preference<float>  InfoOverlayFadeDistance;
         extern const Preference<float>  SelectedInfoOverlayFadeDistance;
+        extern const Preference<float>  EntityModelRenderDistance;
         extern const Preference<int>    RendererFontSize;
         extern const Preference<float>  RendererBrightness;
         extern const Preference<float>  GridAlpha;
@@ -358,6 +359,8 @@ namespace TrenchBroom {
         extern const Preference<float>  TextureBrowserIconSize;
 
         extern const Preference<String> QuakePath;
+        extern const Preference<int>    UndoMemoryLimit;
+        extern const Preference<float>  OctreeLooseness;
         extern const Preference<String> RendererFontName;
         extern const Preference<int>    RendererInstancingMode;
         extern const int                RendererInstancingModeAutodetect;
@@ -0,0 +1,80 @@
+/*
+ Copyright (C) 2010-2012 Kristian Duske
+ 
+ This file is part of TrenchBroom.
+ 
+ TrenchBroom is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+ 
+ TrenchBroom is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ 
+ You should have received a copy of the GNU General Public License
+ along with TrenchBroom.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef TrenchBroom_SpinLock_h
+#define TrenchBroom_SpinLock_h
+
+#if defined _MSC_VER
+#include <intrin.h>
+#pragma intrinsic(_InterlockedExchange)
+#endif
+
+namespace TrenchBroom {
+    namespace Utility {
+        /*
+         * A minimal lock for guarding very short critical sections, such as the free lists of the allocator. It does
+         * not depend on wxWidgets so that it can be used in headers that are shared with the test target. Instances with
+         * static storage duration are usable before their constructor has run because the unlocked state is zero.
+         */
+        class SpinLock {
+        private:
+            volatile long m_locked;
+
+            inline bool tryLock() {
+#if defined _MSC_VER
+                return _InterlockedExchange(&m_locked, 1) == 0;
+#else
+                return __sync_lock_test_and_set(&m_locked, 1) == 0;
+#endif
+            }
+        public:
+            class Guard {
+            private:
+                SpinLock& m_lock;
+            public:
+                Guard(SpinLock& lock) :
+                m_lock(lock) {
+                    m_lock.lock();
+                }
+
+                ~Guard() {
+                    m_lock.unlock();
+                }
+            };
+
+            SpinLock() :
+            m_locked(0) {}
+
+            inline void lock() {
+                while (!tryLock())
+                    while (m_locked != 0);
+            }
+
+            inline void unlock() {
+#if defined _MSC_VER
+                _InterlockedExchange(&m_locked, 0);
+#else
+                __sync_lock_release(&m_locked);
+#endif
+            }
+        };
+    }
+}
+
+#endif
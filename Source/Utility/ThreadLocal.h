@@ -0,0 +1,86 @@
+/*
+ Copyright (C) 2010-2012 Kristian Duske
+ 
+ This file is part of TrenchBroom.
+ 
+ TrenchBroom is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+ 
+ TrenchBroom is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ 
+ You should have received a copy of the GNU General Public License
+ along with TrenchBroom.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef TrenchBroom_ThreadLocal_h
+#define TrenchBroom_ThreadLocal_h
+
+#include <cstddef>
+
+#if defined __APPLE__
+#include <pthread.h>
+#endif
+
+namespace TrenchBroom {
+    namespace Utility {
+        /*
+         * Stores one pointer per thread and type. The compiler's thread local storage is used where it is available,
+         * Apple's toolchain does not support it, so POSIX thread specific data is used there. Like SpinLock, this does
+         * not depend on wxWidgets.
+         */
+        template <typename T>
+        class ThreadLocalPointer {
+        private:
+#if defined __APPLE__
+            static pthread_key_t createKey() {
+                pthread_key_t key;
+                pthread_key_create(&key, NULL);
+                return key;
+            }
+
+            static inline pthread_key_t key() {
+                static pthread_key_t k = createKey();
+                return k;
+            }
+        public:
+            static inline T* get() {
+                return static_cast<T*>(pthread_getspecific(key()));
+            }
+
+            static inline void set(T* value) {
+                pthread_setspecific(key(), value);
+            }
+#else
+#if defined _MSC_VER
+            static __declspec(thread) T* s_value;
+#else
+            static __thread T* s_value;
+#endif
+        public:
+            static inline T* get() {
+                return s_value;
+            }
+
+            static inline void set(T* value) {
+                s_value = value;
+            }
+#endif
+        };
+
+#if !defined __APPLE__
+        template <typename T>
+#if defined _MSC_VER
+        __declspec(thread) T* ThreadLocalPointer<T>::s_value = NULL;
+#else
+        __thread T* ThreadLocalPointer<T>::s_value = NULL;
+#endif
+#endif
+    }
+}
+
+#endif
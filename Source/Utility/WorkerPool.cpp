@@ -0,0 +1,120 @@
+/*
+ Copyright (C) 2010-2012 Kristian Duske
+ 
+ This file is part of TrenchBroom.
+ 
+ TrenchBroom is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+ 
+ TrenchBroom is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ 
+ You should have received a copy of the GNU General Public License
+ along with TrenchBroom.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "WorkerPool.h"
+
+#include <algorithm>
+#include <vector>
+
+#include <wx/thread.h>
+
+namespace TrenchBroom {
+    namespace Utility {
+        class WorkQueue {
+        private:
+            ParallelTask& m_task;
+            size_t m_count;
+            size_t m_batchSize;
+            size_t m_next;
+            wxCriticalSection m_lock;
+            
+            inline bool nextBatch(size_t& begin, size_t& end) {
+                wxCriticalSectionLocker locker(m_lock);
+                if (m_next >= m_count)
+                    return false;
+                begin = m_next;
+                end = std::min(m_count, m_next + m_batchSize);
+                m_next = end;
+                return true;
+            }
+        public:
+            WorkQueue(ParallelTask& task, size_t count, size_t batchSize) :
+            m_task(task),
+            m_count(count),
+            m_batchSize(batchSize),
+            m_next(0) {}
+            
+            inline void process() {
+                m_task.beginThread();
+                size_t begin, end;
+                while (nextBatch(begin, end))
+                    for (size_t i = begin; i < end; i++)
+                        m_task(i);
+                m_task.endThread();
+            }
+        };
+        
+        class WorkerThread : public wxThread {
+        private:
+            WorkQueue& m_queue;
+        protected:
+            ExitCode Entry() {
+                m_queue.process();
+                return 0;
+            }
+        public:
+            WorkerThread(WorkQueue& queue) :
+            wxThread(wxTHREAD_JOINABLE),
+            m_queue(queue) {}
+        };
+        
+        size_t WorkerPool::workerCount() {
+            const int cpuCount = wxThread::GetCPUCount();
+            return cpuCount > 1 ? static_cast<size_t>(cpuCount) : 1;
+        }
+        
+        void WorkerPool::run(ParallelTask& task, size_t count, size_t minCountPerThread) {
+            if (count == 0)
+                return;
+            
+            const size_t maxThreadCount = minCountPerThread > 1 ? std::max(static_cast<size_t>(1), count / minCountPerThread) : count;
+            const size_t threadCount = std::min(workerCount(), maxThreadCount);
+            if (threadCount == 1) {
+                task.beginThread();
+                for (size_t i = 0; i < count; i++)
+                    task(i);
+                task.endThread();
+                return;
+            }
+            
+            // hand out work in small batches so that uneven work loads are balanced between the threads
+            const size_t batchSize = std::max(static_cast<size_t>(1), count / (threadCount * 16));
+            WorkQueue queue(task, count, batchSize);
+            
+            std::vector<WorkerThread*> threads;
+            for (size_t i = 0; i < threadCount - 1; i++) {
+                WorkerThread* thread = new WorkerThread(queue);
+                if (thread->Create() == wxTHREAD_NO_ERROR && thread->Run() == wxTHREAD_NO_ERROR) {
+                    threads.push_back(thread);
+                } else {
+                    delete thread;
+                    break;
+                }
+            }
+            
+            // if a thread could not be started, the remaining work is done here
+            queue.process();
+            
+            for (size_t i = 0; i < threads.size(); i++) {
+                threads[i]->Wait();
+                delete threads[i];
+            }
+        }
+    }
+}
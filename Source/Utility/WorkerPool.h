@@ -0,0 +1,50 @@
+/*
+ Copyright (C) 2010-2012 Kristian Duske
+ 
+ This file is part of TrenchBroom.
+ 
+ TrenchBroom is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+ 
+ TrenchBroom is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ 
+ You should have received a copy of the GNU General Public License
+ along with TrenchBroom.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __TrenchBroom__WorkerPool__
+#define __TrenchBroom__WorkerPool__
+
+#include <cstddef>
+
+namespace TrenchBroom {
+    namespace Utility {
+        class ParallelTask {
+        public:
+            virtual ~ParallelTask() {}
+            
+            // called concurrently for different indices, must not throw
+            virtual void operator()(size_t index) = 0;
+            
+            // called on every thread that takes part before it processes its first and after it has processed its last index
+            virtual void beginThread() {}
+            virtual void endThread() {}
+        };
+        
+        class WorkerPool {
+        public:
+            static size_t workerCount();
+            
+            // calls task(i) for every i in [0, count) and returns when all calls have finished, the calling thread takes part
+            // every thread that takes part gets at least minCountPerThread indices, so that cheap tasks do not pay for starting threads
+            static void run(ParallelTask& task, size_t count, size_t minCountPerThread = 1);
+        };
+    }
+}
+
+#endif /* defined(__TrenchBroom__WorkerPool__) */
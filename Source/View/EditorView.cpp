@@ -48,6 +48,7 @@
 #include "Model/Map.h"
 #include "Model/MapDocument.h"
 #include "Model/MapObject.h"
+#include "Model/Octree.h"
 #include "Model/PointFile.h"
 #include "Model/TextureManager.h"
 #include "Renderer/Camera.h"
@@ -194,6 +195,7 @@ namespace TrenchBroom {
         EVT_MENU(CommandIds::Menu::ViewSwitchToEntityTab, EditorView::OnViewSwitchToEntityInspector)
         EVT_MENU(CommandIds::Menu::ViewSwitchToFaceTab, EditorView::OnViewSwitchToFaceInspector)
         EVT_MENU(CommandIds::Menu::ViewSwitchToViewTab, EditorView::OnViewSwitchToViewInspector)
+        EVT_MENU(CommandIds::Menu::ViewPrintOctreeStatistics, EditorView::OnViewPrintOctreeStatistics)
 
         EVT_UPDATE_UI(wxID_SAVE, EditorView::OnUpdateMenuItem)
         EVT_UPDATE_UI(wxID_UNDO, EditorView::OnUpdateMenuItem)
@@ -1717,6 +1719,10 @@ namespace TrenchBroom {
             inspector().switchToInspector(2);
         }
 
+        void EditorView::OnViewPrintOctreeStatistics(wxCommandEvent& event) {
+            mapDocument().octree().printStatistics(console());
+        }
+
         void EditorView::OnUpdateMenuItem(wxUpdateUIEvent& event) {
             AbstractApp* app = static_cast<AbstractApp*>(wxTheApp);
             if (app->preferencesFrame() != NULL) {
@@ -1974,6 +1980,7 @@ namespace TrenchBroom {
                 case CommandIds::Menu::ViewSwitchToEntityTab:
                 case CommandIds::Menu::ViewSwitchToFaceTab:
                 case CommandIds::Menu::ViewSwitchToViewTab:
+                case CommandIds::Menu::ViewPrintOctreeStatistics:
                     event.Enable(true);
                     break;
             }
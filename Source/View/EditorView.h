@@ -230,6 +230,7 @@ namespace TrenchBroom {
             void OnViewSwitchToEntityInspector(wxCommandEvent& event);
             void OnViewSwitchToFaceInspector(wxCommandEvent& event);
             void OnViewSwitchToViewInspector(wxCommandEvent& event);
+            void OnViewPrintOctreeStatistics(wxCommandEvent& event);
             
             void OnUpdateMenuItem(wxUpdateUIEvent& event);
             
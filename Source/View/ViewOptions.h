@@ -20,6 +20,7 @@
 #ifndef TrenchBroom_ViewOptions_h
 #define TrenchBroom_ViewOptions_h
 
+#include "Utility/Atomic.h"
 #include "Utility/String.h"
 
 namespace TrenchBroom {
@@ -55,6 +56,12 @@ namespace TrenchBroom {
             bool m_shadeFaces;
             bool m_useFog;
             LinkDisplayMode m_linkDisplayMode;
+            unsigned int m_filterGeneration;
+            
+            static inline unsigned int nextFilterGeneration() {
+                static volatile long currentGeneration = 0;
+                return static_cast<unsigned int>(Utility::atomicIncrement(currentGeneration));
+            }
         public:
             ViewOptions() :
             m_filterPattern(""),
@@ -73,7 +80,16 @@ namespace TrenchBroom {
             m_renderSelection(true),
             m_shadeFaces(true),
             m_useFog(false),
-            m_linkDisplayMode(LinkDisplayLocal) {}
+            m_linkDisplayMode(LinkDisplayLocal),
+            m_filterGeneration(nextFilterGeneration()) {}
+
+            /**
+             * Changes whenever an option changes that affects which objects are visible, so that filters can cache
+             * their results per object.
+             */
+            inline unsigned int filterGeneration() const {
+                return m_filterGeneration;
+            }
 
             inline const String& filterPattern() const {
                 return m_filterPattern;
@@ -81,6 +97,7 @@ namespace TrenchBroom {
 
             inline void setFilterPattern(const String& filterPattern) {
                 m_filterPattern = Utility::trim(filterPattern);
+                m_filterGeneration = nextFilterGeneration();
             }
 
             inline bool showEntities() const {
@@ -89,6 +106,7 @@ namespace TrenchBroom {
 
             inline void setShowEntities(bool showEntities) {
                 m_showEntities = showEntities;
+                m_filterGeneration = nextFilterGeneration();
             }
 
             inline bool showEntityModels() const {
@@ -121,6 +139,7 @@ namespace TrenchBroom {
 
             inline void setShowBrushes(bool showBrushes) {
                 m_showBrushes = showBrushes;
+                m_filterGeneration = nextFilterGeneration();
             }
 
             inline bool showClipBrushes() const {
@@ -129,6 +148,7 @@ namespace TrenchBroom {
 
             inline void setShowClipBrushes(bool showClipBrushes) {
                 m_showClipBrushes = showClipBrushes;
+                m_filterGeneration = nextFilterGeneration();
             }
 
             inline bool showSkipBrushes() const {
@@ -137,6 +157,7 @@ namespace TrenchBroom {
 
             inline void setShowSkipBrushes(bool showSkipBrushes) {
                 m_showSkipBrushes = showSkipBrushes;
+                m_filterGeneration = nextFilterGeneration();
             }
 
             inline bool showHintBrushes() const {
@@ -145,6 +166,7 @@ namespace TrenchBroom {
             
             inline void setShowHintBrushes(bool showHintBrushes) {
                 m_showHintBrushes = showHintBrushes;
+                m_filterGeneration = nextFilterGeneration();
             }
             
             inline bool showLiquidBrushes() const {
@@ -153,6 +175,7 @@ namespace TrenchBroom {
             
             inline void setShowLiquidBrushes(bool showLiquidBrushes) {
                 m_showLiquidBrushes = showLiquidBrushes;
+                m_filterGeneration = nextFilterGeneration();
             }
             
             inline bool showTriggerBrushes() const {
@@ -161,6 +184,7 @@ namespace TrenchBroom {
             
             inline void setShowTriggerBrushes(bool showTriggerBrushes) {
                 m_showTriggerBrushes = showTriggerBrushes;
+                m_filterGeneration = nextFilterGeneration();
             }
             
             inline FaceRenderMode faceRenderMode() const {
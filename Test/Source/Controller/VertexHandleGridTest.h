@@ -0,0 +1,106 @@
+/*
+ Copyright (C) 2010-2012 Kristian Duske
+ 
+ This file is part of TrenchBroom.
+ 
+ TrenchBroom is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+ 
+ TrenchBroom is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ 
+ You should have received a copy of the GNU General Public License
+ along with TrenchBroom.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef TrenchBroom_VertexHandleGridTest_h
+#define TrenchBroom_VertexHandleGridTest_h
+
+#include "TestSuite.h"
+#include "Controller/VertexHandleGrid.h"
+#include "Utility/VecMath.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstdlib>
+
+using namespace TrenchBroom::VecMath;
+
+namespace TrenchBroom {
+    namespace Controller {
+        class VertexHandleGridTest : public TestSuite<VertexHandleGridTest> {
+        private:
+            float random(float min, float max) {
+                return min + (max - min) * static_cast<float>(std::rand()) / static_cast<float>(RAND_MAX);
+            }
+            
+            bool contains(const Vec3f::List& positions, const Vec3f& position) {
+                return std::find(positions.begin(), positions.end(), position) != positions.end();
+            }
+        protected:
+            void registerTestCases() {
+                registerTestCase(&VertexHandleGridTest::testFindCandidates);
+                registerTestCase(&VertexHandleGridTest::testRemove);
+            }
+        public:
+            void testFindCandidates() {
+                const float handleRadius = 2.0f * 3.0f;
+                const float scalingFactor = 1.0f / 300.0f;
+                const float maxDistance = 1000.0f;
+                
+                std::srand(1);
+                VertexHandleGrid grid;
+                Vec3f::List positions;
+                for (size_t i = 0; i < 2000; i++) {
+                    const Vec3f position(random(-1024.0f, 1024.0f), random(-1024.0f, 1024.0f), random(-1024.0f, 1024.0f));
+                    positions.push_back(position);
+                    grid.add(position);
+                }
+                
+                for (size_t i = 0; i < 200; i++) {
+                    // aim at a handle so that every ray hits something
+                    const Vec3f origin(random(-1024.0f, 1024.0f), random(-1024.0f, 1024.0f), random(-1024.0f, 1024.0f));
+                    const Vec3f& target = positions[i];
+                    const Rayf ray(origin, (target - origin).normalized());
+                    
+                    Vec3f::List candidates;
+                    grid.findCandidates(ray, maxDistance, handleRadius * scalingFactor * maxDistance, candidates);
+                    assert(candidates.size() < positions.size());
+                    
+                    for (size_t j = 0; j < positions.size(); j++) {
+                        const float distance = ray.intersectWithSphere(positions[j], handleRadius, scalingFactor, maxDistance);
+                        if (!Math<float>::isnan(distance))
+                            assert(contains(candidates, positions[j]));
+                    }
+                }
+            }
+            
+            void testRemove() {
+                VertexHandleGrid grid;
+                const Vec3f first(1.0f, 2.0f, 3.0f);
+                const Vec3f second(2.0f, 3.0f, 4.0f);
+                grid.add(first);
+                grid.add(second);
+                grid.remove(first);
+                grid.remove(first);
+                
+                const Rayf ray(Vec3f(-32.0f, 2.0f, 3.0f), Vec3f::PosX);
+                Vec3f::List candidates;
+                grid.findCandidates(ray, 1000.0f, 8.0f, candidates);
+                assert(candidates.size() == 1);
+                assert(candidates[0] == second);
+                
+                grid.remove(second);
+                candidates.clear();
+                grid.findCandidates(ray, 1000.0f, 8.0f, candidates);
+                assert(candidates.empty());
+            }
+        };
+    }
+}
+
+#endif
@@ -0,0 +1,160 @@
+/*
+ Copyright (C) 2010-2012 Kristian Duske
+ 
+ This file is part of TrenchBroom.
+ 
+ TrenchBroom is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+ 
+ TrenchBroom is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ 
+ You should have received a copy of the GNU General Public License
+ along with TrenchBroom.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef TrenchBroom_MapSerializerTest_h
+#define TrenchBroom_MapSerializerTest_h
+
+#include "TestSuite.h"
+#include "IO/MapSerializer.h"
+#include "Model/Face.h"
+#include "Utility/VecMath.h"
+
+#include <cassert>
+#include <cstdio>
+#include <cstring>
+#include <sstream>
+
+#if defined _MSC_VER
+#include <cstdint>
+#elif defined __GNUC__
+#include <stdint.h>
+#endif
+
+using namespace TrenchBroom::VecMath;
+
+namespace TrenchBroom {
+    namespace IO {
+        class MapSerializerTest : public TestSuite<MapSerializerTest> {
+        private:
+            BBoxf m_worldBounds;
+            
+            String printFloat(const char* format, float value, int precision) {
+                char str[256];
+                std::sprintf(str, format, precision, static_cast<double>(value));
+                return str;
+            }
+            
+            void assertFloat(float value) {
+                String buffer;
+                MapSerializer::writeFloat(value, MapSerializer::PointPrecision, buffer);
+                assert(buffer == printFloat("%.*g", value, MapSerializer::PointPrecision));
+                
+                buffer.clear();
+                MapSerializer::writeFloat(value, MapSerializer::TexturePrecision, buffer);
+                assert(buffer == printFloat("%.*g", value, MapSerializer::TexturePrecision));
+            }
+            
+            // the face line as written by fprintf in MapWriter::writeFace before the serializer was introduced
+            String printfFace(const Model::Face& face) {
+                const char* format = "( %.100g %.100g %.100g ) ( %.100g %.100g %.100g ) ( %.100g %.100g %.100g ) %s %.6g %.6g %.6g %.6g %.6g\n";
+                char str[4096];
+                std::sprintf(str, format,
+                             face.point(0).x(), face.point(0).y(), face.point(0).z(),
+                             face.point(1).x(), face.point(1).y(), face.point(1).z(),
+                             face.point(2).x(), face.point(2).y(), face.point(2).z(),
+                             face.textureName().c_str(),
+                             face.xOffset(), face.yOffset(), face.rotation(), face.xScale(), face.yScale());
+                return str;
+            }
+            
+            // the face line as written to streams in MapWriter::writeFace before the serializer was introduced
+            String streamFace(const Model::Face& face) {
+                StringStream stream;
+                stream.unsetf(std::ios::floatfield);
+                stream.precision(100);
+                stream <<
+                "( " << face.point(0).x() << " " << face.point(0).y() << " " << face.point(0).z() <<
+                " ) ( " << face.point(1).x() << " " << face.point(1).y() << " " << face.point(1).z() <<
+                " ) ( " << face.point(2).x() << " " << face.point(2).y() << " " << face.point(2).z() <<
+                " ) ";
+                stream.precision(6);
+                stream <<
+                face.textureName() << " " <<
+                face.xOffset() << " " <<
+                face.yOffset() << " " <<
+                face.rotation() << " " <<
+                face.xScale() << " " <<
+                face.yScale() << "\n";
+                return stream.str();
+            }
+        protected:
+            void registerTestCases() {
+                m_worldBounds = BBoxf(Vec3f(-16384.0f, -16384.0f, -16384.0f), Vec3f(16384.0f, 16384.0f, 16384.0f));
+                
+                registerTestCase(&MapSerializerTest::testWriteFloat);
+                registerTestCase(&MapSerializerTest::testWriteRandomFloats);
+                registerTestCase(&MapSerializerTest::testWriteFace);
+            }
+        public:
+            void testWriteFloat() {
+                for (int i = -70000; i <= 70000; i += 7)
+                    assertFloat(static_cast<float>(i));
+                for (int i = -4096; i <= 4096; i++)
+                    assertFloat(static_cast<float>(i) / 64.0f);
+                
+                assertFloat(0.0f);
+                assertFloat(-0.0f);
+                assertFloat(0.1f);
+                assertFloat(-0.3f);
+                assertFloat(1.0f / 3.0f);
+                assertFloat(0.0001f);
+                assertFloat(0.00009f);
+                assertFloat(0.0001220703125f);
+                assertFloat(12345.5f);
+                assertFloat(999999.5f);
+                assertFloat(1000000.0f);
+                assertFloat(1234567.0f);
+                assertFloat(4294967296.0f);
+                assertFloat(1e20f);
+                assertFloat(-3.4e38f);
+                assertFloat(1e-40f);
+            }
+            
+            void testWriteRandomFloats() {
+                uint32_t state = 1;
+                for (size_t i = 0; i < 100000; i++) {
+                    state = state * 1664525u + 1013904223u;
+                    
+                    // random bit patterns cover all magnitudes, scaled values cover typical coordinates
+                    float value;
+                    std::memcpy(&value, &state, sizeof(value));
+                    if (value == value)
+                        assertFloat(value);
+                    assertFloat(static_cast<float>(static_cast<int32_t>(state)) / 262144.0f);
+                }
+            }
+            
+            void testWriteFace() {
+                Model::Face face(m_worldBounds, false, Vec3f(0.0f, 0.0f, 32.0f), Vec3f(0.0f, 1.5f, 32.0f), Vec3f(-1.0f / 3.0f, 0.0f, 32.0f), "base_wall");
+                face.setXOffset(16.0f);
+                face.setYOffset(-0.1f);
+                face.setRotation(45.0f);
+                face.setXScale(0.5f);
+                face.setYScale(-1.0f);
+                
+                String buffer;
+                MapSerializer::writeFace(face, buffer);
+                assert(buffer == printfFace(face));
+                assert(buffer == streamFace(face));
+            }
+        };
+    }
+}
+
+#endif
@@ -0,0 +1,100 @@
+/*
+ Copyright (C) 2010-2012 Kristian Duske
+ 
+ This file is part of TrenchBroom.
+ 
+ TrenchBroom is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+ 
+ TrenchBroom is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ 
+ You should have received a copy of the GNU General Public License
+ along with TrenchBroom.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef TrenchBroom_TokenTest_h
+#define TrenchBroom_TokenTest_h
+
+#include "TestSuite.h"
+#include "IO/StreamTokenizer.h"
+
+#include <cassert>
+#include <cstdlib>
+#include <cstring>
+
+namespace TrenchBroom {
+    namespace IO {
+        class TokenTest : public TestSuite<TokenTest> {
+        protected:
+            void registerTestCases() {
+                registerTestCase(&TokenTest::testToFloat);
+                registerTestCase(&TokenTest::testToInteger);
+                registerTestCase(&TokenTest::testEquals);
+            }
+
+            Token token(const char* str) {
+                return Token(0, str, str + std::strlen(str), 0, 1, 1);
+            }
+
+            void assertFloat(const char* str) {
+                const float expected = static_cast<float>(std::atof(str));
+                const float actual = token(str).toFloat();
+                assert(std::memcmp(&expected, &actual, sizeof(float)) == 0);
+            }
+        public:
+            void testToFloat() {
+                assertFloat("0");
+                assertFloat("-0");
+                assertFloat("1");
+                assertFloat("-128");
+                assertFloat("0.5");
+                assertFloat(".25");
+                assertFloat("-.75");
+                assertFloat("3.14159265358979");
+                assertFloat("-1024.000000");
+                assertFloat("0.1");
+                assertFloat("123456789.123456789");
+                assertFloat("1e10");
+                assertFloat("2.5e-3");
+                assertFloat("-7.0e+2");
+                assertFloat("1e-30");
+                assertFloat("0.000000000000000000000000001");
+                assertFloat("1e");
+                assertFloat("abc");
+                assertFloat("12abc");
+
+                char buffer[32];
+                std::srand(0);
+                for (size_t i = 0; i < 10000; i++) {
+                    const int integral = std::rand() % 65536 - 32768;
+                    const int fraction = std::rand() % 1000000;
+                    std::sprintf(buffer, "%d.%06d", integral, fraction);
+                    assertFloat(buffer);
+                }
+            }
+
+            void testToInteger() {
+                assert(token("0").toInteger() == 0);
+                assert(token("42").toInteger() == 42);
+                assert(token("-4096").toInteger() == -4096);
+                assert(token("+17").toInteger() == 17);
+                assert(token(" 12").toInteger() == 12);
+                assert(token("12.5").toInteger() == 12);
+            }
+
+            void testEquals() {
+                assert(token("__TB_empty").equals("__TB_empty"));
+                assert(!token("__TB_empty").equals("__TB_emptyx"));
+                assert(!token("__TB_emptyx").equals("__TB_empty"));
+                assert(token("").equals(""));
+            }
+        };
+    }
+}
+
+#endif
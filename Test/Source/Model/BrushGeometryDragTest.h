@@ -0,0 +1,135 @@
+/*
+ Copyright (C) 2010-2012 Kristian Duske
+ 
+ This file is part of TrenchBroom.
+ 
+ TrenchBroom is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+ 
+ TrenchBroom is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ 
+ You should have received a copy of the GNU General Public License
+ along with TrenchBroom.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef TrenchBroom_BrushGeometryDragTest_h
+#define TrenchBroom_BrushGeometryDragTest_h
+
+#include "TestSuite.h"
+#include "Model/BrushGeometry.h"
+#include "Model/Face.h"
+#include "Utility/VecMath.h"
+
+#include <algorithm>
+#include <cassert>
+#include <ctime>
+#include <iostream>
+
+using namespace TrenchBroom::VecMath;
+
+namespace TrenchBroom {
+    namespace Model {
+        /*
+         * Measures dragging one vertex of each of 500 selected brushes. Like MoveVerticesCommand, every drag event
+         * checks all brushes first and then moves the vertices.
+         */
+        class BrushGeometryDragTest : public TestSuite<BrushGeometryDragTest> {
+        private:
+            static const size_t BrushCount = 500;
+            static const size_t EventCount = 200;
+
+            BBoxf m_worldBounds;
+            FaceList m_faces;
+            std::vector<BrushGeometry*> m_geometries;
+            Vec3f::List m_vertices;
+        protected:
+            void registerTestCases() {
+                m_worldBounds = BBoxf(Vec3f(-16384.0f, -16384.0f, -16384.0f), Vec3f(16384.0f, 16384.0f, 16384.0f));
+
+                registerTestCase(&BrushGeometryDragTest::testDragVertices);
+            }
+
+            // a cuboid of the given bounds with the edge at max x and max z cut off
+            BrushGeometry* buildWedge(const BBoxf& bounds, float cut) {
+                const Vec3f& min = bounds.min;
+                const Vec3f& max = bounds.max;
+
+                FaceList faces;
+                faces.push_back(new Face(m_worldBounds, true, min, Vec3f(min.x(), min.y(), max.z()), Vec3f(max.x(), min.y(), min.z()), ""));
+                faces.push_back(new Face(m_worldBounds, true, min, Vec3f(min.x(), max.y(), min.z()), Vec3f(min.x(), min.y(), max.z()), ""));
+                faces.push_back(new Face(m_worldBounds, true, min, Vec3f(max.x(), min.y(), min.z()), Vec3f(min.x(), max.y(), min.z()), ""));
+                faces.push_back(new Face(m_worldBounds, true, max, Vec3f(min.x(), max.y(), max.z()), Vec3f(max.x(), max.y(), min.z()), ""));
+                faces.push_back(new Face(m_worldBounds, true, max, Vec3f(max.x(), min.y(), max.z()), Vec3f(min.x(), max.y(), max.z()), ""));
+                faces.push_back(new Face(m_worldBounds, true, max, Vec3f(max.x(), max.y(), min.z()), Vec3f(max.x(), min.y(), max.z()), ""));
+                faces.push_back(new Face(m_worldBounds, true, Vec3f(max.x(), min.y(), max.z() - cut), Vec3f(max.x() - cut, min.y(), max.z()), Vec3f(max.x(), max.y(), max.z() - cut), ""));
+
+                BrushGeometry* geometry = new BrushGeometry(m_worldBounds);
+                FaceSet droppedFaces;
+                geometry->addFaces(faces, droppedFaces);
+                assert(droppedFaces.empty());
+
+                m_faces.insert(m_faces.end(), faces.begin(), faces.end());
+                return geometry;
+            }
+
+            void setup() {
+                for (size_t i = 0; i < BrushCount; i++) {
+                    const Vec3f min(128.0f * (i % 25), 128.0f * (i / 25), 0.0f);
+                    const Vec3f max = min + Vec3f(64.0f + 8.0f * (i % 3), 64.0f, 96.0f + 8.0f * (i % 5));
+                    m_geometries.push_back(buildWedge(BBoxf(min, max), 16.0f));
+                    m_vertices.push_back(Vec3f(min.x(), min.y(), max.z()));
+                }
+            }
+
+            void teardown() {
+                while (!m_geometries.empty()) delete m_geometries.back(), m_geometries.pop_back();
+                while (!m_faces.empty()) delete m_faces.back(), m_faces.pop_back();
+                m_vertices.clear();
+            }
+        public:
+            void testDragVertices() {
+                std::clock_t trialTime = 0;
+                const std::clock_t start = std::clock();
+
+                for (size_t i = 0; i < EventCount; i++) {
+                    const Vec3f delta(0.0f, 0.0f, i % 2 == 0 ? 8.0f : -8.0f);
+
+                    const std::clock_t trialStart = std::clock();
+                    bool canMove = true;
+                    for (size_t j = 0; j < BrushCount && canMove; j++)
+                        canMove = m_geometries[j]->canMoveVertices(m_worldBounds, Vec3f::List(1, m_vertices[j]), delta);
+                    trialTime += std::clock() - trialStart;
+                    assert(canMove);
+
+                    for (size_t j = 0; j < BrushCount; j++) {
+                        FaceSet newFaces;
+                        FaceSet droppedFaces;
+                        const Vec3f::List newVertices = m_geometries[j]->moveVertices(m_worldBounds, Vec3f::List(1, m_vertices[j]), delta, newFaces, droppedFaces);
+                        assert(newVertices.size() == 1);
+                        m_vertices[j] = newVertices.front();
+
+                        FaceSet::const_iterator it, end;
+                        for (it = droppedFaces.begin(), end = droppedFaces.end(); it != end; ++it) {
+                            m_faces.erase(std::remove(m_faces.begin(), m_faces.end(), *it), m_faces.end());
+                            delete *it;
+                        }
+                        m_faces.insert(m_faces.end(), newFaces.begin(), newFaces.end());
+                    }
+                }
+
+                const double totalTime = static_cast<double>(std::clock() - start) / CLOCKS_PER_SEC;
+                std::cout.setf(std::ios::fixed, std::ios::floatfield);
+                std::cout.precision(2);
+                std::cout << BrushCount << " brushes, " << EventCount << " drag events: " << 1000.0 * totalTime / EventCount << " ms per event, "
+                << 1000.0 * trialTime / CLOCKS_PER_SEC / EventCount << " ms of it in checks" << std::endl;
+            }
+        };
+    }
+}
+
+#endif
@@ -0,0 +1,328 @@
+/*
+ Copyright (C) 2010-2012 Kristian Duske
+ 
+ This file is part of TrenchBroom.
+ 
+ TrenchBroom is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+ 
+ TrenchBroom is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ 
+ You should have received a copy of the GNU General Public License
+ along with TrenchBroom.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef TrenchBroom_BrushGeometryTest_h
+#define TrenchBroom_BrushGeometryTest_h
+
+#include "TestSuite.h"
+#include "Model/BrushGeometry.h"
+#include "Model/Face.h"
+#include "Utility/VecMath.h"
+
+#include <algorithm>
+#include <cassert>
+
+using namespace TrenchBroom::VecMath;
+
+namespace TrenchBroom {
+    namespace Model {
+        class BrushGeometryTest : public TestSuite<BrushGeometryTest> {
+        private:
+            BBoxf m_worldBounds;
+        protected:
+            void registerTestCases() {
+                m_worldBounds = BBoxf(Vec3f(-16384.0f, -16384.0f, -16384.0f), Vec3f(16384.0f, 16384.0f, 16384.0f));
+                
+                registerTestCase(&BrushGeometryTest::testTranslate);
+                registerTestCase(&BrushGeometryTest::testRotate);
+                registerTestCase(&BrushGeometryTest::testMirror);
+                registerTestCase(&BrushGeometryTest::testTrialLeavesGeometryUnchanged);
+                registerTestCase(&BrushGeometryTest::testTrialMoveVertices);
+                registerTestCase(&BrushGeometryTest::testTrialMoveEdges);
+                registerTestCase(&BrushGeometryTest::testTrialMoveFaces);
+                registerTestCase(&BrushGeometryTest::testTrialSplitEdge);
+                registerTestCase(&BrushGeometryTest::testTrialSplitFace);
+            }
+            
+            // a cuboid of the given bounds with the edge at max x and max z cut off
+            FaceList wedgeFaces(const BBoxf& bounds, float cut) {
+                const Vec3f& min = bounds.min;
+                const Vec3f& max = bounds.max;
+                
+                FaceList faces;
+                faces.push_back(new Face(m_worldBounds, true, min, Vec3f(min.x(), min.y(), max.z()), Vec3f(max.x(), min.y(), min.z()), ""));
+                faces.push_back(new Face(m_worldBounds, true, min, Vec3f(min.x(), max.y(), min.z()), Vec3f(min.x(), min.y(), max.z()), ""));
+                faces.push_back(new Face(m_worldBounds, true, min, Vec3f(max.x(), min.y(), min.z()), Vec3f(min.x(), max.y(), min.z()), ""));
+                faces.push_back(new Face(m_worldBounds, true, max, Vec3f(min.x(), max.y(), max.z()), Vec3f(max.x(), max.y(), min.z()), ""));
+                faces.push_back(new Face(m_worldBounds, true, max, Vec3f(max.x(), min.y(), max.z()), Vec3f(min.x(), max.y(), max.z()), ""));
+                faces.push_back(new Face(m_worldBounds, true, max, Vec3f(max.x(), max.y(), min.z()), Vec3f(max.x(), min.y(), max.z()), ""));
+                
+                const Vec3f p1(max.x(), min.y(), max.z() - cut);
+                const Vec3f p2(max.x() - cut, min.y(), max.z());
+                const Vec3f p3(max.x(), max.y(), max.z() - cut);
+                faces.push_back(new Face(m_worldBounds, true, p1, p2, p3, ""));
+                return faces;
+            }
+            
+            BrushGeometry* buildGeometry(const FaceList& faces) {
+                BrushGeometry* geometry = new BrushGeometry(m_worldBounds);
+                FaceSet droppedFaces;
+                geometry->addFaces(faces, droppedFaces);
+                assert(droppedFaces.empty());
+                return geometry;
+            }
+            
+            void assertConsistent(const BrushGeometry& geometry) {
+                for (size_t i = 0; i < geometry.sides.size(); i++) {
+                    const Side& side = *geometry.sides[i];
+                    for (size_t j = 0; j < side.vertices.size(); j++)
+                        assert(side.edges[j]->startVertex(&side) == side.vertices[j]);
+                    
+                    // the vertices are in clockwise order when viewed from outside
+                    const Vec3f v1 = side.vertices[2]->position - side.vertices[0]->position;
+                    const Vec3f v2 = side.vertices[1]->position - side.vertices[0]->position;
+                    assert(crossed(v1, v2).dot(side.face->boundary().normal) > 0.0f);
+                }
+            }
+            
+            void assertSameGeometry(const BrushGeometry& transformed, const BrushGeometry& rebuilt) {
+                assert(transformed.vertices.size() == rebuilt.vertices.size());
+                assert(transformed.edges.size() == rebuilt.edges.size());
+                assert(transformed.sides.size() == rebuilt.sides.size());
+                
+                for (size_t i = 0; i < transformed.vertices.size(); i++)
+                    assert(findVertex(rebuilt.vertices, transformed.vertices[i]->position) != NULL);
+                for (size_t i = 0; i < transformed.edges.size(); i++) {
+                    const Edge& edge = *transformed.edges[i];
+                    assert(findEdge(rebuilt.edges, edge.start->position, edge.end->position) != NULL);
+                }
+                for (size_t i = 0; i < transformed.sides.size(); i++) {
+                    const FaceInfo info = transformed.sides[i]->info();
+                    assert(findSide(rebuilt.sides, info.vertices) != NULL);
+                }
+                
+                assert(transformed.bounds.min.equals(rebuilt.bounds.min));
+                assert(transformed.bounds.max.equals(rebuilt.bounds.max));
+                assert(transformed.center.equals(rebuilt.center));
+            }
+            
+            // transforms the geometry of a wedge and compares it to the geometry built from the transformed faces
+            void assertTransform(const Mat4f& pointTransform, const Mat4f& vectorTransform, bool invertOrientation) {
+                FaceList faces = wedgeFaces(BBoxf(Vec3f(-32.0f, 16.0f, 0.0f), Vec3f(64.0f, 48.0f, 128.0f)), 24.0f);
+                
+                BrushGeometry* transformed = buildGeometry(faces);
+                assert(transformed->vertices.size() == 10);
+                
+                for (size_t i = 0; i < faces.size(); i++)
+                    faces[i]->transform(pointTransform, vectorTransform, false, invertOrientation);
+                transformed->transform(pointTransform, invertOrientation);
+                
+                BrushGeometry* rebuilt = buildGeometry(faces);
+                assertSameGeometry(*transformed, *rebuilt);
+                assertConsistent(*transformed);
+                
+                delete rebuilt;
+                delete transformed;
+                while (!faces.empty()) delete faces.back(), faces.pop_back();
+            }
+
+            typedef enum {
+                MoveVertices,
+                MoveEdges,
+                MoveFaces,
+                SplitEdge,
+                SplitFace
+            } EditType;
+
+            // the vertex positions and face points of a geometry
+            Vec3f::List geometryPoints(const BrushGeometry& geometry) {
+                Vec3f::List points;
+                for (size_t i = 0; i < geometry.vertices.size(); i++)
+                    points.push_back(geometry.vertices[i]->position);
+                for (size_t i = 0; i < geometry.sides.size(); i++) {
+                    const Face& face = *geometry.sides[i]->face;
+                    assert(face.side() == geometry.sides[i]);
+                    for (size_t j = 0; j < 3; j++)
+                        points.push_back(face.point(j));
+                }
+                return points;
+            }
+
+            Side* findSideWithNormal(const BrushGeometry& geometry, const Vec3f& normal) {
+                for (size_t i = 0; i < geometry.sides.size(); i++)
+                    if (geometry.sides[i]->face->boundary().normal.equals(normal))
+                        return geometry.sides[i];
+                return NULL;
+            }
+
+            // the bottom edge and the face at min x of the wedge, and the vertex where they meet
+            bool canEdit(BrushGeometry& geometry, EditType type, const Vec3f& delta) {
+                const Vec3f vertex(-32.0f, 16.0f, 0.0f);
+                const EdgeInfo edge(vertex, Vec3f(-32.0f, 48.0f, 0.0f));
+                const FaceInfo face = findSideWithNormal(geometry, Vec3f::NegX)->info();
+
+                switch (type) {
+                    case MoveVertices:
+                        return geometry.canMoveVertices(m_worldBounds, Vec3f::List(1, vertex), delta);
+                    case MoveEdges:
+                        return geometry.canMoveEdges(m_worldBounds, EdgeInfoList(1, edge), delta);
+                    case MoveFaces:
+                        return geometry.canMoveFaces(m_worldBounds, FaceInfoList(1, face), delta);
+                    case SplitEdge:
+                        return geometry.canSplitEdge(m_worldBounds, edge, delta);
+                    default:
+                        return geometry.canSplitFace(m_worldBounds, face, delta);
+                }
+            }
+
+            void edit(BrushGeometry& geometry, EditType type, const Vec3f& delta, FaceSet& newFaces, FaceSet& droppedFaces) {
+                const Vec3f vertex(-32.0f, 16.0f, 0.0f);
+                const EdgeInfo edge(vertex, Vec3f(-32.0f, 48.0f, 0.0f));
+                const FaceInfo face = findSideWithNormal(geometry, Vec3f::NegX)->info();
+
+                switch (type) {
+                    case MoveVertices:
+                        geometry.moveVertices(m_worldBounds, Vec3f::List(1, vertex), delta, newFaces, droppedFaces);
+                        break;
+                    case MoveEdges:
+                        geometry.moveEdges(m_worldBounds, EdgeInfoList(1, edge), delta, newFaces, droppedFaces);
+                        break;
+                    case MoveFaces:
+                        geometry.moveFaces(m_worldBounds, FaceInfoList(1, face), delta, newFaces, droppedFaces);
+                        break;
+                    case SplitEdge:
+                        geometry.splitEdge(m_worldBounds, edge, delta, newFaces, droppedFaces);
+                        break;
+                    default:
+                        geometry.splitFace(m_worldBounds, face, delta, newFaces, droppedFaces);
+                        break;
+                }
+            }
+
+            void updateFaces(FaceList& faces, const FaceSet& newFaces, const FaceSet& droppedFaces) {
+                FaceSet::const_iterator it, end;
+                for (it = droppedFaces.begin(), end = droppedFaces.end(); it != end; ++it) {
+                    faces.erase(std::remove(faces.begin(), faces.end(), *it), faces.end());
+                    delete *it;
+                }
+                faces.insert(faces.end(), newFaces.begin(), newFaces.end());
+            }
+
+            /*
+             * Runs an edit once as it happens while dragging, where the edit commits the trial of the previous check
+             * and the trial before it had another delta, and once without a previous check. Both must yield the same
+             * geometry and face points, and the geometry must be the one built from the edited faces.
+             */
+            void assertTrialEdit(EditType type, const Vec3f& delta) {
+                const BBoxf bounds(Vec3f(-32.0f, 16.0f, 0.0f), Vec3f(64.0f, 48.0f, 128.0f));
+                FaceList draggedFaces = wedgeFaces(bounds, 24.0f);
+                FaceList editedFaces = wedgeFaces(bounds, 24.0f);
+
+                BrushGeometry* dragged = buildGeometry(draggedFaces);
+                BrushGeometry* edited = buildGeometry(editedFaces);
+
+                assert(canEdit(*dragged, type, delta / 2.0f));
+                assert(canEdit(*dragged, type, delta));
+
+                FaceSet newFaces;
+                FaceSet droppedFaces;
+                edit(*dragged, type, delta, newFaces, droppedFaces);
+                updateFaces(draggedFaces, newFaces, droppedFaces);
+
+                edit(*edited, type, delta, newFaces, droppedFaces);
+                updateFaces(editedFaces, newFaces, droppedFaces);
+
+                assertSameGeometry(*dragged, *edited);
+                assertConsistent(*dragged);
+                for (size_t i = 0; i < dragged->sides.size(); i++) {
+                    const Face& draggedFace = *dragged->sides[i]->face;
+                    const Face& editedFace = *findSide(edited->sides, dragged->sides[i]->info().vertices)->face;
+                    for (size_t j = 0; j < 3; j++)
+                        assert(draggedFace.point(j) == editedFace.point(j));
+                }
+
+                BrushGeometry* rebuilt = buildGeometry(draggedFaces);
+                assertSameGeometry(*dragged, *rebuilt);
+                delete rebuilt;
+
+                delete edited;
+                delete dragged;
+                while (!editedFaces.empty()) delete editedFaces.back(), editedFaces.pop_back();
+                while (!draggedFaces.empty()) delete draggedFaces.back(), draggedFaces.pop_back();
+            }
+        public:
+            void testTranslate() {
+                assertTransform(translationMatrix(Vec3f(16.0f, -32.0f, 8.0f)), Mat4f::Identity, false);
+                assertTransform(translationMatrix(Vec3f(-4096.0f, 1.0f, 0.0f)), Mat4f::Identity, false);
+            }
+            
+            void testRotate() {
+                const Vec3f center(8.0f, 8.0f, 0.0f);
+                for (size_t i = 0; i < 3; i++) {
+                    const Vec3f axis = i == 0 ? Vec3f::PosX : (i == 1 ? Vec3f::PosY : Vec3f::PosZ);
+                    const Mat4f vectorTransform = rotationMatrix(Math<float>::Pi / 2.0f, axis);
+                    const Mat4f pointTransform = translationMatrix(center) * vectorTransform * translationMatrix(-center);
+                    assertTransform(pointTransform, vectorTransform, false);
+                }
+            }
+            
+            void testMirror() {
+                const Vec3f center(8.0f, 8.0f, 0.0f);
+                const Mat4f vectorTransform = Mat4f::MirX;
+                const Mat4f pointTransform = translationMatrix(center) * vectorTransform * translationMatrix(-center);
+                assertTransform(pointTransform, vectorTransform, true);
+                assertTransform(translationMatrix(center) * Mat4f::MirZ * translationMatrix(-center), Mat4f::MirZ, true);
+            }
+
+            void testTrialLeavesGeometryUnchanged() {
+                FaceList faces = wedgeFaces(BBoxf(Vec3f(-32.0f, 16.0f, 0.0f), Vec3f(64.0f, 48.0f, 128.0f)), 24.0f);
+                BrushGeometry* geometry = buildGeometry(faces);
+                const Vec3f::List points = geometryPoints(*geometry);
+
+                const EditType types[] = { MoveVertices, MoveEdges, MoveFaces, SplitEdge, SplitFace };
+                for (size_t i = 0; i < 5; i++) {
+                    assert(canEdit(*geometry, types[i], Vec3f(-16.0f, 0.0f, -8.0f)));
+                    assert(geometryPoints(*geometry) == points);
+                }
+
+                // a failed trial leaves nothing to commit
+                assert(!canEdit(*geometry, MoveVertices, Vec3f(-32768.0f, 0.0f, 0.0f)));
+                assert(geometryPoints(*geometry) == points);
+
+                delete geometry;
+                while (!faces.empty()) delete faces.back(), faces.pop_back();
+            }
+
+            void testTrialMoveVertices() {
+                assertTrialEdit(MoveVertices, Vec3f(-16.0f, 0.0f, 0.0f));
+                assertTrialEdit(MoveVertices, Vec3f(-16.0f, -16.0f, -16.0f));
+            }
+
+            void testTrialMoveEdges() {
+                assertTrialEdit(MoveEdges, Vec3f(-16.0f, 0.0f, 0.0f));
+                assertTrialEdit(MoveEdges, Vec3f(0.0f, 0.0f, -16.0f));
+            }
+
+            void testTrialMoveFaces() {
+                assertTrialEdit(MoveFaces, Vec3f(-16.0f, 0.0f, 0.0f));
+                assertTrialEdit(MoveFaces, Vec3f(16.0f, 0.0f, 0.0f));
+            }
+
+            void testTrialSplitEdge() {
+                assertTrialEdit(SplitEdge, Vec3f(-8.0f, 0.0f, -8.0f));
+            }
+
+            void testTrialSplitFace() {
+                assertTrialEdit(SplitFace, Vec3f(-16.0f, 0.0f, 0.0f));
+            }
+        };
+    }
+}
+
+#endif
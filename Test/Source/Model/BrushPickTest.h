@@ -0,0 +1,167 @@
+/*
+ Copyright (C) 2010-2012 Kristian Duske
+ 
+ This file is part of TrenchBroom.
+ 
+ TrenchBroom is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+ 
+ TrenchBroom is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ 
+ You should have received a copy of the GNU General Public License
+ along with TrenchBroom.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef TrenchBroom_BrushPickTest_h
+#define TrenchBroom_BrushPickTest_h
+
+#include "TestSuite.h"
+#include "Model/Brush.h"
+#include "Model/Face.h"
+#include "Model/Filter.h"
+#include "Model/Picker.h"
+#include "Utility/List.h"
+#include "Utility/VecMath.h"
+
+#include <cassert>
+#include <cstdlib>
+
+using namespace TrenchBroom::VecMath;
+
+namespace TrenchBroom {
+    namespace Model {
+        class BrushPickTest : public TestSuite<BrushPickTest> {
+        private:
+            class TestFilter : public Filter {
+            public:
+                bool entityVisible(const Entity&) const { return true; }
+                bool entityPickable(const Entity&) const { return true; }
+                bool brushVisible(const Brush&) const { return true; }
+                bool brushPickable(const Brush&) const { return true; }
+                bool brushVerticesPickable(const Brush&) const { return true; }
+            };
+            
+            BBoxf m_worldBounds;
+            
+            float random(float min, float max) {
+                return min + (max - min) * static_cast<float>(std::rand()) / static_cast<float>(RAND_MAX);
+            }
+            
+            // a cuboid of the given bounds with the given number of its edges at max z cut off
+            Brush* createBrush(const BBoxf& bounds, size_t cutCount) {
+                const Vec3f& min = bounds.min;
+                const Vec3f& max = bounds.max;
+                const float cut = 8.0f;
+                
+                FaceList faces;
+                faces.push_back(new Face(m_worldBounds, true, min, Vec3f(min.x(), min.y(), max.z()), Vec3f(max.x(), min.y(), min.z()), ""));
+                faces.push_back(new Face(m_worldBounds, true, min, Vec3f(min.x(), max.y(), min.z()), Vec3f(min.x(), min.y(), max.z()), ""));
+                faces.push_back(new Face(m_worldBounds, true, min, Vec3f(max.x(), min.y(), min.z()), Vec3f(min.x(), max.y(), min.z()), ""));
+                faces.push_back(new Face(m_worldBounds, true, max, Vec3f(min.x(), max.y(), max.z()), Vec3f(max.x(), max.y(), min.z()), ""));
+                faces.push_back(new Face(m_worldBounds, true, max, Vec3f(max.x(), min.y(), max.z()), Vec3f(min.x(), max.y(), max.z()), ""));
+                faces.push_back(new Face(m_worldBounds, true, max, Vec3f(max.x(), max.y(), min.z()), Vec3f(max.x(), min.y(), max.z()), ""));
+                
+                if (cutCount > 0)
+                    faces.push_back(new Face(m_worldBounds, true,
+                                             Vec3f(max.x(), min.y(), max.z() - cut),
+                                             Vec3f(max.x() - cut, min.y(), max.z()),
+                                             Vec3f(max.x(), max.y(), max.z() - cut), ""));
+                if (cutCount > 1)
+                    faces.push_back(new Face(m_worldBounds, true,
+                                             Vec3f(min.x(), max.y(), max.z() - cut),
+                                             Vec3f(min.x() + cut, max.y(), max.z()),
+                                             Vec3f(min.x(), min.y(), max.z() - cut), ""));
+                
+                Brush* brush = new Brush(m_worldBounds, true, faces);
+                assert(brush->faces().size() == 6 + cutCount);
+                return brush;
+            }
+            
+            // compares the batch pick of the given brushes with picking them one at a time
+            void assertSamePick(const BrushList& brushes, const Rayf& ray) {
+                TestFilter filter;
+                PickResult batchResult;
+                Brush::pick(brushes, ray, batchResult);
+                PickResult singleResult;
+                for (size_t i = 0; i < brushes.size(); i++)
+                    brushes[i]->pick(ray, singleResult);
+                
+                const HitList batchHits = batchResult.hits(filter);
+                const HitList singleHits = singleResult.hits(filter);
+                assert(batchHits.size() == singleHits.size());
+                for (size_t i = 0; i < batchHits.size(); i++) {
+                    const FaceHit* batchHit = static_cast<const FaceHit*>(batchHits[i]);
+                    const FaceHit* singleHit = static_cast<const FaceHit*>(singleHits[i]);
+                    assert(&batchHit->face() == &singleHit->face());
+                    assert(batchHit->distance() == singleHit->distance());
+                }
+            }
+            
+            void assertSamePicks(const BrushList& brushes, const BBoxf& target) {
+                for (size_t i = 0; i < 2000; i++) {
+                    const Vec3f origin(random(-512.0f, 512.0f), random(-512.0f, 512.0f), random(-512.0f, 512.0f));
+                    const Vec3f point(random(target.min.x(), target.max.x()), random(target.min.y(), target.max.y()), random(target.min.z(), target.max.z()));
+                    assertSamePick(brushes, Rayf(origin, (point - origin).normalized()));
+                }
+            }
+            
+            BrushList createPartialBatch() {
+                BrushList brushes;
+                brushes.push_back(createBrush(BBoxf(Vec3f(-128.0f, -32.0f, -32.0f), Vec3f(-64.0f, 32.0f, 32.0f)), 0));
+                brushes.push_back(createBrush(BBoxf(Vec3f(-32.0f, -32.0f, -32.0f), Vec3f(32.0f, 32.0f, 32.0f)), 1));
+                brushes.push_back(createBrush(BBoxf(Vec3f(64.0f, -32.0f, -32.0f), Vec3f(128.0f, 32.0f, 32.0f)), 2));
+                return brushes;
+            }
+        protected:
+            void registerTestCases() {
+                m_worldBounds = BBoxf(Vec3f(-16384.0f, -16384.0f, -16384.0f), Vec3f(16384.0f, 16384.0f, 16384.0f));
+                
+                registerTestCase(&BrushPickTest::testPickPartialBatch);
+                registerTestCase(&BrushPickTest::testPickFullBatches);
+                registerTestCase(&BrushPickTest::testPickGrazingRays);
+            }
+        public:
+            void testPickPartialBatch() {
+                // fewer brushes than a batch holds and with different face counts, so that the batch has padding
+                BrushList brushes = createPartialBatch();
+                
+                std::srand(1);
+                assertSamePicks(brushes, BBoxf(Vec3f(-144.0f, -48.0f, -48.0f), Vec3f(144.0f, 48.0f, 48.0f)));
+                Utility::deleteAll(brushes);
+            }
+            
+            void testPickFullBatches() {
+                BrushList brushes;
+                for (size_t i = 0; i < 9; i++) {
+                    const Vec3f min(-288.0f + 64.0f * i, -32.0f + 8.0f * (i % 3), -32.0f);
+                    brushes.push_back(createBrush(BBoxf(min, min + Vec3f(48.0f, 48.0f, 64.0f)), i % 3));
+                }
+                
+                std::srand(2);
+                assertSamePicks(brushes, BBoxf(Vec3f(-304.0f, -48.0f, -48.0f), Vec3f(304.0f, 64.0f, 48.0f)));
+                Utility::deleteAll(brushes);
+            }
+            
+            void testPickGrazingRays() {
+                // rays along the x axis that are within or just outside of the epsilon of being parallel to the side faces
+                BrushList brushes = createPartialBatch();
+                
+                std::srand(3);
+                const float maxSlope = 2.0f * Math<float>::AlmostZero;
+                for (size_t i = 0; i < 2000; i++) {
+                    const Vec3f origin(-512.0f, random(-40.0f, 40.0f), random(-40.0f, 40.0f));
+                    const Vec3f direction(1.0f, random(-maxSlope, maxSlope), random(-maxSlope, maxSlope));
+                    assertSamePick(brushes, Rayf(origin, direction.normalized()));
+                }
+                Utility::deleteAll(brushes);
+            }
+        };
+    }
+}
+
+#endif
@@ -0,0 +1,120 @@
+/*
+ Copyright (C) 2010-2012 Kristian Duske
+ 
+ This file is part of TrenchBroom.
+ 
+ TrenchBroom is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+ 
+ TrenchBroom is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ 
+ You should have received a copy of the GNU General Public License
+ along with TrenchBroom.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef TrenchBroom_EditStateListTest_h
+#define TrenchBroom_EditStateListTest_h
+
+#include "TestSuite.h"
+#include "Model/EditStateManager.h"
+#include "Model/Face.h"
+#include "Utility/List.h"
+#include "Utility/VecMath.h"
+
+#include <cassert>
+
+using namespace TrenchBroom::VecMath;
+
+namespace TrenchBroom {
+    namespace Model {
+        class EditStateListTest : public TestSuite<EditStateListTest> {
+        private:
+            typedef EditStateList<Face> List;
+            
+            BBoxf m_worldBounds;
+            
+            Face* createFace(float z) {
+                return new Face(m_worldBounds, false, Vec3f(0.0f, 0.0f, z), Vec3f(0.0f, 1.0f, z), Vec3f(1.0f, 0.0f, z), "texture");
+            }
+        protected:
+            void registerTestCases() {
+                m_worldBounds = BBoxf(Vec3f(-16384.0f, -16384.0f, -16384.0f), Vec3f(16384.0f, 16384.0f, 16384.0f));
+                
+                registerTestCase(&EditStateListTest::testRemoveKeepsOrder);
+                registerTestCase(&EditStateListTest::testRemoveMissing);
+            }
+        public:
+            void testRemoveKeepsOrder() {
+                FaceList faces;
+                for (size_t i = 0; i < 5; i++)
+                    faces.push_back(createFace(static_cast<float>(i)));
+                
+                List list;
+                assert(list.empty());
+                for (size_t i = 0; i < faces.size(); i++)
+                    list.add(*faces[i]);
+                
+                list.remove(*faces[1]);
+                list.remove(*faces[3]);
+                assert(!list.contains(*faces[1]));
+                assert(list.contains(*faces[4]));
+                
+                const FaceList& objects = list.objects();
+                assert(objects.size() == 3);
+                assert(objects[0] == faces[0]);
+                assert(objects[1] == faces[2]);
+                assert(objects[2] == faces[4]);
+                
+                // indices are updated when the gaps are closed
+                list.remove(*faces[4]);
+                list.add(*faces[1]);
+                assert(list.objects().size() == 3);
+                assert(list.objects()[1] == faces[2]);
+                assert(list.objects()[2] == faces[1]);
+                
+                list.remove(*faces[0]);
+                list.remove(*faces[2]);
+                list.remove(*faces[1]);
+                assert(list.empty());
+                assert(list.objects().empty());
+                
+                Utility::deleteAll(faces);
+            }
+            
+            void testRemoveMissing() {
+                Face* first = createFace(0.0f);
+                Face* second = createFace(1.0f);
+                Face* third = createFace(2.0f);
+                
+                List list;
+                list.add(*first);
+                list.add(*second);
+                
+                // the third face has the same index as the first one
+                List other;
+                other.add(*third);
+                list.remove(*third);
+                assert(list.objects().size() == 2);
+                
+                list.remove(*second);
+                list.remove(*second);
+                assert(!list.empty());
+                assert(list.objects().size() == 1);
+                
+                list.clear();
+                assert(list.empty());
+                
+                delete first;
+                delete second;
+                delete third;
+            }
+        };
+    }
+}
+
+#endif
@@ -0,0 +1,76 @@
+/*
+ Copyright (C) 2010-2012 Kristian Duske
+ 
+ This file is part of TrenchBroom.
+ 
+ TrenchBroom is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+ 
+ TrenchBroom is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ 
+ You should have received a copy of the GNU General Public License
+ along with TrenchBroom.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef TrenchBroom_FaceTest_h
+#define TrenchBroom_FaceTest_h
+
+#include "TestSuite.h"
+#include "Model/Face.h"
+#include "Utility/VecMath.h"
+
+#include <cassert>
+
+using namespace TrenchBroom::VecMath;
+
+namespace TrenchBroom {
+    namespace Model {
+        class FaceTest : public TestSuite<FaceTest> {
+        private:
+            BBoxf m_worldBounds;
+            
+            void assertRestoresCopy(const Face& face) {
+                Vec3f p1, p2, p3;
+                face.getPoints(p1, p2, p3);
+                
+                Face copy(face);
+                Face restored(m_worldBounds, face.forceIntegerFacePoints(), face.faceId(), p1, p2, p3, face.textureName());
+                assert(restored.faceId() == face.faceId());
+                assert(restored.textureName() == face.textureName());
+                for (size_t i = 0; i < 3; i++)
+                    assert(restored.point(i) == copy.point(i));
+                assert(restored.boundary().normal == copy.boundary().normal);
+                assert(restored.boundary().distance == copy.boundary().distance);
+            }
+        protected:
+            void registerTestCases() {
+                m_worldBounds = BBoxf(Vec3f(-16384.0f, -16384.0f, -16384.0f), Vec3f(16384.0f, 16384.0f, 16384.0f));
+                
+                registerTestCase(&FaceTest::testRestoreFromPoints);
+            }
+        public:
+            void testRestoreFromPoints() {
+                const Mat4f rotation = rotationMatrix(Math<float>::radians(30.0f), Vec3f(1.0f, 2.0f, 3.0f).normalized());
+                for (size_t i = 0; i < 2; i++) {
+                    const bool forceIntegerFacePoints = i == 0;
+                    
+                    Face face(m_worldBounds, forceIntegerFacePoints, Vec3f(0.0f, 0.0f, 32.0f), Vec3f(0.0f, 1.0f, 32.0f), Vec3f(1.0f, 0.0f, 32.0f), "some_texture_with_a_long_name");
+                    assertRestoresCopy(face);
+                    
+                    face.transform(rotation, rotation, false, false);
+                    assertRestoresCopy(face);
+                    
+                    face.transform(translationMatrix(Vec3f(0.5f, 17.0f, -3.25f)), Mat4f::Identity, false, false);
+                    assertRestoresCopy(face);
+                }
+            }
+        };
+    }
+}
+
+#endif
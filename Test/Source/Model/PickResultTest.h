@@ -0,0 +1,147 @@
+/*
+ Copyright (C) 2010-2012 Kristian Duske
+ 
+ This file is part of TrenchBroom.
+ 
+ TrenchBroom is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+ 
+ TrenchBroom is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ 
+ You should have received a copy of the GNU General Public License
+ along with TrenchBroom.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef TrenchBroom_PickResultTest_h
+#define TrenchBroom_PickResultTest_h
+
+#include "TestSuite.h"
+#include "Model/Filter.h"
+#include "Model/MapObject.h"
+#include "Model/Octree.h"
+#include "Model/Picker.h"
+#include "Utility/VecMath.h"
+
+#include <cassert>
+
+using namespace TrenchBroom::VecMath;
+
+namespace TrenchBroom {
+    namespace Model {
+        class PickResultTest : public TestSuite<PickResultTest> {
+        private:
+            static const HitType::Type TestHitType = 1 << 12;
+            
+            class TestHit : public Hit {
+            public:
+                TestHit(float distance) :
+                Hit(TestHitType, Vec3f::Null, distance) {}
+                
+                bool pickable(Filter&) const {
+                    return true;
+                }
+            };
+            
+            // adds a hit at the given distance when it is picked
+            class TestObject : public MapObject {
+            private:
+                float m_hitDistance;
+                bool m_picked;
+                Vec3f m_center;
+                BBoxf m_bounds;
+            public:
+                TestObject(float hitDistance) :
+                m_hitDistance(hitDistance),
+                m_picked(false) {}
+                
+                inline bool picked() const {
+                    return m_picked;
+                }
+                
+                const Vec3f& center() const {
+                    return m_center;
+                }
+                
+                const BBoxf& bounds() const {
+                    return m_bounds;
+                }
+                
+                Type objectType() const {
+                    return EntityObject;
+                }
+                
+                void transform(const Mat4f&, const Mat4f&, const bool, const bool) {}
+                
+                void pick(const Rayf&, PickResult& pickResults) {
+                    m_picked = true;
+                    pickResults.add(new TestHit(m_hitDistance));
+                }
+            };
+            
+            class TestFilter : public Filter {
+            public:
+                bool entityVisible(const Entity&) const { return true; }
+                bool entityPickable(const Entity&) const { return true; }
+                bool brushVisible(const Brush&) const { return true; }
+                bool brushPickable(const Brush&) const { return true; }
+                bool brushVerticesPickable(const Brush&) const { return true; }
+            };
+        protected:
+            void registerTestCases() {
+                registerTestCase(&PickResultTest::testFirstPicksNearCandidatesOnly);
+                registerTestCase(&PickResultTest::testFirstSortsLaterHits);
+            }
+        public:
+            void testFirstPicksNearCandidatesOnly() {
+                TestObject near(12.0f);
+                TestObject middle(55.0f);
+                TestObject far(101.0f);
+                
+                RayCandidateList candidates;
+                candidates.push_back(RayCandidate(&near, 10.0f));
+                candidates.push_back(RayCandidate(&middle, 50.0f));
+                candidates.push_back(RayCandidate(&far, 100.0f));
+                
+                TestFilter filter;
+                PickResult result(Rayf(Vec3f::Null, Vec3f::PosX), candidates);
+                Hit* hit = result.first(HitType::Any, false, filter);
+                assert(hit != NULL);
+                assert(hit->distance() == 12.0f);
+                assert(near.picked());
+                assert(!middle.picked());
+                assert(!far.picked());
+                
+                assert(result.hits(HitType::Any, filter).size() == 3);
+                assert(far.picked());
+            }
+            
+            void testFirstSortsLaterHits() {
+                TestObject near(12.0f);
+                
+                RayCandidateList candidates;
+                candidates.push_back(RayCandidate(&near, 10.0f));
+                
+                // a hit that is added before the candidates are picked, such as a handle hit
+                TestFilter filter;
+                PickResult result(Rayf(Vec3f::Null, Vec3f::PosX), candidates);
+                result.add(new TestHit(30.0f));
+                
+                Hit* hit = result.first(HitType::Any, false, filter);
+                assert(hit != NULL);
+                assert(hit->distance() == 12.0f);
+                
+                const HitList hits = result.hits(HitType::Any, filter);
+                assert(hits.size() == 2);
+                assert(hits[0]->distance() == 12.0f);
+                assert(hits[1]->distance() == 30.0f);
+            }
+        };
+    }
+}
+
+#endif
@@ -0,0 +1,96 @@
+/*
+ Copyright (C) 2010-2012 Kristian Duske
+ 
+ This file is part of TrenchBroom.
+ 
+ TrenchBroom is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+ 
+ TrenchBroom is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ 
+ You should have received a copy of the GNU General Public License
+ along with TrenchBroom.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef TrenchBroom_FrustumCullerTest_h
+#define TrenchBroom_FrustumCullerTest_h
+
+#include "TestSuite.h"
+#include "Renderer/FrustumCuller.h"
+#include "Utility/VecMath.h"
+
+#include <cassert>
+
+using namespace TrenchBroom::VecMath;
+
+namespace TrenchBroom {
+    namespace Renderer {
+        class FrustumCullerTest : public TestSuite<FrustumCullerTest> {
+        protected:
+            void registerTestCases() {
+                registerTestCase(&FrustumCullerTest::testIntersects);
+                registerTestCase(&FrustumCullerTest::testObliquePlane);
+                registerTestCase(&FrustumCullerTest::testCounts);
+                registerTestCase(&FrustumCullerTest::testBucket);
+            }
+            
+            // a box shaped frustum which contains all points with -100 <= x,z <= 100
+            FrustumCuller boxCuller() {
+                return FrustumCuller(Planef(Vec3f::PosZ, 100.0f),
+                                     Planef(Vec3f::PosX, 100.0f),
+                                     Planef(Vec3f::NegZ, 100.0f),
+                                     Planef(Vec3f::NegX, 100.0f));
+            }
+        public:
+            void testIntersects() {
+                const FrustumCuller culler = boxCuller();
+                assert(culler.intersects(BBoxf(-10.0f, 5000.0f, -10.0f, 10.0f, 5010.0f, 10.0f)));
+                assert(culler.intersects(BBoxf(90.0f, 0.0f, 90.0f, 110.0f, 10.0f, 110.0f)));
+                assert(culler.intersects(BBoxf(-500.0f, 0.0f, -500.0f, 500.0f, 10.0f, 500.0f)));
+                assert(!culler.intersects(BBoxf(110.0f, 0.0f, -10.0f, 120.0f, 10.0f, 10.0f)));
+                assert(!culler.intersects(BBoxf(-10.0f, 0.0f, -120.0f, 10.0f, 10.0f, -110.0f)));
+            }
+            
+            void testObliquePlane() {
+                const Vec3f normal = Vec3f(1.0f, 1.0f, 0.0f).normalize();
+                const Planef plane(normal, Vec3f::Null);
+                const FrustumCuller culler(plane, plane, plane, plane);
+                
+                assert(culler.intersects(BBoxf(-10.0f, -10.0f, 0.0f, -1.0f, -1.0f, 1.0f)));
+                assert(culler.intersects(BBoxf(-1.0f, -1.0f, 0.0f, 10.0f, 10.0f, 1.0f)));
+                assert(culler.intersects(BBoxf(-10.0f, 5.0f, 0.0f, 0.0f, 15.0f, 1.0f)));
+                assert(!culler.intersects(BBoxf(1.0f, 1.0f, 0.0f, 10.0f, 10.0f, 1.0f)));
+                assert(!culler.intersects(BBoxf(-4.0f, 5.0f, 0.0f, 0.0f, 15.0f, 1.0f)));
+            }
+            
+            void testCounts() {
+                FrustumCuller culler = boxCuller();
+                assert(culler.visible(BBoxf(-10.0f, 0.0f, -10.0f, 10.0f, 10.0f, 10.0f)));
+                assert(!culler.visible(BBoxf(200.0f, 0.0f, 200.0f, 210.0f, 10.0f, 210.0f)));
+                assert(culler.visible(BBoxf(0.0f, 0.0f, 0.0f, 200.0f, 10.0f, 200.0f)));
+                assert(culler.drawnCount() == 2);
+                assert(culler.culledCount() == 1);
+            }
+            
+            void testBucket() {
+                const CullingBucket origin(BBoxf(0.0f, 0.0f, 0.0f, 16.0f, 16.0f, 16.0f));
+                assert(origin.x == 0 && origin.y == 0 && origin.z == 0);
+                
+                const CullingBucket negative(BBoxf(-16.0f, -4096.0f, 2040.0f, 0.0f, -4080.0f, 2064.0f));
+                assert(negative.x == -1 && negative.y == -2 && negative.z == 1);
+                
+                assert(origin == CullingBucket(BBoxf(1000.0f, 1000.0f, 1000.0f, 2000.0f, 2000.0f, 2000.0f)));
+                assert(!(origin == negative));
+                assert(negative < origin);
+                assert(!(origin < negative));
+            }
+        };
+    }
+}
+
+#endif
@@ -0,0 +1,134 @@
+/*
+ Copyright (C) 2010-2012 Kristian Duske
+ 
+ This file is part of TrenchBroom.
+ 
+ TrenchBroom is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+ 
+ TrenchBroom is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ 
+ You should have received a copy of the GNU General Public License
+ along with TrenchBroom.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef TrenchBroom_AllocatorTest_h
+#define TrenchBroom_AllocatorTest_h
+
+#include "TestSuite.h"
+#include "Utility/Allocator.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstdlib>
+#include <set>
+#include <vector>
+
+namespace TrenchBroom {
+    namespace Utility {
+        class AllocatorTest : public TestSuite<AllocatorTest> {
+        private:
+            class Block : public Allocator<Block, 16, 32> {
+            public:
+                size_t value;
+                char padding[20];
+
+                Block(size_t i_value) :
+                value(i_value) {}
+            };
+
+            typedef std::vector<Block*> BlockList;
+        protected:
+            void registerTestCases() {
+                registerTestCase(&AllocatorTest::testAllocateAndFree);
+                registerTestCase(&AllocatorTest::testFreeInRandomOrder);
+                registerTestCase(&AllocatorTest::testArena);
+            }
+
+            void allocate(BlockList& blocks, size_t count) {
+                for (size_t i = 0; i < count; i++)
+                    blocks.push_back(new Block(blocks.size()));
+            }
+
+            void assertValid(const BlockList& blocks) {
+                std::set<Block*> unique(blocks.begin(), blocks.end());
+                assert(unique.size() == blocks.size());
+                for (size_t i = 0; i < blocks.size(); i++)
+                    assert(blocks[i]->value == i);
+            }
+
+            void deleteAll(BlockList& blocks) {
+                for (size_t i = 0; i < blocks.size(); i++)
+                    delete blocks[i];
+                blocks.clear();
+            }
+        public:
+            void testAllocateAndFree() {
+                BlockList blocks;
+                allocate(blocks, 1000);
+                assertValid(blocks);
+                deleteAll(blocks);
+
+                allocate(blocks, 1000);
+                assertValid(blocks);
+                deleteAll(blocks);
+            }
+
+            void testFreeInRandomOrder() {
+                BlockList blocks;
+                allocate(blocks, 5000);
+
+                std::srand(0);
+                std::random_shuffle(blocks.begin(), blocks.end());
+                for (size_t i = 0; i < 2500; i++)
+                    delete blocks[i];
+                blocks.erase(blocks.begin(), blocks.begin() + 2500);
+
+                for (size_t i = 0; i < blocks.size(); i++)
+                    blocks[i]->value = i;
+                allocate(blocks, 2500);
+                assertValid(blocks);
+
+                std::random_shuffle(blocks.begin(), blocks.end());
+                deleteAll(blocks);
+            }
+
+            void testArena() {
+                BlockList blocks;
+                allocate(blocks, 100);
+
+                BlockList arenaBlocks;
+                {
+                    Block::ArenaScope arena;
+                    allocate(arenaBlocks, 1000);
+                    assertValid(arenaBlocks);
+
+                    // blocks from outside of the arena can be freed while it is active
+                    delete blocks.back();
+                    blocks.pop_back();
+
+                    std::srand(0);
+                    std::random_shuffle(arenaBlocks.begin(), arenaBlocks.end());
+                    for (size_t i = 0; i < 500; i++)
+                        delete arenaBlocks[i];
+                    arenaBlocks.erase(arenaBlocks.begin(), arenaBlocks.begin() + 500);
+                }
+
+                // the blocks that outlive the arena remain valid and can be freed normally
+                for (size_t i = 0; i < arenaBlocks.size(); i++)
+                    arenaBlocks[i]->value = i;
+                allocate(arenaBlocks, 500);
+                assertValid(arenaBlocks);
+                deleteAll(arenaBlocks);
+                deleteAll(blocks);
+            }
+        };
+    }
+}
+
+#endif
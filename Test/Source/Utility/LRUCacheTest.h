@@ -0,0 +1,102 @@
+/*
+ Copyright (C) 2010-2012 Kristian Duske
+ 
+ This file is part of TrenchBroom.
+ 
+ TrenchBroom is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+ 
+ TrenchBroom is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ 
+ You should have received a copy of the GNU General Public License
+ along with TrenchBroom.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef TrenchBroom_LRUCacheTest_h
+#define TrenchBroom_LRUCacheTest_h
+
+#include "TestSuite.h"
+#include "Utility/LRUCache.h"
+
+#include <cassert>
+
+namespace TrenchBroom {
+    namespace Utility {
+        class LRUCacheTest : public TestSuite<LRUCacheTest> {
+        private:
+            typedef LRUCache<int, int> Cache;
+        protected:
+            void registerTestCases() {
+                registerTestCase(&LRUCacheTest::testInsertAndFind);
+                registerTestCase(&LRUCacheTest::testEvictLeastRecentlyUsed);
+                registerTestCase(&LRUCacheTest::testReplace);
+            }
+        public:
+            void testInsertAndFind() {
+                Cache cache(4);
+                assert(cache.find(1) == NULL);
+                
+                cache.insert(1, 10);
+                cache.insert(2, 20);
+                assert(cache.size() == 2);
+                assert(*cache.find(1) == 10);
+                assert(*cache.find(2) == 20);
+                assert(cache.find(3) == NULL);
+                
+                cache.clear();
+                assert(cache.size() == 0);
+                assert(cache.find(1) == NULL);
+            }
+            
+            void testEvictLeastRecentlyUsed() {
+                Cache cache(3);
+                cache.insert(1, 10);
+                cache.insert(2, 20);
+                cache.insert(3, 30);
+                
+                // 2 becomes the least recently used entry
+                assert(cache.find(1) != NULL);
+                cache.insert(4, 40);
+                assert(cache.size() == 3);
+                assert(cache.find(2) == NULL);
+                assert(*cache.find(1) == 10);
+                assert(*cache.find(3) == 30);
+                assert(*cache.find(4) == 40);
+                
+                // evicting the entry right before the new key
+                cache.insert(0, 0);
+                assert(cache.size() == 3);
+                assert(cache.find(1) == NULL);
+                assert(*cache.find(0) == 0);
+                
+                for (int i = 100; i < 200; i++)
+                    cache.insert(i, i);
+                assert(cache.size() == 3);
+                assert(*cache.find(197) == 197);
+                assert(*cache.find(198) == 198);
+                assert(*cache.find(199) == 199);
+            }
+            
+            void testReplace() {
+                Cache cache(2);
+                cache.insert(1, 10);
+                cache.insert(2, 20);
+                cache.insert(1, 11);
+                assert(cache.size() == 2);
+                assert(*cache.find(1) == 11);
+                
+                // replacing marks the entry as recently used
+                cache.insert(3, 30);
+                assert(cache.find(2) == NULL);
+                assert(*cache.find(1) == 11);
+            }
+        };
+    }
+}
+
+#endif
@@ -0,0 +1,113 @@
+/*
+ Copyright (C) 2010-2012 Kristian Duske
+ 
+ This file is part of TrenchBroom.
+ 
+ TrenchBroom is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+ 
+ TrenchBroom is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+ 
+ You should have received a copy of the GNU General Public License
+ along with TrenchBroom.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef TrenchBroom_LazySortedMapTest_h
+#define TrenchBroom_LazySortedMapTest_h
+
+#include "TestSuite.h"
+#include "Utility/LazySortedMap.h"
+
+#include <cassert>
+
+namespace TrenchBroom {
+    namespace Utility {
+        class LazySortedMapTest : public TestSuite<LazySortedMapTest> {
+        private:
+            typedef LazySortedMap<int, int> Map;
+        protected:
+            void registerTestCases() {
+                registerTestCase(&LazySortedMapTest::testInsertAndFind);
+                registerTestCase(&LazySortedMapTest::testEraseUnsorted);
+                registerTestCase(&LazySortedMapTest::testEraseSorted);
+            }
+        public:
+            void testInsertAndFind() {
+                Map map;
+                assert(map.empty());
+                assert(map.find(1) == NULL);
+                
+                // more entries than are kept unsorted, in descending order
+                for (int i = 199; i >= 0; i--)
+                    map.insert(i, 10 * i);
+                assert(map.size() == 200);
+                for (int i = 0; i < 200; i++)
+                    assert(*map.find(i) == 10 * i);
+                assert(map.find(200) == NULL);
+                
+                map.clear();
+                assert(map.empty());
+                assert(map.find(1) == NULL);
+            }
+            
+            void testEraseUnsorted() {
+                Map map;
+                map.insert(1, 10);
+                map.insert(2, 20);
+                map.insert(3, 30);
+                
+                assert(map.erase(1));
+                assert(!map.erase(1));
+                assert(map.size() == 2);
+                assert(map.find(1) == NULL);
+                assert(*map.find(2) == 20);
+                assert(*map.find(3) == 30);
+                
+                map.insert(1, 11);
+                assert(*map.find(1) == 11);
+            }
+            
+            void testEraseSorted() {
+                Map map;
+                for (int i = 0; i < 200; i++)
+                    map.insert(i, 10 * i);
+                assert(map.find(0) != NULL); // sorts the entries
+                
+                // erased keys can be inserted again before and after the erased entries are dropped
+                assert(map.erase(10));
+                assert(map.find(10) == NULL);
+                map.insert(10, 11);
+                assert(*map.find(10) == 11);
+                
+                for (int i = 0; i < 200; i += 2)
+                    assert(map.erase(i));
+                assert(map.size() == 100);
+                for (int i = 0; i < 200; i++) {
+                    if (i % 2 == 0)
+                        assert(map.find(i) == NULL);
+                    else
+                        assert(*map.find(i) == 10 * i);
+                }
+                
+                // drops the erased entries
+                for (int i = 1; i < 200; i += 2)
+                    assert(map.erase(i));
+                assert(map.empty());
+                assert(map.find(1) == NULL);
+                
+                for (int i = 0; i < 200; i++)
+                    map.insert(i, i);
+                assert(map.size() == 200);
+                for (int i = 0; i < 200; i++)
+                    assert(*map.find(i) == i);
+            }
+        };
+    }
+}
+
+#endif
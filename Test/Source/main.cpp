@@ -20,7 +20,20 @@
 #include <iostream>
 
 #include "TestSuite.h"
+#include "Controller/VertexHandleGridTest.h"
+#include "IO/MapSerializerTest.h"
+#include "IO/TokenTest.h"
+#include "Model/BrushGeometryTest.h"
+#include "Model/BrushGeometryDragTest.h"
+#include "Model/BrushPickTest.h"
+#include "Model/EditStateListTest.h"
+#include "Model/FaceTest.h"
+#include "Model/PickResultTest.h"
+#include "Renderer/FrustumCullerTest.h"
+#include "Utility/AllocatorTest.h"
 #include "Utility/FindIntegerPlanePointsTest.h"
+#include "Utility/LazySortedMapTest.h"
+#include "Utility/LRUCacheTest.h"
 #include "Utility/MatTest.h"
 #include "Utility/PlaneTest.h"
 #include "Utility/VecTest.h"
@@ -37,9 +50,48 @@ int main(int argc, const char * argv[]) {
     VecMath::PlaneTest planeTest;
     planeTest.run();
     
+    IO::TokenTest tokenTest;
+    tokenTest.run();
+    
+    IO::MapSerializerTest mapSerializerTest;
+    mapSerializerTest.run();
+    
+    Utility::AllocatorTest allocatorTest;
+    allocatorTest.run();
+    
+    Utility::LRUCacheTest lruCacheTest;
+    lruCacheTest.run();
+    
+    Utility::LazySortedMapTest lazySortedMapTest;
+    lazySortedMapTest.run();
+    
+    Controller::VertexHandleGridTest vertexHandleGridTest;
+    vertexHandleGridTest.run();
+    
+    Model::BrushGeometryTest brushGeometryTest;
+    brushGeometryTest.run();
+    
+    Model::BrushPickTest brushPickTest;
+    brushPickTest.run();
+    
+    Model::FaceTest faceTest;
+    faceTest.run();
+    
+    Model::EditStateListTest editStateListTest;
+    editStateListTest.run();
+    
+    Model::PickResultTest pickResultTest;
+    pickResultTest.run();
+    
+    Renderer::FrustumCullerTest frustumCullerTest;
+    frustumCullerTest.run();
+    
     /*
     VecMath::FindIntegerPlanePointsTest planePointsTest;
     planePointsTest.run();
+    
+    Model::BrushGeometryDragTest brushGeometryDragTest;
+    brushGeometryDragTest.run();
     */
     
     return 0;